@@ -1,11 +1,15 @@
+#include <algorithm>
 #include <cassert>
 #include <cmath>
 #include <iostream>
+#include <memory>
 #include <random>
 #include <vector>
 
+#include "btree.hpp"
 #include "constants.hpp"
 #include "kv_store.hpp"
+#include "page_search.hpp"
 #include "utils.hpp"
 
 // Function to benchmark put operations
@@ -107,6 +111,145 @@ void benchmark_kvstore_scan(int memtable_size, int put_item_size, std::ofstream&
     kv.close();
 }
 
+// Function to compare bloom filter allocations under the same memory budget: the same bits per entry in
+// every level, or Monkey which gives shallower levels more bits. Only even keys are inserted and odd keys are
+// looked up, so every lookup has a zero result. The filter and index pages are kept in the buffer pool, so once
+// they are read every page read (buffer pool miss) is a leaf read because of a false positive.
+void benchmark_bloom_filter_allocation(int memtable_size, int num_items, double bits_per_entry, std::ofstream& file) {
+    const int num_get_operations = 1024 * 8;
+    for (bool monkey : {false, true}) {
+        // a tiny buffer pool for the leaves so that most leaf reads go to the SST files
+        KVStore kv(memtable_size, 2, 4);
+        kv.set_index_cache_capacity(1 << 16);
+        if (monkey) {
+            kv.set_filter_memory_budget(bits_per_entry * num_items);
+        } else {
+            kv.set_bloom_bits_per_entry(bits_per_entry);
+        }
+        kv.open(ExpConstants::EXP_DB_PATH + "bloom_" + (monkey ? "monkey_" : "uniform_") +
+                std::to_string((int)bits_per_entry));
+        // in random order, so that the SSTs of every level span the whole key range
+        std::mt19937 rng(ExpConstants::Clock::now().time_since_epoch().count());
+        std::vector<uint32_t> keys(num_items);
+        for (int i = 0; i < num_items; i++) {
+            keys[i] = i * 2;
+        }
+        std::shuffle(keys.begin(), keys.end(), rng);
+        for (uint32_t key : keys) {
+            kv.put(key, key);
+        }
+
+        std::uniform_int_distribution<unsigned int> dist(0, num_items - 1);
+        // reads the filter and index pages
+        for (int i = 0; i < num_get_operations; i++) {
+            kv.get(dist(rng) * 2 + 1);
+        }
+        int64_t misses_before = kv.get_buffer_pool().get_num_misses();
+        for (int i = 0; i < num_get_operations; i++) {
+            kv.get(dist(rng) * 2 + 1);
+        }
+        int64_t page_reads = kv.get_buffer_pool().get_num_misses() - misses_before;
+
+        file << (monkey ? "monkey," : "uniform,") << bits_per_entry << ","
+             << page_reads / (float)num_get_operations << std::endl;
+        kv.close();
+    }
+}
+
+// Function to compare the search kernels of a B-tree page: full pages of random keys are searched for random keys,
+// half of which are in the page. The pages fit in the CPU caches, like the hot pages held by the buffer pool.
+void benchmark_page_search(std::ofstream& file) {
+    const int num_pages = 256;
+    const int num_searches = 1024 * 1024 * 4;
+    const int n = BTreeNode::MAX_KEYS;
+
+    std::mt19937 rng(ExpConstants::Clock::now().time_since_epoch().count());
+    std::vector<uint32_t> keys(num_pages * n);
+    for (int page = 0; page < num_pages; page++) {
+        for (int i = 0; i < n; i++) {
+            keys[page * n + i] = rng();
+        }
+        std::sort(keys.begin() + page * n, keys.begin() + (page + 1) * n);
+    }
+    std::vector<std::pair<int, uint32_t>> searches(num_searches);
+    for (auto& search : searches) {
+        search.first = rng() % num_pages;
+        search.second = rng() % 2 == 0 ? keys[search.first * n + rng() % n] : rng();
+    }
+
+    // every kernel must find the same positions
+    int64_t expected_checksum = -1;
+    for (PageSearch::Kernel kernel : {PageSearch::Kernel::SCALAR, PageSearch::Kernel::AVX2,
+                                      PageSearch::Kernel::AVX512, PageSearch::Kernel::NEON}) {
+        if (!PageSearch::is_supported(kernel)) {
+            continue;
+        }
+        int64_t checksum = 0;
+        auto start_time = ExpConstants::Clock::now();
+        for (auto& search : searches) {
+            checksum += PageSearch::lower_bound(&keys[search.first * n], n, search.second, kernel);
+        }
+        auto stop_time = ExpConstants::Clock::now();
+        auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(stop_time - start_time);
+        assert(expected_checksum == -1 || checksum == expected_checksum);
+        expected_checksum = checksum;
+
+        const char* names[] = {"scalar", "avx2", "avx512", "neon"};
+        file << names[(int)kernel] << "," << duration.count() / (double)num_searches << std::endl;
+    }
+}
+
+// Point lookups within cached leaf pages, binary search against the hash index of hashed leaves
+void benchmark_leaf_hash_index(std::ofstream& file) {
+    const int num_pages = 256;
+    const int num_searches = 1024 * 1024 * 4;
+    const int n = BTreeNode::HASHED_MAX_KEYS;
+
+    std::mt19937 rng(ExpConstants::Clock::now().time_since_epoch().count());
+    std::vector<std::unique_ptr<BTreeNode>> leaves;
+    for (int page = 0; page < num_pages; page++) {
+        std::unique_ptr<BTreeNode> leaf = std::make_unique<BTreeNode>();
+        for (int i = 0; i < n; i++) {
+            leaf->keys[i] = rng();
+            leaf->values[i] = i;
+        }
+        std::sort(leaf->keys, leaf->keys + n);
+        leaf->num_keys = n;
+        leaf->build_hash_index();
+        leaves.push_back(std::move(leaf));
+    }
+    // half of the lookups are for keys that are not there
+    std::vector<std::pair<int, uint32_t>> searches(num_searches);
+    for (auto& search : searches) {
+        search.first = rng() % num_pages;
+        search.second = rng() % 2 == 0 ? leaves[search.first]->keys[rng() % n] : rng();
+    }
+
+    int64_t expected_checksum = -1;
+    for (bool use_hash_index : {false, true}) {
+        int64_t checksum = 0;
+        auto start_time = ExpConstants::Clock::now();
+        if (use_hash_index) {
+            for (auto& search : searches) {
+                checksum += leaves[search.first]->find_with_hash_index(search.second);
+            }
+        } else {
+            for (auto& search : searches) {
+                const BTreeNode* leaf = leaves[search.first].get();
+                int index = leaf->lower_bound(search.second);
+                checksum += index < leaf->num_keys && leaf->keys[index] == search.second ? index : -1;
+            }
+        }
+        auto stop_time = ExpConstants::Clock::now();
+        auto duration = std::chrono::duration_cast<std::chrono::nanoseconds>(stop_time - start_time);
+        assert(expected_checksum == -1 || checksum == expected_checksum);
+        expected_checksum = checksum;
+
+        file << (use_hash_index ? "hash_index" : "binary_search") << "," << duration.count() / (double)num_searches
+             << std::endl;
+    }
+}
+
 int main() {
     // Max number of entries in memtable (1MB)
     const int memtable_size = ExpConstants::ONE_MEGA_BYTE / Utils::ENTRY_SIZE;
@@ -147,5 +290,26 @@ int main() {
     }
     scan_file.close();
 
+    // Experiment for bloom filter allocation across levels
+    std::ofstream bloom_file("experiments/results/bloom_filter_allocation_results.csv");
+    bloom_file << "allocation,bits_per_entry,io_per_zero_result_get" << std::endl;
+    for (double bits_per_entry = 2; bits_per_entry <= 8; bits_per_entry += 2) {
+        // 127 memtables leave exactly one SST in each of levels 0 to 6, whose filters take many pages
+        benchmark_bloom_filter_allocation(4096, 4096 * 127, bits_per_entry, bloom_file);
+    }
+    bloom_file.close();
+
+    // Experiment for the search within a B-tree page
+    std::ofstream page_search_file("experiments/results/page_search_results.csv");
+    page_search_file << "kernel,ns_per_search" << std::endl;
+    benchmark_page_search(page_search_file);
+    page_search_file.close();
+
+    // Experiment for point lookups within a leaf page
+    std::ofstream leaf_hash_index_file("experiments/results/leaf_hash_index_results.csv");
+    leaf_hash_index_file << "method,ns_per_lookup" << std::endl;
+    benchmark_leaf_hash_index(leaf_hash_index_file);
+    leaf_hash_index_file.close();
+
     return 0;
 }
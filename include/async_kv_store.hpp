@@ -0,0 +1,58 @@
+#ifndef ASYNC_KV_STORE_HPP_
+#define ASYNC_KV_STORE_HPP_
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "./kv_store.hpp"
+
+// Asynchronous front-end of a KVStore: requests return a future right away and a fixed pool of threads serves
+// them, so a caller can keep many lookups outstanding (and wait on them together) without a thread of its own
+// per request. The futures hold the exceptions of failed requests.
+//
+// Reads run on any thread at once. Puts are applied in the order they were issued: the ones queued while another
+// batch is written are grouped into a single KVStore::write. A read sees the puts whose futures completed before
+// it was issued.
+class AsyncKVStore {
+   public:
+    // the store is not owned, it must be open and outlive this object
+    AsyncKVStore(KVStore *kvstore, int num_threads);
+    AsyncKVStore(const AsyncKVStore &) = delete;
+    AsyncKVStore &operator=(const AsyncKVStore &) = delete;
+    // serves the requests that are still queued, then stops the threads
+    ~AsyncKVStore();
+
+    // Utils::INVALID_VALUE if the key has no value, as KVStore::get
+    std::future<uint32_t> async_get(uint32_t key);
+    std::future<std::vector<std::pair<uint32_t, uint32_t>>> async_scan(uint32_t start_key, uint32_t end_key);
+    std::future<void> async_put(uint32_t key, uint32_t value);
+
+   private:
+    struct PendingPut {
+        uint32_t key;
+        uint32_t value;
+        std::promise<void> done;
+    };
+
+    KVStore *kvstore;
+    std::mutex mutex;
+    std::condition_variable cv;
+    std::deque<std::packaged_task<void()>> reads;
+    std::vector<PendingPut> puts;
+    // whether a thread is writing a batch of puts, the next batch waits for it to keep their order
+    bool is_writing = false;
+    bool is_stopping = false;
+    std::vector<std::thread> threads;
+
+    void add_read(std::packaged_task<void()> task);
+    // loop of each thread
+    void run();
+};
+
+#endif  // ASYNC_KV_STORE_HPP_
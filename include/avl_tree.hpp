@@ -2,35 +2,64 @@
 #define AVL_TREE_HPP_
 
 #include <cstdint>
+#include <functional>
+
+#include "./memtable.hpp"
+#include "./utils.hpp"
 
 class Node {
    public:
     uint32_t key;
     uint32_t value;
+    EntryType type;
+    // order of the write, see KVStore::snapshot()
+    uint64_t sequence;
     int height;
     Node *left;
     Node *right;
+    // the version this one replaced, only kept while a snapshot can see it
+    Node *older_version;
+
+    Node(uint32_t key, uint32_t value, EntryType type = EntryType::VALUE, uint64_t sequence = 0)
+        : key(key),
+          value(value),
+          type(type),
+          sequence(sequence),
+          height(1),
+          left(nullptr),
+          right(nullptr),
+          older_version(nullptr) {}
 
-    Node(uint32_t key, uint32_t value) : key(key), value(value), height(1), left(nullptr), right(nullptr) {}
+    // latest version written at or before the sequence number, nullptr if there is none
+    const Node *get_version(uint64_t max_sequence) const;
 };
 
 // Balanced binary search tree for memtable
-class AVLTree {
+class AVLTree : public Memtable {
    private:
     int get_height(Node *node);
     int get_balance(Node *node);
     Node *right_rotate(Node *node);
     Node *left_rotate(Node *node);
-    Node *insert_node(Node *node, uint32_t key, uint32_t value);
+    Node *insert_node(Node *node, uint32_t key, uint32_t value, EntryType type, uint64_t sequence,
+                      uint64_t newest_snapshot);
     Node *get_node(Node *node, uint32_t key);
+    void scan_node(Node *node, uint32_t start_key, uint32_t end_key,
+                   const std::function<void(uint32_t, uint32_t, EntryType)> &visit, uint64_t max_sequence);
 
    public:
     Node *root;
     AVLTree() : root(nullptr) {}
-    void put(uint32_t key, uint32_t value);
-    uint32_t get(uint32_t key);
+
+    void put(uint32_t key, uint32_t value, EntryType type = EntryType::VALUE, uint64_t sequence = 0,
+             uint64_t newest_snapshot = 0) override;
+    bool get(uint32_t key, uint32_t *value, EntryType *type, uint64_t max_sequence = LATEST) override;
+    void scan(uint32_t start_key, uint32_t end_key,
+              const std::function<void(uint32_t key, uint32_t value, EntryType type)> &visit,
+              uint64_t max_sequence = LATEST) override;
+    bool empty() const override;
     void clear_recursive(Node *node);
-    void clear();
+    void clear() override;
 };
 
 #endif  // AVL_TREE_HPP_
@@ -0,0 +1,84 @@
+#ifndef B_PLUS_TREE_HPP_
+#define B_PLUS_TREE_HPP_
+
+#include <cstdint>
+#include <functional>
+
+#include "./memtable.hpp"
+#include "./utils.hpp"
+
+// In-memory B+-tree for memtable. The keys of a node are a sorted array that spans a few cache lines, so a
+// lookup reads a handful of nodes instead of following one pointer per level of a binary tree, and the leaves
+// are linked in key order, so a scan (or a flush) reads them one after the other.
+class BPlusTree : public Memtable {
+   public:
+    // the keys of an inner node with their count, and the keys of a leaf, fill four cache lines each
+    static constexpr int INNER_KEYS = 63;
+    static constexpr int LEAF_KEYS = 64;
+
+    BPlusTree() = default;
+    BPlusTree(const BPlusTree &) = delete;
+    BPlusTree &operator=(const BPlusTree &) = delete;
+    ~BPlusTree() override;
+
+    void put(uint32_t key, uint32_t value, EntryType type = EntryType::VALUE, uint64_t sequence = 0,
+             uint64_t newest_snapshot = 0) override;
+    bool get(uint32_t key, uint32_t *value, EntryType *type, uint64_t max_sequence = LATEST) override;
+    void scan(uint32_t start_key, uint32_t end_key,
+              const std::function<void(uint32_t key, uint32_t value, EntryType type)> &visit,
+              uint64_t max_sequence = LATEST) override;
+    bool empty() const override;
+    void clear() override;
+
+    // number of levels of nodes, 0 when the tree is empty
+    int get_height() const;
+
+   private:
+    struct Version {
+        uint32_t value;
+        EntryType type;
+        // order of the write, see KVStore::snapshot()
+        uint64_t sequence;
+        // the version this one replaced, only kept while a snapshot can see it
+        Version *older_version;
+    };
+
+    // The latest version of each key is kept in the leaf, the older ones in a list behind it.
+    struct LeafNode {
+        int num_keys = 0;
+        uint32_t keys[LEAF_KEYS];
+        Version versions[LEAF_KEYS];
+        LeafNode *next = nullptr;
+    };
+
+    // keys[i] is the smallest key of children[i + 1]
+    struct InnerNode {
+        int num_keys = 0;
+        uint32_t keys[INNER_KEYS];
+        void *children[INNER_KEYS + 1];
+    };
+
+    // a node that is split in two gives the smallest key of its new right half and the right half
+    struct Split {
+        uint32_t key;
+        void *node;
+    };
+
+    // the nodes of the last level are leaves, the others are inner nodes
+    void *root = nullptr;
+    int height = 0;
+
+    // index of the child of the inner node whose keys include the key
+    static int find_child(const InnerNode *node, uint32_t key);
+    LeafNode *find_leaf(uint32_t key) const;
+    static const Version *get_version(const Version *version, uint64_t max_sequence);
+    // insert into the subtree of a node at the given depth, true if the node was split
+    bool insert(void *node, int depth, uint32_t key, const Version &version, uint64_t newest_snapshot,
+                Split *split);
+    bool insert_into_leaf(LeafNode *leaf, uint32_t key, const Version &version, uint64_t newest_snapshot,
+                          Split *split);
+    bool insert_into_inner_node(InnerNode *node, int index, const Split &child_split, Split *split);
+    void clear_node(void *node, int depth);
+};
+
+#endif  // B_PLUS_TREE_HPP_
@@ -1,28 +1,49 @@
 #ifndef BLOOM_FILTER_HPP_
 #define BLOOM_FILTER_HPP_
 
+#include <cstdint>
+#include <vector>
+
 #include "./btree.hpp"
 #include "./utils.hpp"
 
+// Bloom filter of an SST, stored as packed bits in as many pages as its number of bits needs. A key is hashed to
+// one of the pages and all of its bits are in that page, so a lookup reads a single page of the filter however
+// large it is. The SST's root holds the number of pages, the bits used in each page and the number of hash
+// functions, which the static functions take.
 class BloomFilter {
-   private:
-    int total_bits;  // total number of bits in bitmap
-
-    // number of hash functions
-    int hash_functions;
-
-    int hash(uint32_t key, int seed);
-
-    static const int MAX_BITMAP_SIZE = Utils::PAGE_SIZE - sizeof(int) - sizeof(BloomFilter::hash_functions);
-
    public:
-    // m = number of bits per entry
-    BloomFilter(int m, int num_entries);
+    static constexpr int MAX_BITS_PER_PAGE = Utils::PAGE_SIZE * 8;
 
-    bool bitmap[MAX_BITMAP_SIZE];
+    // m = number of bits per entry (can be fractional, 0 disables the filter)
+    BloomFilter(double m, int64_t num_entries);
 
     void insert(uint32_t key);
-    bool get(uint32_t key);
+    bool get(uint32_t key) const;
+
+    // 0 if the filter has no bits
+    int get_num_pages() const;
+    int get_bits_per_page() const;
+    int get_num_hash_functions() const;
+    // the PAGE_SIZE bytes of a page of the filter
+    const char* get_page(int page) const;
+
+    // page of a filter of num_pages pages that holds the bits of the key
+    static int get_page_index(uint32_t key, int num_pages);
+    // whether the key may have been inserted, from the page that holds its bits
+    static bool page_may_contain(const char* page, uint32_t key, int bits_per_page, int num_hash_functions);
+
+    // Monkey: split a total filter memory budget (in bits) across levels so that the sum of the
+    // false positive rates, i.e. the expected I/Os of a zero-result lookup, is minimal.
+    // Returns the bits per entry of each level given the number of entries of each level.
+    static std::vector<double> get_optimal_bits_per_entry(const std::vector<double>& entries_per_level,
+                                                          double total_bits);
+
+   private:
+    int num_pages;
+    int bits_per_page;
+    int num_hash_functions;
+    std::vector<uint8_t> bits;
 };
 
 #endif  // BLOOM_FILTER_HPP_
@@ -3,12 +3,63 @@
 
 #include <fstream>
 #include <iostream>
+#include <memory>
 #include <vector>
 
 #include "./avl_tree.hpp"
 #include "./buffer_pool.hpp"
+#include "./learned_index.hpp"
+#include "./merge_operator.hpp"
+#include "./range_tombstone.hpp"
+#include "./rate_limiter.hpp"
 #include "./utils.hpp"
 
+// How the entries of leaf pages are stored
+enum class LeafFormat : int {
+    // BTreeNode pages, MAX_KEYS entries each
+    PLAIN = 0,
+    // PackedLeaf pages, bit-packed with frame of reference
+    PACKED = 1,
+    // BTreeNode pages with fewer entries and a hash index of their keys, see BTreeNode::HASHED_MAX_KEYS
+    HASHED = 2,
+};
+
+// How groups of leaf pages are compressed on disk
+enum class CompressionType : int {
+    NONE = 0,
+    // the in-tree LZ4 block format codec, see compression.hpp
+    LZ4 = 1,
+};
+
+// Settings used when writing an SST, shared by flushes and compactions
+struct SSTOptions {
+    constexpr static const double DEFAULT_BITS_PER_ENTRY = 5;
+
+    // bloom filter bits per entry of each level, deeper levels than the vector covers use its last value
+    // (empty means DEFAULT_BITS_PER_ENTRY everywhere)
+    std::vector<double> level_bits_per_entry;
+
+    // throttles the page writes of flushes and compactions (optional)
+    RateLimiter* rate_limiter = nullptr;
+
+    // write a range filter page so that scans can skip SSTs with no key in their range
+    bool use_range_filter = false;
+
+    // write a learned index that predicts the leaf of a key, so that lookups skip the internal nodes
+    // (only with plain uncompressed leaves, which all hold the same number of entries at known pages)
+    bool use_learned_index = false;
+
+    LeafFormat leaf_format = LeafFormat::PLAIN;
+
+    // compress every BTreeNode::LEAVES_PER_BLOCK leaves into one variable-size block
+    CompressionType compression = CompressionType::NONE;
+
+    // combines the merge operands of a key during compactions (not owned)
+    const MergeOperator* merge_operator = nullptr;
+
+    double get_bits_per_entry(int level) const;
+};
+
 class BTreeNode {
    public:
     struct Entry {
@@ -16,16 +67,51 @@ class BTreeNode {
         uint32_t value;
     };
 
+    // An entry of the memtable or of a leaf, with its type
+    struct TypedEntry {
+        uint32_t key;
+        uint32_t value;
+        EntryType type;
+    };
+
     // MAX_KV_PAIRS_PER_PAGE = (PAGE_SIZE - sizeof(num_keys) - sizeof(file_offset)
-    // - sizeof(total_number_of_nodes) - num_of_leaf_nodes - sizeof(is_leaf)) / KEY_VALUE_SIZE - 1
-    static constexpr int MAX_KEYS = (Utils::PAGE_SIZE - sizeof(int) * 4 - sizeof(bool)) / sizeof(Entry) - 1;
+    // - sizeof(total_number_of_nodes) - num_of_leaf_nodes - sizeof(num_range_filter_blocks)
+    // - sizeof(num_learned_index_blocks) - sizeof(num_entries) - sizeof(leaf_format) - sizeof(compression)
+    // - sizeof(num_data_pages) - sizeof(num_block_index_blocks) - sizeof(num_range_tombstones)
+    // - sizeof(num_filter_pages) - sizeof(filter_bits_per_page) - sizeof(num_filter_hash_functions) - sizeof(is_leaf))
+    // / (KEY_VALUE_SIZE + sizeof(EntryType)) - 1
+    static constexpr int MAX_KEYS =
+        (Utils::PAGE_SIZE - sizeof(int) * 15 - sizeof(bool)) / (sizeof(Entry) + sizeof(EntryType)) - 1;
+
+    // Position of a compressed block of leaves, relative to the start of the compressed data (page 2)
+    struct BlockHandle {
+        uint32_t offset;
+        uint32_t size;
+    };
+    static constexpr int LEAVES_PER_BLOCK = 4;
+    static constexpr int HANDLES_PER_PAGE = Utils::PAGE_SIZE / sizeof(BlockHandle);
+    // range tombstones are stored as entries whose key is the start of the range and whose value is its end
+    static constexpr int RANGE_TOMBSTONES_PER_PAGE = Utils::PAGE_SIZE / sizeof(Entry);
+
+    // Leaves with a hash index hold at most HASHED_MAX_KEYS entries, and the end of their values array holds
+    // HASH_BUCKETS one-byte buckets. Both are derived from MAX_KEYS, with at least two buckets per entry so that
+    // probes are short. A bucket is 0 if empty, or 1 + i / 2 for a key at index i or i + 1, and collisions go
+    // to the next bucket (linear probing).
+    static constexpr int HASHED_MAX_KEYS = (MAX_KEYS + 1) * 2 / 3;
+    static constexpr int HASH_BUCKETS = (MAX_KEYS + 1 - HASHED_MAX_KEYS) * sizeof(uint32_t);
+    static_assert(HASH_BUCKETS >= 2 * HASHED_MAX_KEYS, "a hashed leaf needs two buckets per entry");
 
     // Current number of key-value pairs in this node
     int num_keys;
 
-    Entry entries[MAX_KEYS + 1];
+    // keys and values are stored in separate arrays (structure of arrays)
+    // so that the keys are contiguous and can be compared several at a time with SIMD instructions
+    uint32_t keys[MAX_KEYS + 1];
+    // if it's not a leaf node, the value is the offset of the child node
+    uint32_t values[MAX_KEYS + 1];
+    // type of each entry of a leaf, not used by internal nodes
+    EntryType types[MAX_KEYS + 1];
 
-    // if it's not a leaf node, the value field will store the file
     bool is_leaf;
 
     // offset to the child node
@@ -34,23 +120,122 @@ class BTreeNode {
     // metadata (only used by the root node)
     int total_number_of_nodes;
     int num_of_leaf_nodes;
+    // number of range filter pages, written right after the nodes (0 if the SST has none)
+    int num_range_filter_blocks;
+    // number of learned index pages, written right after the range filter (0 if the SST has none)
+    int num_learned_index_blocks;
+    int num_entries;
+    LeafFormat leaf_format;
+    CompressionType compression;
+    // number of file pages taken by the leaves, fewer than num_of_leaf_nodes if they are compressed
+    int num_data_pages;
+    // number of pages of block handles, written after the learned index (0 if the SST is not compressed)
+    int num_block_index_blocks;
+    // number of range tombstones, coalesced, in the pages after the block index
+    int num_range_tombstones;
+    // bloom filter pages (0 if the SST has no filter), the first at page 0 and the others after the range
+    // tombstones, with the bits used in each page and the number of hash functions
+    int num_filter_pages;
+    int filter_bits_per_page;
+    int num_filter_hash_functions;
+
+    // Page of the file that holds the given page of the SST (root only). Leaves keep their page numbers
+    // when compressed, but the pages after them are moved up to right after the compressed data.
+    int get_page_in_file(int offset) const;
+
+    // Where the bloom filter of an SST is and how it is probed, from its root. VersionFile keeps it so that
+    // lookups probe the filter without reading the root.
+    struct FilterLayout {
+        int num_pages;
+        int bits_per_page;
+        int num_hash_functions;
+        // page of the SST and page of the file of the second page of the filter, the next ones follow it
+        int second_page_offset;
+        int second_page_in_file;
+    };
+    // root only
+    FilterLayout get_filter_layout() const;
 
-    static void extract_leaf_nodes_from_avl(Node* root, std::vector<BTreeNode*>& leaf_nodes);
-    static BTreeNode* construct_internal_nodes_and_write_to_file(std::vector<BTreeNode*>& leaf_nodes,
-                                                                 std::ofstream file);
-    static uint32_t search_value_by_key(uint32_t key, std::filesystem::path file_path, BufferPool* buffer_pool);
+    // index of the first key >= key, num_keys if every key is smaller
+    int lower_bound(uint32_t key) const;
+
+    // Hash index of a leaf with at most HASHED_MAX_KEYS entries, built once its entries are set.
+    void build_hash_index();
+    // index of the key in a leaf with a hash index, -1 if it is not there
+    int find_with_hash_index(uint32_t key) const;
+
+    // entries of the memtable in key order, to be added to an SSTBuilder
+    // argument "max_sequence" selects the versions a snapshot sees instead of the latest ones
+    static void extract_entries_from_avl(Node* root, std::vector<TypedEntry>& entries,
+                                         uint64_t max_sequence = AVLTree::LATEST);
+    // false if the SST has no entry for the key, otherwise its value and type are stored in *value and *type
+    // argument "learned_index" is the SST's model if it has one, used instead of the internal nodes
+    // argument "filter_layout" is read from the root if it is not given
+    static bool search_value_by_key(uint32_t key, std::filesystem::path file_path, BufferPool* buffer_pool,
+                                    uint32_t* value, EntryType* type, const LearnedIndex* learned_index = nullptr,
+                                    const FilterLayout* filter_layout = nullptr);
+    // appends the entries of [start_key, end_key] to *result in key order, deletions included
     static void scan(uint32_t start_key, uint32_t end_key, std::filesystem::path file_path, BufferPool* buffer_pool,
-                     std::vector<std::pair<uint32_t, uint32_t> >* result);
-    static void read_leaf_nodes_from_file(std::ifstream& file, int offset, std::vector<BTreeNode*>& leafNodes);
+                     std::vector<TypedEntry>* result, const LearnedIndex* learned_index = nullptr);
+    // false if the range filter of the SST proves it has no key in [start_key, end_key]
+    static bool range_may_match(uint32_t start_key, uint32_t end_key, std::filesystem::path file_path,
+                                BufferPool* buffer_pool);
+    // load the learned index of an SST, nullptr if it was written without one
+    static std::unique_ptr<LearnedIndex> read_learned_index(std::filesystem::path file_path);
+    // range tombstones of an SST, sorted and disjoint
+    static std::vector<RangeTombstone> read_range_tombstones(std::filesystem::path file_path);
+    // bloom filter of an SST as lookups probe it
+    static FilterLayout read_filter_layout(std::filesystem::path file_path);
+    // smallest and largest key of an SST, read from its root and first leaf
+    static void read_key_range(std::filesystem::path file_path, uint32_t* min_key, uint32_t* max_key);
 
-    // argument "is_last_level" is used for the merge function
-    // to know whether to delete tombstones
+    // argument "is_last_level" is used for the merge function to know whether to delete tombstones (range
+    // tombstones included) and turn merge operands into values, "level" is the level of the output SST
     static void merge_ssts(std::filesystem::path old_sst_path, std::filesystem::path new_sst_path,
-                           std::filesystem::path output_path, bool is_last_level);
+                           std::filesystem::path output_path, bool is_last_level,
+                           const SSTOptions& options = SSTOptions(), int level = 0);
 
    private:
-    static BTreeNode* find_node(std::filesystem::path file_path, std::ifstream* file, int offset,
-                                BufferPool* buffer_pool);
+    // A read of an SST: its file, opened by the first page read that misses the buffer pool, and the pages read
+    // that the buffer pool did not take (refused by its admission filter, or inserted by another reader
+    // meanwhile), which are freed once the read is done.
+    struct SSTReader {
+        explicit SSTReader(BufferPool* buffer_pool) : buffer_pool(buffer_pool) {}
+        // frees the pages and counts them in the buffer pool
+        ~SSTReader();
+        SSTReader(const SSTReader&) = delete;
+        SSTReader& operator=(const SSTReader&) = delete;
+
+        BufferPool* buffer_pool;
+        std::ifstream file;
+        std::vector<std::unique_ptr<char[]>> pages;
+    };
+    // the buffer pool takes the page if it can, otherwise the reader keeps it
+    static void keep_page(SSTReader* reader, BufferPool* buffer_pool, const std::string& page_id, char* data,
+                          PageType type = PageType::DATA);
+
+    // argument "root" is needed to find the pages after the leaves of a compressed SST, argument "type" tells the
+    // buffer pool whether the page is a leaf or an index page
+    static BTreeNode* find_node(std::filesystem::path file_path, SSTReader* reader, int offset,
+                                BufferPool* buffer_pool, const BTreeNode* root = nullptr,
+                                PageType type = PageType::DATA);
+    // page in either the buffer pool or the SST, argument "size" is the number of bytes read from the SST
+    static const char* find_page(std::filesystem::path file_path, SSTReader* reader, int offset,
+                                 BufferPool* buffer_pool, std::streamsize size, const BTreeNode* root = nullptr,
+                                 PageType type = PageType::DATA);
+    // same, with the page of the file that holds it
+    static const char* find_page(std::filesystem::path file_path, SSTReader* reader, int offset, int page_in_file,
+                                 BufferPool* buffer_pool, std::streamsize size, PageType type);
+    // false if the bloom filter of the SST proves it does not have the key
+    static bool filter_may_contain(uint32_t key, std::filesystem::path file_path, SSTReader* reader,
+                                   BufferPool* buffer_pool, const FilterLayout& filter_layout);
+    // leaf page (a BTreeNode or a PackedLeaf), decompressed from its block if the SST is compressed
+    static const char* find_leaf(std::filesystem::path file_path, SSTReader* reader, int offset,
+                                 BufferPool* buffer_pool, const BTreeNode* root);
+    // leaf that holds the first key >= key, found with the learned index; its page is stored in *offset
+    static BTreeNode* find_leaf_with_learned_index(uint32_t key, std::filesystem::path file_path, SSTReader* reader,
+                                                   BufferPool* buffer_pool, const LearnedIndex* learned_index,
+                                                   int* offset);
 };
 
 #endif  // BTREE_HPP_
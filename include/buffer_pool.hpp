@@ -2,18 +2,65 @@
 #define BUFFER_POOL_HPP_
 
 #include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <set>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
+#include "./compressed_cache.hpp"
 #include "./extendible_hashtable.hpp"
 #include "./lru.hpp"
+#include "./tiny_lfu.hpp"
 
+// Kind of page, which decides the part of the buffer pool that caches it
+enum class PageType : int {
+    // leaves, of which a lookup reads one and a scan reads many
+    DATA = 0,
+    // filters and index pages (root, internal nodes, block handles), which every lookup of the SST reads
+    INDEX = 1,
+};
+
+// Cache of SST pages. It can be used by several threads at once: a page is never freed once inserted, so the
+// data that get returns stays valid while other threads insert and evict pages.
 class BufferPool {
    private:
+    mutable std::mutex mutex;
     ExtendibleHashtable *hashtable;
     LRU *eviction_policy;
+    int max_size;
+    // frequencies of the pages that get looked up, nullptr while every page read is inserted
+    std::unique_ptr<TinyLFU> admission_filter;
+
+    // Index pages once they have a capacity of their own, and the pages of pinned SSTs, which are never evicted.
+    // The other pages are in the hashtable.
+    struct PriorityPage {
+        const char *data;
+        bool is_pinned;
+    };
+    std::unordered_map<std::string, PriorityPage> priority_pages;
+    // the index pages that are not pinned
+    LRU index_eviction_policy;
+    int index_capacity = 0;
+    int num_index_pages = 0;
+    std::set<std::string> pinned_ssts;
+    // compressed blocks of compressed SSTs, disabled until given a capacity
+    CompressedCache compressed_cache;
+
+    // number of lookups that found / did not find the page (a miss means a read from the SST file)
+    int64_t num_hits = 0;
+    int64_t num_misses = 0;
+    // number of pages that insert added / refused to add
+    int64_t num_admitted = 0;
+    int64_t num_rejected = 0;
+    // number of pages that insert did not take and that their reader freed
+    int64_t num_freed = 0;
 
     void evict();
+    void remove_page(const std::string &page_id);
+    void remove_priority_page(const std::string &page_id);
 
    public:
     BufferPool(int min_size, int max_size);
@@ -27,13 +74,42 @@ class BufferPool {
     // Evicts pages if the new size is smaller than the current number of pages.
     void resize(int new_max_size);
 
-    // Insert a new page into the buffer pool.
-    void insert(const std::string &page_id, const char *data);
+    // Insert a new page into the buffer pool, unless another thread inserted the same page meanwhile or the
+    // admission filter rejects it. Returns whether it took the data, otherwise the caller still owns it.
+    bool insert(const std::string &page_id, const char *data, PageType type = PageType::DATA);
+
+    // Keep up to num_pages index pages apart from the data pages, so that the churn of data pages does not evict
+    // them (0, the default, caches them with the data pages).
+    void set_index_capacity(int num_pages);
+
+    // Keep every page of the SST read from now on until it is unpinned or removed, outside of any capacity.
+    void pin_sst(std::filesystem::path sst_path);
+    // its pinned pages are dropped
+    void unpin_sst(std::filesystem::path sst_path);
+
+    // With the admission filter, a page read into a full buffer pool only replaces the least recently used page
+    // if it was looked up more often lately (see TinyLFU), so that pages read once do not evict hot ones.
+    void set_admission_filter(bool enabled);
 
     // Remove a page from the buffer pool
     void remove(const std::string &page_id);
 
+    // Remove every page of an SST, and its blocks from the compressed cache
+    void remove_sst(std::filesystem::path sst_path);
+
     std::vector<Page *> get_all_pages();
+
+    CompressedCache &get_compressed_cache();
+
+    int64_t get_num_hits() const;
+    int64_t get_num_misses() const;
+    int64_t get_num_admitted() const;
+    int64_t get_num_rejected() const;
+    // Count pages that insert did not take, once the caller freed them.
+    void add_num_freed(int64_t num_pages);
+    int64_t get_num_freed() const;
+    // pages cached apart from the data pages, pinned or index pages
+    int get_num_priority_pages() const;
 };
 
 #endif  // BUFFER_POOL_HPP_
@@ -0,0 +1,54 @@
+#ifndef COMPRESSED_CACHE_HPP_
+#define COMPRESSED_CACHE_HPP_
+
+#include <cstdint>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include "./lru.hpp"
+
+// Secondary cache of compressed SST blocks, behind the buffer pool of uncompressed pages.
+// A page of a compressed SST that misses the buffer pool is decompressed from this cache instead of being
+// read from the file. Its capacity is in bytes of compressed data, so it holds several times more of the
+// data than the buffer pool would in the same memory. Blocks are evicted in LRU order.
+// It can be used by several threads at once.
+class CompressedCache {
+   private:
+    mutable std::mutex mutex;
+    int64_t capacity;
+    int64_t size = 0;
+    std::unordered_map<std::string, std::string> blocks;
+    LRU eviction_policy;
+
+    int64_t num_hits = 0;
+    int64_t num_misses = 0;
+
+    void evict();
+    void remove_block(const std::string &block_id);
+
+   public:
+    // a capacity of 0 disables the cache
+    explicit CompressedCache(int64_t capacity = 0);
+
+    // Compressed block with the given id, nullptr if it is not cached.
+    // The pointer is valid until the next insert or remove, so only while no other thread uses the cache.
+    const std::string *get(const std::string &block_id);
+    // false if the block is not cached, otherwise it is copied to *data
+    bool get(const std::string &block_id, std::string *data);
+    void insert(const std::string &block_id, std::string data);
+    void remove(const std::string &block_id);
+    // remove every block of an SST
+    void remove_sst(std::filesystem::path sst_path);
+
+    void set_capacity(int64_t new_capacity);
+
+    int64_t get_size() const;
+    int64_t get_num_hits() const;
+    int64_t get_num_misses() const;
+
+    static std::string generate_block_id(std::filesystem::path sst_path, int block);
+};
+
+#endif  // COMPRESSED_CACHE_HPP_
@@ -0,0 +1,24 @@
+#ifndef COMPRESSION_HPP_
+#define COMPRESSION_HPP_
+
+#include <cstdint>
+
+// Fast LZ77 byte compressor, used to compress groups of SST leaf pages. The output follows the LZ4 block
+// format: a sequence of (literals, match) pairs, each starting with a token byte holding both lengths, where a
+// match is a copy of at least 4 bytes from up to 64 KiB back in the output. It only uses a small hash table of
+// recent positions to find matches, so it compresses at hundreds of MB/s and decompresses at several GB/s.
+namespace Compression {
+
+// size of the buffer compress() needs for an input of the given size
+int get_max_compressed_size(int size);
+
+// Compress size bytes of src into dst, which must hold get_max_compressed_size(size) bytes.
+// Returns the compressed size.
+int compress(const char* src, int size, char* dst);
+
+// Decompress into exactly size bytes of dst, returns false if src is not a valid compressed block of that size.
+bool decompress(const char* src, int compressed_size, char* dst, int size);
+
+}  // namespace Compression
+
+#endif  // COMPRESSION_HPP_
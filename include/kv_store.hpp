@@ -1,48 +1,312 @@
 #ifndef KV_STORE_HPP_
 #define KV_STORE_HPP_
 
+#include <atomic>
+#include <condition_variable>
 #include <cstdint>
+#include <deque>
 #include <filesystem>
 #include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <shared_mutex>
 #include <string>
 #include <utility>
 #include <vector>
 
-#include "./avl_tree.hpp"
 #include "./buffer_pool.hpp"
+#include "./learned_index.hpp"
 #include "./level.hpp"
+#include "./manifest.hpp"
+#include "./memtable.hpp"
+#include "./merge_operator.hpp"
+#include "./range_tombstone.hpp"
+#include "./rate_limiter.hpp"
+#include "./row_cache.hpp"
+#include "./value_log.hpp"
+#include "./version.hpp"
+#include "./write_batch.hpp"
 
 namespace fs = std::filesystem;
 
+// The state of a KVStore as of one write, see KVStore::snapshot(). Reads through it see exactly the writes
+// made before it was taken, whatever flushes and compactions happen afterwards.
+class Snapshot {
+   public:
+    uint64_t get_sequence() const;
+
+   private:
+    friend class KVStore;
+
+    uint64_t sequence;
+    // SSTs when the snapshot was taken, which the Version keeps on disk
+    std::shared_ptr<const Version> version;
+    // memtable entries the snapshot sees, copied when the memtable is flushed (they are read from the memtable
+    // until then)
+    bool is_memtable_copied = false;
+    std::vector<BTreeNode::TypedEntry> memtable_entries;
+    std::vector<RangeTombstone> memtable_range_tombstones;
+};
+
+// Entries of KVStore::bulk_load in strictly increasing key order, read one at a time like an SSTIterator.
+class BulkLoadIterator {
+   public:
+    virtual ~BulkLoadIterator() = default;
+    virtual bool valid() const = 0;
+    virtual uint32_t key() const = 0;
+    virtual uint32_t value() const = 0;
+    virtual void next() = 0;
+    // number of entries, or an upper bound of it, used to size the filters of the SST
+    virtual int64_t get_num_entries() const = 0;
+};
+
+// Reads (get, scan, get_blob) and writes (put, delete_key, merge, delete_range, write), as well as bulk_load,
+// ingest, snapshot and release_snapshot, can be called by several threads at once: readers never wait for one
+// another nor for a flush or a compaction, writers only take a short exclusive lock to insert into the memtable.
+// The other methods (open, close, the setters, put_blob, collect_value_log_garbage) must not run concurrently
+// with any other call.
 class KVStore {
    private:
-    AVLTree memtable;
+    std::unique_ptr<Memtable> memtable;
     int memtable_size;  // max number of entries in memtable
+
+    // Entries written since the last flush while their keys are strictly increasing (e.g. time-ordered ingest):
+    // they are appended here instead of being inserted in the tree, which saves the rebalancing, and a flush
+    // copies them as they are. The first key out of order moves them to the tree, which then takes every write
+    // until the next flush. Their sequence numbers increase with their keys.
+    struct AppendedEntry {
+        uint32_t key;
+        uint32_t value;
+        EntryType type;
+        uint64_t sequence;
+    };
+    std::vector<AppendedEntry> appended_entries;
+    bool is_memtable_appending = true;
+
     int current_memtable_entries = 0;
     std::string db_name;
     fs::path db_path;
     int sst_count = 0;
     std::vector<Level> levels;
+    Manifest manifest;  // log of the files in each level
 
     BufferPool buffer_pool;
+    RowCache row_cache;
+
+    // bloom filter sizing and rate limiting of flushes and compactions
+    SSTOptions sst_options;
+    // total bloom filter bits to split across levels (0 means a fixed number of bits per entry)
+    int64_t filter_memory_budget = 0;
+
+    // range tombstones of delete_range that are not flushed yet, in the order they were written
+    std::vector<RangeTombstone> memtable_range_tombstones;
+
+    // Reads take the current Version, and look up the memtable under a shared lock of memtable_mutex. Writes
+    // insert into the memtable under an exclusive lock. Flushes and compactions, and anything else that changes
+    // the levels, are serialized by flush_mutex; readers only wait for them while a new Version is swapped in.
+    std::shared_mutex memtable_mutex;
+    std::mutex flush_mutex;
+    std::shared_ptr<const Version> current_version;
+    // the VersionFile of each live SST, shared by every Version made while it is in the levels
+    std::map<fs::path, std::shared_ptr<const VersionFile>> version_files;
+    // links are named link_prefix followed by a number, the prefix is drawn at each open
+    std::string link_prefix;
+    int next_link_id = 0;
+    // set by close, which drops the Version and its links until the store is used again
+    std::atomic<bool> is_closed{false};
+    // whether the pages of level 0 are pinned in the buffer pool, and the links pinned for it
+    bool pin_level0 = false;
+    std::set<fs::path> pinned_links;
+
+    // values of put_blob, the LSM tree only holds pointers to them
+    ValueLog value_log;
+
+    // sequence number of the last write, every write gets the next one
+    uint64_t last_sequence = 0;
+    // live snapshots, from the oldest to the newest
+    std::vector<std::unique_ptr<Snapshot>> snapshots;
+
+    // a batch waiting in the queue of write()
+    struct Writer {
+        explicit Writer(const WriteBatch *batch) : batch(batch) {}
+        const WriteBatch *batch;
+        bool done = false;
+        std::condition_variable cv;
+    };
+    std::mutex write_mutex;
+    std::deque<Writer *> writers;
+
+    void put_entry(uint32_t key, uint32_t value, EntryType type);
+    // write the memtable to an SST if it is full, for a write that just added entries to it
+    void flush_if_full();
+    // put the entry in the memtable with the next sequence number, a merge operand is combined with the entry
+    // the memtable already has for the key
+    void insert_into_memtable(uint32_t key, uint32_t value, EntryType type, uint64_t newest_snapshot);
+    // leave the append-only fast path, see appended_entries
+    void move_appended_entries_to_tree();
+    // latest entry of the key in the memtable with a sequence number up to max_sequence, false if there is none
+    bool find_in_memtable(uint32_t key, uint32_t *value, EntryType *type, uint64_t max_sequence = Memtable::LATEST);
+    // the memtable's entries of [start_key, end_key] (their latest versions up to max_sequence), in key order
+    void get_memtable_entries(uint32_t start_key, uint32_t end_key, std::vector<BTreeNode::TypedEntry> *result,
+                              uint64_t max_sequence = Memtable::LATEST);
+    // false if the key has no entry, otherwise its latest one (as of the snapshot if there is one) is stored in
+    // *value and *type, with its merge operands applied
+    bool find_entry(uint32_t key, uint32_t *value, EntryType *type, const Snapshot *snapshot = nullptr);
+    // sequence number of the newest snapshot, 0 if there is none
+    uint64_t get_newest_snapshot_sequence() const;
+    // range tombstones of the memtable (that the snapshot sees if there is one)
+    std::vector<RangeTombstone> get_memtable_range_tombstones(const Snapshot *snapshot) const;
+    // whether a range tombstone of the memtable (that the snapshot sees if there is one) covers the key
+    bool is_deleted_by_memtable_range(uint32_t key, const Snapshot *snapshot) const;
 
    public:
     KVStore(int memtable_size, int initial_size, int max_size);
 
+    // Share a rate limiter with this store's flushes and compactions (nullptr disables it).
+    // The limiter is not owned by the store.
+    void set_rate_limiter(RateLimiter *rate_limiter);
+
+    // Use the same number of bloom filter bits per entry in every level.
+    void set_bloom_bits_per_entry(double bits_per_entry);
+
+    // Split a total bloom filter budget (in bits) across levels, giving shallower levels
+    // lower false positive rates (Monkey). Applies to SSTs written from now on.
+    void set_filter_memory_budget(int64_t total_bits);
+
+    // Write a range filter with every new SST so that short scans skip SSTs without matching keys.
+    void set_range_filter(bool enabled);
+
+    // Write a learned index with every new SST, it is kept in memory and lookups use it
+    // to go straight to the leaf instead of reading the internal nodes.
+    void set_learned_index(bool enabled);
+
+    // Format of the leaves of new SSTs: packed leaves hold more entries per page, hashed leaves hold fewer but
+    // find a key without a binary search. Both disable the learned index.
+    void set_leaf_format(LeafFormat leaf_format);
+
+    // Compress the leaves of new SSTs in blocks of a few pages, found through a block index.
+    void set_compression(CompressionType compression);
+
+    // Keep up to capacity_bytes of compressed blocks in memory, behind the buffer pool (0 disables it).
+    void set_compressed_cache_capacity(int64_t capacity_bytes);
+
+    // Only add a page read from an SST to a full buffer pool if it is read more often than the page it evicts
+    // (see BufferPool::set_admission_filter).
+    void set_buffer_pool_admission_filter(bool enabled);
+
+    // Keep the results of up to num_rows point lookups in the SSTs in memory, so that gets of hot keys skip the
+    // SSTs (0 disables it). Reads through a snapshot do not use it.
+    void set_row_cache_capacity(int64_t num_rows);
+
+    // Cache up to num_pages filter and index pages apart from the leaves in the buffer pool, so that lookups
+    // keep finding them however many leaves scans read (see BufferPool::set_index_capacity).
+    void set_index_cache_capacity(int num_pages);
+
+    // Keep every page read from the SSTs of level 0 in the buffer pool until they leave the level. Every lookup
+    // may read each of them, and they are few and small.
+    void set_pin_level0(bool enabled);
+
+    // Size of the value log files, blobs are appended to a new file once the last one reaches it.
+    void set_value_log_segment_size(int64_t bytes);
+
+    // Data structure of the memtable, the AVL tree by default. It must be set while the memtable is empty, e.g.
+    // right after open.
+    void set_memtable_type(MemtableType type);
+
+    // Operator that combines the operands of merge with the values of their keys. It is not owned by the store,
+    // and must stay the same across reopens as long as operands may be left in the SSTs.
+    void set_merge_operator(const MergeOperator *merge_operator);
+
+    BufferPool &get_buffer_pool();
+    RowCache &get_row_cache();
+    ValueLog &get_value_log();
+
     // Basic API Functions
     void open(const std::string &name);
     void put(uint32_t key, uint32_t value);
+    // Utils::INVALID_VALUE if the key has no value, which is also a value that can be stored
     uint32_t get(uint32_t key);
-    std::vector<std::pair<uint32_t, uint32_t>> scan(uint32_t start_key, uint32_t end_key);
+    // false if the key has no value (never written, or deleted), otherwise the value is stored in *value
+    // argument "snapshot" reads the value the key had when the snapshot was taken
+    bool get(uint32_t key, uint32_t *value, const Snapshot *snapshot = nullptr);
+    // latest value of every key of [start_key, end_key] that has one (as of the snapshot if there is one), in key
+    // order
+    std::vector<std::pair<uint32_t, uint32_t>> scan(uint32_t start_key, uint32_t end_key,
+                                                    const Snapshot *snapshot = nullptr);
     void delete_key(uint32_t key);  // name "delete" will conflict with C++ keyword
+    // Combine the value of the key with the operand through the merge operator (a key without a value takes the
+    // operand). The operand is only recorded, reads and compactions apply it, so it costs as much as a put.
+    void merge(uint32_t key, uint32_t operand);
+    // Delete every key of [start_key, end_key] with a single range tombstone, whatever the number of keys.
+    // Compactions drop the entries it covers.
+    void delete_range(uint32_t start_key, uint32_t end_key);
+    // Flush the memtable and drop the links the reads hold on the SSTs, so that another store can open the
+    // directory. The store can still be used afterwards, it links its SSTs again then.
     void close();
 
+    // Load sorted entries into an empty store, streamed straight into one SST of the level whose SSTs hold as many
+    // entries, without going through the memtable or any compaction. The SST only becomes part of the store once
+    // it is complete: an error (e.g. unsorted keys) or a crash leaves the store empty.
+    void bulk_load(BulkLoadIterator *iterator);
+
+    // Attach SSTs written elsewhere (see SSTWriter) to the store, in O(1) per file: their entries are newer than
+    // the ones already in the store, and later files are newer than earlier ones. Each file goes to the deepest
+    // level that no newer data overlaps (an empty one if possible, so that it is not compacted right away), the
+    // memtable is flushed first if it overlaps the file.
+    // The files are moved into the store's directory, or hard-linked if "move_files" is false (so they must be on
+    // the same file system).
+    void ingest(const std::vector<fs::path> &sst_paths, bool move_files = true);
+
+    // Apply every operation of the batch atomically. Threads that call write at once queue up, and the first one
+    // applies all the queued batches and checks whether the memtable is full once for all of them, while the
+    // others wait.
+    void write(const WriteBatch &batch);
+
+    // Large values (blobs) of any size. A key holds either a 32-bit value or a blob: get and scan skip keys
+    // that hold a blob, and get_blob returns false for keys that hold a 32-bit value.
+    // A blob is appended to the value log and the LSM tree only holds a pointer to it, so flushes and
+    // compactions do not rewrite it.
+    void put_blob(uint32_t key, const std::string &value);
+    bool get_blob(uint32_t key, std::string *value, const Snapshot *snapshot = nullptr);
+
+    // Reclaim the space of the oldest value log file: its blobs that are still live are appended again, then
+    // the file is deleted. Returns the number of bytes reclaimed, 0 if only the file being appended to is left
+    // or if a snapshot is live (it may still read blobs that are no longer live).
+    int64_t collect_value_log_garbage();
+
+    // Take a snapshot of the current state, for reads that must not see later writes (e.g. a long scan done
+    // in parts). It keeps the SSTs it reads from (through the Version it holds) and the memtable entries it
+    // sees, so it must be released.
+    // Snapshots do not survive closing the store.
+    const Snapshot *snapshot();
+    void release_snapshot(const Snapshot *snapshot);
+
     // Helper Functions
-    void scan_memtable(Node *node, uint32_t start_key, uint32_t end_key,
-                       std::vector<std::pair<uint32_t, uint32_t>> *result);
-    void scan_ssts(uint32_t start_key, uint32_t end_key, std::vector<std::pair<uint32_t, uint32_t>> *result);
-    uint32_t find_value_in_ssts(uint32_t key);
+    // appends the entries of every SST of the version (and of the memtable it flushes) from the newest to the
+    // oldest, except those deleted by the range tombstones of a newer SST or by argument "range_tombstones" (of
+    // the memtable)
+    void scan_ssts(uint32_t start_key, uint32_t end_key, std::vector<BTreeNode::TypedEntry> *result,
+                   const Version &version, std::vector<RangeTombstone> range_tombstones = {});
+    // false if no SST of the version (nor the memtable it flushes) has an entry for the key, otherwise the newest
+    // one is stored in *value and *type, with the merge operands of the SSTs applied (the type stays MERGE if
+    // there is no older value). A key in a range deleted by an SST counts as a deletion.
+    bool find_value_in_ssts(uint32_t key, uint32_t *value, EntryType *type, const Version &version);
+    // the caller holds flush_mutex
     void write_memtable_to_sst();
+    // splits the filter memory budget over the levels, at least min_num_levels of them
+    void update_filter_allocation(int min_num_levels = 0);
+    // whether an SST of the level holds or deletes a key of [start_key, end_key]
+    bool level_overlaps(int level, uint32_t start_key, uint32_t end_key) const;
+    // Make a Version of the levels as they are now the current one, once the levels changed. The caller holds
+    // flush_mutex.
+    void install_version();
+    // installs a Version again if the store was closed, for a read
+    void reopen_if_closed();
+    // pins the SSTs of level 0 of the current version if pin_level0 is set, and unpins the others. The caller
+    // holds flush_mutex.
+    void update_pinned_ssts();
 };
 
 #endif  // KV_STORE_HPP_
@@ -0,0 +1,78 @@
+#ifndef LEARNED_INDEX_HPP_
+#define LEARNED_INDEX_HPP_
+
+#include <cstdint>
+#include <vector>
+
+#include "./utils.hpp"
+
+// Piecewise linear model of an SST that maps a key to its position among the SST's sorted entries,
+// within EPSILON positions. Since every leaf but the last holds exactly entries_per_leaf entries,
+// the position gives the leaf page directly, without reading the internal B-tree nodes.
+//
+// The segments are built in one pass over the sorted keys (shrinking cone): a segment is extended
+// while some slope keeps every key of the segment within EPSILON of its position. Dense or evenly
+// spaced keys need a handful of segments, much fewer than one fence pointer per leaf.
+//
+// The model is stored in page-sized blocks after the SST's range filter and kept in memory by the KVStore.
+class LearnedIndex {
+   public:
+    struct Segment {
+        uint32_t first_key;
+        // position of first_key in the SST
+        uint32_t first_position;
+        double slope;
+    };
+
+    // On-disk layout of the model, one page per block
+    struct Block {
+        int num_entries;
+        int entries_per_leaf;
+        int first_leaf_offset;
+        int num_segments;
+        Segment segments[(Utils::PAGE_SIZE - sizeof(int) * 4) / sizeof(Segment)];
+    };
+    static constexpr int SEGMENTS_PER_BLOCK = sizeof(Block::segments) / sizeof(Segment);
+
+    // maximum distance between the predicted and the actual position of a key
+    static constexpr int EPSILON = 64;
+
+    explicit LearnedIndex(int entries_per_leaf);
+
+    // Add the next key of the SST, keys must be added in increasing order.
+    void add(uint32_t key);
+    // Close the last segment, must be called after the last key is added.
+    void finish();
+
+    // Leaves that may hold the first key >= key: the search starts at predicted_leaf and does not need to go
+    // past first_leaf or last_leaf. Leaves are numbered from the smallest keys, starting at 0.
+    void get_search_window(uint32_t key, int* first_leaf, int* predicted_leaf, int* last_leaf) const;
+
+    void set_first_leaf_offset(int offset);
+    // page of the given leaf in the SST
+    int get_leaf_offset(int leaf) const;
+
+    int get_num_entries() const;
+    int get_num_segments() const;
+
+    std::vector<Block> to_blocks() const;
+    static LearnedIndex from_blocks(const std::vector<Block>& blocks);
+
+   private:
+    int num_entries = 0;
+    int entries_per_leaf;
+    std::vector<Segment> segments;
+    // first key of each segment, searched with PageSearch
+    std::vector<uint32_t> first_keys;
+
+    // slopes that keep every key added to the current segment within EPSILON
+    double min_slope;
+    double max_slope;
+    // page of the leaf with the smallest keys, the others follow it
+    int first_leaf_offset = 0;
+
+    void start_segment(uint32_t key);
+    int predict(uint32_t key) const;
+};
+
+#endif  // LEARNED_INDEX_HPP_
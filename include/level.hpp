@@ -9,6 +9,7 @@
 #include "./avl_tree.hpp"
 #include "./btree.hpp"
 #include "./buffer_pool.hpp"
+#include "./manifest.hpp"
 
 namespace fs = std::filesystem;
 
@@ -18,12 +19,35 @@ class Level {
 
     // argument "is_last_level" is used for the merge function
     // to know whether to delete tombstones
-    void compact(std::filesystem::path db_path, int sst_num, bool is_last_level);
+    // the compaction is recorded in the manifest (if any) before its input files are deleted
+    void compact(std::filesystem::path db_path, int sst_num, int level_num, bool is_last_level,
+                 const SSTOptions& options = SSTOptions(), Manifest* manifest = nullptr);
 
     static void update_levels(std::vector<Level>& levels, std::filesystem::path sst_path, std::filesystem::path db_path,
-                              BufferPool& buffer_pool);
+                              BufferPool& buffer_pool, const SSTOptions& options = SSTOptions(),
+                              Manifest* manifest = nullptr);
+    // compact the given level into the next one if it is full, and so on down the tree
+    static void compact_levels(std::vector<Level>& levels, int level_num, std::filesystem::path db_path,
+                               BufferPool& buffer_pool, const SSTOptions& options = SSTOptions(),
+                               Manifest* manifest = nullptr);
+    // rebuild the levels from the files recorded in the manifest
+    static void load_from_manifest(std::vector<Level>& levels, const Manifest& manifest, std::filesystem::path db_path);
+    // legacy: infer the level of an SST from its file name (for databases without a manifest)
     static void load_into_lsm_tree(std::vector<Level>& levels, std::filesystem::path sst_path);
 
+    // Add an SST written outside of flushes and compactions (e.g. by a bulk load or an ingest) to a level, as its
+    // newest SST, under the file name of the level's next SST, and record it in the manifest (if any). The level
+    // is not compacted, see compact_levels. Returns the new path of the file.
+    static std::filesystem::path install_sst(std::vector<Level>& levels, int level_num, std::filesystem::path sst_path,
+                                             std::filesystem::path db_path, Manifest* manifest = nullptr);
+
+    static FileMetaData get_file_meta(int level_num, std::filesystem::path sst_path);
+
+    // maximum number of entries a level holds before it is compacted into the next one
+    static int64_t get_max_entries(int level_num, int memtable_size);
+    // whether the level holds as many SSTs as it can, so that the next SST added compacts it into the next one
+    bool is_full() const;
+
    private:
     static const int SIZE_RATIO = 2;
 
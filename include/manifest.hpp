@@ -0,0 +1,82 @@
+#ifndef MANIFEST_HPP_
+#define MANIFEST_HPP_
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// Metadata of one live SST file
+struct FileMetaData {
+    std::string file_name;  // relative to the database directory
+    int level;
+    uint32_t min_key;
+    uint32_t max_key;
+    uint64_t file_size;
+};
+
+// A set of changes to the LSM tree shape that is applied atomically,
+// e.g. a flush adds one file to level 0, a compaction removes its inputs and adds its output.
+class VersionEdit {
+   public:
+    std::vector<FileMetaData> added_files;
+    std::vector<std::pair<int, std::string>> removed_files;  // (level, file name)
+
+    void add_file(const FileMetaData& meta);
+    void remove_file(int level, const std::string& file_name);
+
+    void encode(std::string* dst) const;
+    // returns false if the record is malformed
+    bool decode(const std::string& src);
+};
+
+// Append-only log of version edits. Replaying it at open gives the exact LSM tree shape
+// with a single sequential read, and it is rewritten as a single snapshot edit from time to time.
+//
+// Record format: [uint32 payload size][uint64 checksum of payload][payload].
+// A torn or corrupt record at the end of the log (crash during append) is ignored.
+class Manifest {
+   private:
+    fs::path db_path;
+    std::ofstream log;
+    int edits_since_checkpoint = 0;
+
+    // live files of each level, in the order they were added
+    std::vector<std::vector<FileMetaData>> files_per_level;
+
+    void apply(const VersionEdit& edit);
+    // writes the record, then fsyncs the file at the given path
+    void append_record(std::ofstream& file, const fs::path& path, const VersionEdit& edit);
+    void open_log();
+
+   public:
+    static constexpr const char* FILE_NAME = "MANIFEST";
+    // Number of edits appended before the log is compacted into a snapshot.
+    static const int CHECKPOINT_INTERVAL = 64;
+
+    // Replay the manifest of the database, returns false if it does not have one yet
+    // (in which case an empty manifest is created).
+    bool open(const fs::path& db_path);
+
+    // Durably record the edit (the MANIFEST is fsynced), then apply it to the in-memory state.
+    void log_and_apply(const VersionEdit& edit);
+
+    // Rewrite the log as one edit that adds every live file. The new log atomically replaces the old one.
+    void checkpoint();
+
+    // Delete SST and temporary files in the database directory that are not referenced by the
+    // manifest, i.e. outputs of a flush or compaction that crashed before its edit was logged,
+    // or inputs of a compaction that crashed before they were deleted.
+    void remove_orphan_files();
+
+    int get_num_levels() const;
+    const std::vector<FileMetaData>& get_files(int level) const;
+    // metadata of a live file, nullptr if the manifest does not know it
+    const FileMetaData* find_file(int level, const std::string& file_name) const;
+};
+
+#endif  // MANIFEST_HPP_
@@ -0,0 +1,45 @@
+#ifndef MEMTABLE_HPP_
+#define MEMTABLE_HPP_
+
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+
+#include "./utils.hpp"
+
+// Data structure of the memtable
+enum class MemtableType : int {
+    // AVLTree, one heap node per key
+    AVL_TREE = 0,
+    // BPlusTree, sorted arrays of keys in nodes of a few cache lines, leaves linked in key order
+    B_PLUS_TREE = 1,
+};
+
+// Sorted in-memory table of the latest entry of each key written since the last flush, with the older versions
+// that snapshots still see.
+class Memtable {
+   public:
+    static constexpr uint64_t LATEST = std::numeric_limits<uint64_t>::max();
+
+    static std::unique_ptr<Memtable> create(MemtableType type);
+
+    virtual ~Memtable() = default;
+
+    // argument "newest_snapshot" is the sequence number of the newest snapshot (0 if there is none), the
+    // version replaced by this one is kept if the snapshot can see it
+    virtual void put(uint32_t key, uint32_t value, EntryType type = EntryType::VALUE, uint64_t sequence = 0,
+                     uint64_t newest_snapshot = 0) = 0;
+    // false if the key has no version written at or before max_sequence, otherwise the latest one is stored in
+    // *value and *type
+    virtual bool get(uint32_t key, uint32_t *value, EntryType *type, uint64_t max_sequence = LATEST) = 0;
+    // Call visit with the latest version written at or before max_sequence of every key of [start_key, end_key]
+    // that has one, in key order.
+    virtual void scan(uint32_t start_key, uint32_t end_key,
+                      const std::function<void(uint32_t key, uint32_t value, EntryType type)> &visit,
+                      uint64_t max_sequence = LATEST) = 0;
+    virtual bool empty() const = 0;
+    virtual void clear() = 0;
+};
+
+#endif  // MEMTABLE_HPP_
@@ -0,0 +1,30 @@
+#ifndef MERGE_OPERATOR_HPP_
+#define MERGE_OPERATOR_HPP_
+
+#include <cstdint>
+
+// Combines the value of a key with an operand of KVStore::merge, so that read-modify-writes such as counter
+// increments are recorded without reading the value first. Operands are also combined with each other before
+// the value they apply to is known (in the memtable, by compactions and by reads that meet several of them),
+// so merge must be associative. A key that has no value takes its oldest operand as its value.
+class MergeOperator {
+   public:
+    virtual ~MergeOperator() = default;
+    virtual uint32_t merge(uint32_t existing, uint32_t operand) const = 0;
+
+    // merge_operator->merge, throws if there is no operator to combine the merge operands found
+    static uint32_t apply(const MergeOperator* merge_operator, uint32_t existing, uint32_t operand);
+};
+
+// existing + operand, wrapping around on overflow
+class AddOperator : public MergeOperator {
+   public:
+    uint32_t merge(uint32_t existing, uint32_t operand) const override;
+};
+
+class MaxOperator : public MergeOperator {
+   public:
+    uint32_t merge(uint32_t existing, uint32_t operand) const override;
+};
+
+#endif  // MERGE_OPERATOR_HPP_
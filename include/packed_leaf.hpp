@@ -0,0 +1,55 @@
+#ifndef PACKED_LEAF_HPP_
+#define PACKED_LEAF_HPP_
+
+#include <cstdint>
+
+#include "./utils.hpp"
+
+// Compressed leaf page: keys and values are stored with frame of reference and bit packing, i.e. each key as
+// key - min_key in key_bits bits and each value as value - min_value in value_bits bits. Dense keys only need
+// a few bits each, so a page holds several times more entries than a BTreeNode leaf. The entry types are packed
+// the same way after the values, so a leaf without deletions spends no bits on them, and the values of
+// deletions are not stored.
+//
+// Every field can be read on its own, so a lookup binary-searches the packed keys without unpacking the page.
+// Scans and compactions unpack whole pages at once, 4 fields per instruction with AVX2 when it is available.
+class PackedLeaf {
+   public:
+    static constexpr int DATA_BYTES = Utils::PAGE_SIZE - sizeof(int) - sizeof(uint32_t) * 2 - sizeof(uint8_t) * 4;
+    // fields are read 8 bytes at a time, so the end of the data is never used
+    static constexpr int SLACK_BYTES = 8;
+    static constexpr int MAX_ENTRIES = 4096;
+
+    int num_keys;
+    uint32_t min_key;
+    uint32_t min_value;
+    uint8_t key_bits;
+    uint8_t value_bits;
+    uint8_t min_type;
+    uint8_t type_bits;
+    // the packed keys, then the packed values and the packed types, each starting at the next byte
+    uint8_t data[DATA_BYTES];
+
+    // number of bits needed to store every value of [0, range]
+    static int get_bit_width(uint32_t range);
+    // whether num_entries entries with the given widths fit in one page
+    static bool fits(int num_entries, int key_bits, int value_bits, int type_bits);
+
+    // Pack entries sorted by key, they must fit in the page.
+    void pack(const uint32_t* keys, const uint32_t* values, const EntryType* types, int num_entries);
+
+    uint32_t get_key(int index) const;
+    uint32_t get_value(int index) const;
+    EntryType get_type(int index) const;
+    // index of the first key >= key, num_keys if every key is smaller
+    int lower_bound(uint32_t key) const;
+
+    // Unpack every entry, the arrays must hold num_keys entries.
+    void unpack(uint32_t* keys, uint32_t* values, EntryType* types) const;
+
+   private:
+    const uint8_t* get_values_data() const;
+    const uint8_t* get_types_data() const;
+};
+
+#endif  // PACKED_LEAF_HPP_
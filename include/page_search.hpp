@@ -0,0 +1,24 @@
+#ifndef PAGE_SEARCH_HPP_
+#define PAGE_SEARCH_HPP_
+
+#include <cstdint>
+
+// Search of the sorted key array of a B-tree page.
+// A branchless binary search narrows the candidates down to a small window, then the keys of the window that are
+// smaller than the search key are counted with SIMD compares (8 keys per instruction with AVX2, 16 with AVX-512,
+// 4 with NEON). The kernel is picked once at runtime from what the CPU supports, with a scalar fallback.
+namespace PageSearch {
+
+enum class Kernel { SCALAR, AVX2, AVX512, NEON };
+
+// Index of the first key >= key in keys[0, n), n if every key is smaller.
+int lower_bound(const uint32_t* keys, int n, uint32_t key);
+int lower_bound(const uint32_t* keys, int n, uint32_t key, Kernel kernel);
+
+// Kernel used by lower_bound(keys, n, key)
+Kernel get_active_kernel();
+bool is_supported(Kernel kernel);
+
+}  // namespace PageSearch
+
+#endif  // PAGE_SEARCH_HPP_
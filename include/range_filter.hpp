@@ -0,0 +1,67 @@
+#ifndef RANGE_FILTER_HPP_
+#define RANGE_FILTER_HPP_
+
+#include <cstdint>
+#include <vector>
+
+#include "./utils.hpp"
+
+// Prefix bloom filter that answers "may the SST contain a key in [start_key, end_key]?".
+// Every key is inserted once per prefix length, as key >> shift for each shift in PREFIX_SHIFTS.
+// A range query picks the finest prefix length at which the range spans at most MAX_PROBES prefixes
+// and probes each of them, so empty short ranges are ruled out without reading any B-tree page.
+//
+// The filter is split into page-sized blocks stored in the SST after its internal nodes. Prefixes of the
+// same length are grouped 2^GROUP_SHIFT consecutive ones at a time and each group is hashed to a block, so a
+// range query, which probes at most MAX_PROBES consecutive prefixes, only needs one or two blocks, and keys
+// clustered in a small part of the key space are still spread evenly over all the blocks.
+class RangeFilter {
+   private:
+    // smallest and largest key of the SST, a query outside of them is rejected without probing
+    uint32_t min_key;
+    uint32_t max_key;
+
+    int total_bits;
+    int hash_functions;
+
+    int hash(uint32_t prefix, int shift, int i);
+
+   public:
+    static constexpr int PREFIX_SHIFTS[] = {0, 4, 8, 12, 16};
+    static constexpr int NUM_PREFIX_SHIFTS = sizeof(PREFIX_SHIFTS) / sizeof(PREFIX_SHIFTS[0]);
+    // ranges that span more prefixes than this at the coarsest prefix length are not filtered
+    static constexpr int MAX_PROBES = 8;
+    static constexpr int GROUP_SHIFT = 3;
+    static_assert(MAX_PROBES <= 1 << GROUP_SHIFT, "the prefixes of a query must span at most two groups");
+    static constexpr int BITS_PER_ENTRY = 32;
+    static constexpr int MAX_HASH_FUNCTIONS = 8;
+    static constexpr int MAX_BITMAP_BYTES = Utils::PAGE_SIZE - sizeof(uint32_t) * 2 - sizeof(int) * 2;
+
+    RangeFilter(int num_entries, int num_blocks);
+
+    uint8_t bitmap[MAX_BITMAP_BYTES];
+
+    void insert_prefix(uint32_t prefix, int shift);
+    bool probe(uint32_t prefix, int shift);
+    // false if [start_key, end_key] is outside of the SST's key range
+    bool overlaps(uint32_t start_key, uint32_t end_key) const;
+
+    // number of blocks (pages) of the filter of an SST with the given number of entries
+    static int get_num_blocks(int num_entries);
+    // block that holds the given prefix
+    static int get_block_index(uint32_t prefix, int shift, int num_blocks);
+
+    // Create the empty blocks of the filter of an SST, insert each of its keys, then finish the blocks.
+    static std::vector<RangeFilter> create_blocks(int num_entries);
+    static void insert(std::vector<RangeFilter>& blocks, uint32_t key);
+    static void finish(std::vector<RangeFilter>& blocks);
+
+    // Range query on blocks held in memory (SSTs are queried page by page through the buffer pool).
+    static bool may_contain(std::vector<RangeFilter>& blocks, uint32_t start_key, uint32_t end_key);
+
+    // Find the prefixes to probe for a range query, returns false if the range is too wide to be filtered.
+    static bool get_probe_range(uint32_t start_key, uint32_t end_key, int* shift, uint32_t* first_prefix,
+                                uint32_t* last_prefix);
+};
+
+#endif  // RANGE_FILTER_HPP_
@@ -0,0 +1,25 @@
+#ifndef RANGE_TOMBSTONE_HPP_
+#define RANGE_TOMBSTONE_HPP_
+
+#include <cstdint>
+#include <vector>
+
+// Deletion of every key of [start_key, end_key], see KVStore::delete_range.
+//
+// The range tombstones of an SST delete the entries of older SSTs, never the SST's own entries (those are newer:
+// a flush or a compaction leaves out the entries its tombstones delete). Likewise, the range tombstones of the
+// memtable only delete the entries of the SSTs, as delete_range also writes a deletion for every key of the
+// range that the memtable holds.
+struct RangeTombstone {
+    uint32_t start_key;
+    uint32_t end_key;
+    // sequence number of the delete_range, only used in the memtable (SSTs do not store sequence numbers)
+    uint64_t sequence = 0;
+
+    // sorted, disjoint ranges covering the same keys as the given ones, the sequence numbers are dropped
+    static std::vector<RangeTombstone> coalesce(std::vector<RangeTombstone> tombstones);
+    // whether a range of coalesced tombstones covers the key, with a binary search
+    static bool covers(const std::vector<RangeTombstone>& coalesced, uint32_t key);
+};
+
+#endif  // RANGE_TOMBSTONE_HPP_
@@ -0,0 +1,72 @@
+#ifndef RATE_LIMITER_HPP_
+#define RATE_LIMITER_HPP_
+
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+
+// Token bucket shared by flush and compaction so that background I/O has a bounded
+// impact on foreground reads. Tokens are bytes and are refilled continuously at
+// bytes_per_sec. A request larger than the available tokens is admitted immediately
+// but leaves the bucket in debt, and the caller sleeps until the debt is paid off.
+class RateLimiter {
+   private:
+    using Clock = std::chrono::steady_clock;
+
+    std::mutex mutex;
+
+    // current refill rate, lowered and raised by auto-tune between min and max
+    int64_t bytes_per_sec;
+    int64_t max_bytes_per_sec;
+    int64_t min_bytes_per_sec;
+
+    // tokens currently in the bucket (negative when in debt)
+    double available_bytes;
+    Clock::time_point last_refill;
+
+    // whether compaction input reads are charged as well as writes
+    bool charge_reads;
+
+    // auto-tune state: an EWMA of the foreground latency reported by the store
+    bool auto_tune;
+    double target_latency_us;
+    double latency_ewma_us;
+    int samples_since_tune;
+
+    int64_t total_bytes_through;
+
+    void refill();
+
+   public:
+    // The bucket holds at most this many seconds worth of tokens, which bounds bursts.
+    constexpr static const double BURST_SECONDS = 0.1;
+    // Auto-tune never lowers the rate below MAX / MIN_RATE_DIVISOR.
+    static const int MIN_RATE_DIVISOR = 16;
+    // Number of latency samples between two auto-tune adjustments.
+    static const int AUTO_TUNE_INTERVAL = 32;
+    constexpr static const double LATENCY_EWMA_WEIGHT = 0.1;
+    // Multiplicative decrease when latency is above target, increase when well below.
+    constexpr static const double BACKOFF_FACTOR = 0.7;
+    constexpr static const double RECOVERY_FACTOR = 1.1;
+
+    explicit RateLimiter(int64_t bytes_per_sec, bool auto_tune = false, double target_latency_us = 1000.0);
+
+    // Block until the given number of bytes may be written.
+    void request(int64_t bytes);
+
+    // Same as request but only charged when read limiting is enabled.
+    void request_read(int64_t bytes);
+
+    // Report the latency of a foreground operation that had to go to the SSTs.
+    // Only used when auto-tune is enabled.
+    void record_foreground_latency(double latency_us);
+
+    void set_bytes_per_sec(int64_t new_bytes_per_sec);
+    void set_charge_reads(bool charge);
+
+    int64_t get_bytes_per_sec();
+    int64_t get_total_bytes_through();
+    bool is_auto_tune() const;
+};
+
+#endif  // RATE_LIMITER_HPP_
@@ -0,0 +1,61 @@
+#ifndef ROW_CACHE_HPP_
+#define ROW_CACHE_HPP_
+
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "./utils.hpp"
+
+// Cache of the results of point lookups in the SSTs (KVStore::find_value_in_ssts), found or not, so that a hot
+// key is found with one hash probe instead of a walk down the SSTs. Rows are evicted in LRU order.
+//
+// The result of a key only changes when a flush or an ingest adds entries or range tombstones of the key to the
+// SSTs, which invalidates its row. Every invalidation starts a new epoch, and a lookup only inserts its result if
+// no invalidation happened since it took the epoch, so a lookup that raced with a flush cannot bring back the
+// result it replaced. It can be used by several threads at once.
+class RowCache {
+   public:
+    // a capacity of 0 disables the cache
+    explicit RowCache(int64_t capacity = 0);
+
+    // false if the key has no row, otherwise whether the SSTs have an entry of the key is stored in *found, and
+    // the entry in *value and *type
+    bool get(uint32_t key, bool *found, uint32_t *value, EntryType *type);
+    // argument "epoch" is the one taken before the lookup
+    void insert(uint32_t key, bool found, uint32_t value, EntryType type, uint64_t epoch);
+    uint64_t get_epoch() const;
+    void invalidate(const std::vector<uint32_t> &keys);
+    void invalidate(uint32_t start_key, uint32_t end_key);
+
+    void set_capacity(int64_t new_capacity);
+
+    int64_t get_capacity() const;
+    int64_t get_size() const;
+    int64_t get_num_hits() const;
+    int64_t get_num_misses() const;
+
+   private:
+    struct Row {
+        uint32_t key;
+        bool found;
+        uint32_t value;
+        EntryType type;
+    };
+
+    mutable std::mutex mutex;
+    int64_t capacity;
+    uint64_t epoch = 0;
+    // the most recently used row first
+    std::list<Row> rows;
+    std::unordered_map<uint32_t, std::list<Row>::iterator> row_map;
+
+    int64_t num_hits = 0;
+    int64_t num_misses = 0;
+
+    void remove_row(uint32_t key);
+};
+
+#endif  // ROW_CACHE_HPP_
@@ -0,0 +1,63 @@
+#ifndef SHARDED_KV_STORE_HPP_
+#define SHARDED_KV_STORE_HPP_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "./kv_store.hpp"
+#include "./write_batch.hpp"
+
+// How ShardedKVStore assigns keys to shards
+enum class ShardingType : int {
+    // by a hash of the key, which spreads any workload (e.g. sequential keys) evenly over the shards
+    HASH = 0,
+    // by equal ranges of the key space, so a scan reads only the shards of its range, one after the other
+    RANGE = 1,
+};
+
+// A store split into independent KVStores (shards), each with its own directory, memtable, flushes and
+// compactions, so writes to different shards never wait for one another, and one shard compacting does not
+// hold up the others. The buffer pool budget is shared out evenly between the shards.
+//
+// The shards are in "<name>/shard_<i>", a store must be reopened with the same number of shards and the same
+// sharding type. Every method can be called by several threads at once, as for KVStore, except open and close.
+// Operations that span several shards (delete_range, write, scan) are atomic within each shard only.
+class ShardedKVStore {
+   public:
+    // argument "initial_size" and "max_size" are the buffer pool budget of the whole store
+    ShardedKVStore(int num_shards, int memtable_size, int initial_size, int max_size,
+                   ShardingType sharding_type = ShardingType::HASH);
+
+    // throws std::runtime_error if the store was written with another number of shards
+    void open(const std::string &name);
+    void close();
+
+    void put(uint32_t key, uint32_t value);
+    // Utils::INVALID_VALUE if the key has no value
+    uint32_t get(uint32_t key);
+    bool get(uint32_t key, uint32_t *value);
+    void delete_key(uint32_t key);
+    void merge(uint32_t key, uint32_t operand);
+    void delete_range(uint32_t start_key, uint32_t end_key);
+    // the operations of each shard are applied with one KVStore::write
+    void write(const WriteBatch &batch);
+    // latest value of every key of [start_key, end_key] that has one, in key order
+    std::vector<std::pair<uint32_t, uint32_t>> scan(uint32_t start_key, uint32_t end_key);
+
+    int get_num_shards() const;
+    int get_shard_index(uint32_t key) const;
+    // e.g. to set the options of each shard right after open
+    KVStore &get_shard(int index);
+
+   private:
+    ShardingType sharding_type;
+    std::vector<std::unique_ptr<KVStore>> shards;
+
+    // first key of the range of a shard, with ShardingType::RANGE
+    uint32_t get_range_start(int index) const;
+};
+
+#endif  // SHARDED_KV_STORE_HPP_
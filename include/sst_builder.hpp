@@ -0,0 +1,97 @@
+#ifndef SST_BUILDER_HPP_
+#define SST_BUILDER_HPP_
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <vector>
+
+#include "./bloom_filter.hpp"
+#include "./btree.hpp"
+#include "./learned_index.hpp"
+#include "./range_filter.hpp"
+
+// Writes an SST from entries added in increasing key order, shared by flushes and compactions.
+//
+// SST layout, one page each:
+//   0                                  first page of the bloom filter
+//   1                                  root, which also holds the metadata of the SST
+//   2 .. num_of_leaf_nodes + 1         leaves, in key order
+//   .. total_number_of_nodes           the other internal nodes, from the level above the leaves up
+//   total_number_of_nodes + 1 ..       range filter blocks, then learned index blocks (if enabled), then the
+//                                      block index (if compressed), then the range tombstones (if any), then
+//                                      the other pages of the bloom filter (if it needs more than one)
+//
+// Leaves are written as soon as they are full, so the entries are streamed to the file. The internal nodes,
+// filters and root are written by finish().
+//
+// In a compressed SST, every BTreeNode::LEAVES_PER_BLOCK leaves are compressed together into a variable-size
+// block. The blocks are written back to back from page 2, the pages after the leaves are moved up to right
+// after them (see BTreeNode::get_page_in_file) and a block index giving the position of each block is written
+// after the learned index. Leaves keep their page numbers, so the internal nodes are the same either way.
+class SSTBuilder {
+   public:
+    // argument "level" is the level the SST is written to, used to size its bloom filter
+    // argument "expected_num_entries" sizes the filters, it can be larger than the number of entries added
+    SSTBuilder(std::filesystem::path file_path, const SSTOptions& options, int level, int64_t expected_num_entries);
+
+    // Add the next entry, keys must be strictly increasing.
+    void add(uint32_t key, uint32_t value, EntryType type = EntryType::VALUE);
+    // Add a range tombstone, in any order. It deletes the entries of older SSTs, not those of this one.
+    void add_range_tombstone(uint32_t start_key, uint32_t end_key);
+    // Whether append_leaves can copy the leaves of an SST as they are: they have this SST's leaf format, neither
+    // SST is compressed or has a range filter or learned index and the SST has no range tombstones. No entry
+    // must be pending in a leaf of this SST.
+    bool can_append_leaves(std::filesystem::path sst_path) const;
+    // Copy the leaves of an SST after those written so far and add their keys to the bloom filter. Its keys must
+    // all be larger than the keys added before.
+    void append_leaves(std::filesystem::path sst_path);
+    void finish();
+
+    int64_t get_num_entries() const;
+    int get_num_leaf_nodes() const;
+
+   private:
+    std::ofstream file;
+    SSTOptions options;
+    std::unique_ptr<BloomFilter> filter;
+    std::vector<RangeFilter> range_filter;
+    LearnedIndex learned_index;
+    // the learned index needs leaves with a fixed number of entries, at fixed pages
+    bool use_learned_index;
+
+    // entries of the leaf being filled
+    std::vector<uint32_t> leaf_keys;
+    std::vector<uint32_t> leaf_values;
+    std::vector<EntryType> leaf_types;
+    // range of the values of the leaf's entries that have one, and of its types
+    uint32_t min_leaf_value = Utils::INVALID_VALUE;
+    uint32_t max_leaf_value = 0;
+    uint8_t min_leaf_type = 0;
+    uint8_t max_leaf_type = 0;
+
+    std::vector<RangeTombstone> range_tombstones;
+
+    // largest key and page of each leaf written so far
+    std::vector<BTreeNode::Entry> leaf_delimiters;
+    int64_t num_entries = 0;
+
+    // leaves of the block being filled (compressed SSTs only)
+    std::vector<char> block;
+    int num_block_leaves = 0;
+    std::vector<BTreeNode::BlockHandle> block_handles;
+    // bytes of compressed blocks written so far
+    int64_t data_size = 0;
+    // how far the pages after the leaves are moved
+    int page_shift = 0;
+
+    bool leaf_has_room(uint32_t key, uint32_t value, EntryType type) const;
+    void write_leaf();
+    void write_block();
+    // write the internal nodes level by level, then the footer blocks and the root
+    void write_internal_nodes();
+    void write_page(int offset, const char* data, std::streamsize size);
+};
+
+#endif  // SST_BUILDER_HPP_
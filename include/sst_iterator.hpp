@@ -0,0 +1,60 @@
+#ifndef SST_ITERATOR_HPP_
+#define SST_ITERATOR_HPP_
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <vector>
+
+#include "./btree.hpp"
+#include "./packed_leaf.hpp"
+#include "./rate_limiter.hpp"
+
+// Reads every entry of an SST in key order, one leaf page (or compressed block) at a time, bypassing the
+// buffer pool.
+// Used by compactions, whose reads are throttled by the rate limiter if it also limits reads.
+class SSTIterator {
+   public:
+    explicit SSTIterator(std::filesystem::path file_path, RateLimiter* rate_limiter = nullptr);
+
+    bool valid() const;
+    uint32_t key() const;
+    uint32_t value() const;
+    EntryType type() const;
+    void next();
+
+    // number of entries of the SST, from its root
+    int64_t get_num_entries() const;
+
+   private:
+    std::ifstream file;
+    RateLimiter* rate_limiter;
+    LeafFormat leaf_format;
+    CompressionType compression;
+    int num_entries;
+    int leaf_offset;
+    int last_leaf_offset;
+
+    std::unique_ptr<BTreeNode> node;
+    std::unique_ptr<PackedLeaf> packed_leaf;
+    // entries of the current leaf
+    std::vector<uint32_t> keys;
+    std::vector<uint32_t> values;
+    std::vector<EntryType> types;
+    int num_keys = 0;
+    int index = 0;
+
+    // decompressed leaves of the current block (compressed SSTs only)
+    std::vector<BTreeNode::BlockHandle> block_handles;
+    std::vector<char> block;
+    int current_block = -1;
+
+    void read_page(int offset, char* data, std::streamsize size);
+    // read a leaf page, decompressing its block if the SST is compressed
+    void read_leaf_page(int offset, char* data, std::streamsize size);
+    // read leaves until one with entries, or the end of the SST
+    void read_leaf();
+};
+
+#endif  // SST_ITERATOR_HPP_
@@ -0,0 +1,34 @@
+#ifndef SST_WRITER_HPP_
+#define SST_WRITER_HPP_
+
+#include <cstdint>
+#include <filesystem>
+
+#include "./btree.hpp"
+#include "./sst_builder.hpp"
+
+// Writes an SST outside of any store, e.g. to build a dataset offline and attach it to a store with
+// KVStore::ingest. The file has the same format as the SSTs of the store. Keys must be strictly increasing.
+class SSTWriter {
+   public:
+    // argument "expected_num_entries" sizes the filters, it can be larger than the number of entries added
+    // argument "level" is the level whose bloom filter bits per entry are used
+    SSTWriter(std::filesystem::path file_path, int64_t expected_num_entries, const SSTOptions& options = SSTOptions(),
+              int level = 0);
+
+    void put(uint32_t key, uint32_t value);
+    void delete_key(uint32_t key);
+    // Delete the keys of [start_key, end_key] in the SSTs the file is newer than, in any order.
+    void delete_range(uint32_t start_key, uint32_t end_key);
+    void finish();
+
+    int64_t get_num_entries() const;
+
+   private:
+    SSTBuilder builder;
+    uint32_t last_key = 0;
+
+    void add(uint32_t key, uint32_t value, EntryType type);
+};
+
+#endif  // SST_WRITER_HPP_
@@ -0,0 +1,43 @@
+#ifndef TINY_LFU_HPP_
+#define TINY_LFU_HPP_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Admission policy of a cache (TinyLFU): it estimates how often each id was accessed lately, and a new item only
+// replaces the eviction victim if it was accessed more often, so items read once (e.g. by a scan) do not push
+// hot ones out.
+//
+// The frequencies are kept in a count-min sketch of DEPTH rows of small counters: an id increments one counter
+// per row, and its estimate is the smallest of them. Every counter is halved after sample_size accesses, so
+// that items that were hot long ago fade away.
+class TinyLFU {
+   public:
+    static constexpr int DEPTH = 4;
+    // counters saturate, which is enough to compare frequencies within a sample
+    static constexpr uint8_t MAX_COUNT = 15;
+
+    // argument "capacity" is the number of items of the cache
+    explicit TinyLFU(int capacity);
+
+    void record(const std::string &id);
+    int estimate(const std::string &id) const;
+    // whether the candidate was accessed more often than the victim it would replace
+    bool admit(const std::string &candidate, const std::string &victim) const;
+
+    int get_sample_size() const;
+
+   private:
+    // counters per row, a power of two
+    int width;
+    int sample_size;
+    int num_records = 0;
+    std::vector<uint8_t> counters;
+
+    // index in counters of the counter of the id in a row
+    int get_index(uint64_t hash, int row) const;
+    void age();
+};
+
+#endif  // TINY_LFU_HPP_
@@ -7,10 +7,22 @@
 #include <limits>
 #include <string>
 
+// What an entry of the memtable or of an SST stands for. Every uint32_t is a valid value, so a deletion is
+// told apart by its type instead of a reserved value.
+enum class EntryType : uint8_t {
+    VALUE = 0,
+    // tombstone for deletion in the LSM tree, its value is not used
+    DELETION = 1,
+    // the value is a pointer to a record of the value log, see value_log.hpp
+    BLOB = 2,
+    // the value is an operand of KVStore::merge, to be combined with the older entries of the key
+    MERGE = 3,
+};
+
 namespace Utils {
 ;
-const uint32_t INVALID_VALUE = std::numeric_limits<uint32_t>::max();   // = -1
-const uint32_t TOMB_STONE = std::numeric_limits<uint32_t>::max() - 1;  // tomb stone for deletion in LSMTree
+// returned by KVStore::get(key) when the key has no value, see KVStore::get(key, value) to tell them apart
+const uint32_t INVALID_VALUE = std::numeric_limits<uint32_t>::max();  // = -1
 const int ENTRY_SIZE = 2 * sizeof(uint32_t);
 const int PAGE_SIZE = 4096;
 
@@ -0,0 +1,66 @@
+#ifndef VALUE_LOG_HPP_
+#define VALUE_LOG_HPP_
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// Append-only log of large values (WiscKey-style key-value separation). The LSM tree only stores a 32-bit
+// pointer to the record of a value, so flushes and compactions move the pointer instead of the value.
+//
+// The log is a sequence of segment files named after the pointer of their first record. Records are appended
+// to the last segment (the head) until it reaches the segment size. Space is reclaimed a segment at a time,
+// from the oldest: its live records are appended again and the segment file is deleted (see
+// KVStore::collect_value_log_garbage).
+//
+// Record format: [uint32 key][uint32 value size][uint64 checksum of value][value], padded to ALIGNMENT bytes.
+// A pointer is the position of a record in the whole log divided by ALIGNMENT, so the log can address 64 GiB.
+class ValueLog {
+   public:
+    static constexpr int ALIGNMENT = 16;
+    static constexpr int64_t DEFAULT_SEGMENT_SIZE = 64 << 20;
+    static constexpr const char* EXTENSION = ".vlog";
+
+    struct Record {
+        uint32_t key;
+        uint32_t pointer;
+        std::string value;
+    };
+
+    // Find the segments of the database, records are appended after the last one.
+    void open(const fs::path& db_path);
+    void set_segment_size(int64_t bytes);
+
+    // Append a record, returns its pointer.
+    uint32_t append(uint32_t key, const std::string& value);
+    // false if the pointer is not the start of a valid record (e.g. its segment was collected)
+    bool read(uint32_t pointer, uint32_t* key, std::string* value);
+
+    // Every record of the oldest segment, in the order they were appended.
+    void read_oldest_segment(std::vector<Record>* records);
+    // Delete the oldest segment, returns its size in bytes (0 if it is the head, which is never deleted).
+    int64_t remove_oldest_segment();
+
+    // number of segments, the head included
+    int get_num_segments() const;
+    // total size of the segments in bytes
+    int64_t get_size() const;
+
+   private:
+    fs::path db_path;
+    int64_t segment_size = DEFAULT_SEGMENT_SIZE;
+    // size in bytes of each segment, by the pointer of its first record
+    std::map<uint32_t, int64_t> segments;
+    std::ofstream head;
+
+    fs::path get_segment_path(uint32_t first_pointer) const;
+    // start a new segment at the end of the log
+    void open_head(uint32_t first_pointer);
+};
+
+#endif  // VALUE_LOG_HPP_
@@ -0,0 +1,59 @@
+#ifndef VERSION_HPP_
+#define VERSION_HPP_
+
+#include <cstdint>
+#include <filesystem>
+#include <memory>
+#include <vector>
+
+#include "./btree.hpp"
+#include "./buffer_pool.hpp"
+#include "./learned_index.hpp"
+#include "./range_tombstone.hpp"
+
+// An SST as the reads of a Version see it, through a hard link of its own: compactions delete the SSTs they
+// merge and reuse their names, the link keeps the file as it was until the last Version that holds it is gone.
+// It also keeps what lookups need without any I/O.
+class VersionFile {
+   public:
+    // argument "link_path" is a name no other file has
+    VersionFile(const std::filesystem::path &sst_path, const std::filesystem::path &link_path,
+                BufferPool *buffer_pool);
+    VersionFile(const VersionFile &) = delete;
+    VersionFile &operator=(const VersionFile &) = delete;
+    // removes the link and its pages from the buffer pool
+    ~VersionFile();
+
+    const std::filesystem::path &get_path() const;
+    // whether the SST may have keys of [start_key, end_key], from its key range
+    bool may_overlap(uint32_t start_key, uint32_t end_key) const;
+    // nullptr for SSTs written without one
+    const LearnedIndex *get_learned_index() const;
+    const BTreeNode::FilterLayout *get_filter_layout() const;
+    // they delete the keys of the older SSTs
+    const std::vector<RangeTombstone> &get_range_tombstones() const;
+
+   private:
+    std::filesystem::path path;
+    BufferPool *buffer_pool;
+    uint32_t min_key;
+    uint32_t max_key;
+    std::unique_ptr<LearnedIndex> learned_index;
+    BTreeNode::FilterLayout filter_layout;
+    std::vector<RangeTombstone> range_tombstones;
+};
+
+// What reads see of the SSTs of a store: its SSTs and the entries of the memtable being flushed, if any.
+// A Version is never modified, flushes and compactions make a new one, so a read keeps using the one it took
+// while they run.
+class Version {
+   public:
+    // SSTs of each level, in the order they were added (the newest last)
+    std::vector<std::vector<std::shared_ptr<const VersionFile>>> levels;
+    // Entries of the memtable being flushed, in key order, until its SST is in the levels. They are newer than
+    // every SST, and so are its range tombstones (coalesced), which delete the keys of the SSTs.
+    std::vector<BTreeNode::TypedEntry> flushing_entries;
+    std::vector<RangeTombstone> flushing_range_tombstones;
+};
+
+#endif  // VERSION_HPP_
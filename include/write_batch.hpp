@@ -0,0 +1,27 @@
+#ifndef WRITE_BATCH_HPP_
+#define WRITE_BATCH_HPP_
+
+#include <cstdint>
+#include <vector>
+
+#include "./btree.hpp"
+#include "./utils.hpp"
+
+// Puts, deletes and merges applied together by KVStore::write: they get consecutive sequence numbers and the memtable
+// is not flushed in the middle of them, so a snapshot or an SST holds either all of them or none.
+// Later operations on the same key win, as if they were applied one by one.
+class WriteBatch {
+   public:
+    void put(uint32_t key, uint32_t value);
+    void delete_key(uint32_t key);
+    void merge(uint32_t key, uint32_t operand);
+    void clear();
+
+    int get_num_operations() const;
+    const std::vector<BTreeNode::TypedEntry>& get_operations() const;
+
+   private:
+    std::vector<BTreeNode::TypedEntry> operations;
+};
+
+#endif  // WRITE_BATCH_HPP_
@@ -0,0 +1,103 @@
+#include "async_kv_store.hpp"
+
+#include <exception>
+
+#include "write_batch.hpp"
+
+AsyncKVStore::AsyncKVStore(KVStore *kvstore, int num_threads) : kvstore(kvstore) {
+    for (int i = 0; i < num_threads; i++) {
+        threads.emplace_back(&AsyncKVStore::run, this);
+    }
+}
+
+AsyncKVStore::~AsyncKVStore() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        is_stopping = true;
+    }
+    cv.notify_all();
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+}
+
+std::future<uint32_t> AsyncKVStore::async_get(uint32_t key) {
+    std::packaged_task<uint32_t()> task([this, key]() { return kvstore->get(key); });
+    std::future<uint32_t> result = task.get_future();
+    add_read(std::packaged_task<void()>(std::move(task)));
+    return result;
+}
+
+std::future<std::vector<std::pair<uint32_t, uint32_t>>> AsyncKVStore::async_scan(uint32_t start_key,
+                                                                                 uint32_t end_key) {
+    std::packaged_task<std::vector<std::pair<uint32_t, uint32_t>>()> task(
+        [this, start_key, end_key]() { return kvstore->scan(start_key, end_key); });
+    std::future<std::vector<std::pair<uint32_t, uint32_t>>> result = task.get_future();
+    add_read(std::packaged_task<void()>(std::move(task)));
+    return result;
+}
+
+std::future<void> AsyncKVStore::async_put(uint32_t key, uint32_t value) {
+    std::future<void> result;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        puts.push_back({key, value, std::promise<void>()});
+        result = puts.back().done.get_future();
+    }
+    cv.notify_one();
+    return result;
+}
+
+void AsyncKVStore::add_read(std::packaged_task<void()> task) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        reads.push_back(std::move(task));
+    }
+    cv.notify_one();
+}
+
+void AsyncKVStore::run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        cv.wait(lock, [this]() { return is_stopping || !reads.empty() || (!puts.empty() && !is_writing); });
+        if (!puts.empty() && !is_writing) {
+            // every put queued so far goes in one batch
+            std::vector<PendingPut> group = std::move(puts);
+            puts.clear();
+            is_writing = true;
+            lock.unlock();
+
+            WriteBatch batch;
+            for (const PendingPut &put : group) {
+                batch.put(put.key, put.value);
+            }
+            std::exception_ptr error;
+            try {
+                kvstore->write(batch);
+            } catch (...) {
+                error = std::current_exception();
+            }
+            for (PendingPut &put : group) {
+                if (error) {
+                    put.done.set_exception(error);
+                } else {
+                    put.done.set_value();
+                }
+            }
+
+            lock.lock();
+            is_writing = false;
+            // the puts queued meanwhile can go
+            cv.notify_all();
+        } else if (!reads.empty()) {
+            std::packaged_task<void()> task = std::move(reads.front());
+            reads.pop_front();
+            lock.unlock();
+            task();
+            lock.lock();
+        } else if (is_stopping) {
+            // the puts still queued, if any, are written by the thread writing the last batch
+            return;
+        }
+    }
+}
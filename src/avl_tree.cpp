@@ -46,17 +46,34 @@ Node *AVLTree::left_rotate(Node *node) {
     return right;
 }
 
-Node *AVLTree::insert_node(Node *node, uint32_t key, uint32_t value) {
+const Node *Node::get_version(uint64_t max_sequence) const {
+    const Node *version = this;
+    while (version != nullptr && version->sequence > max_sequence) {
+        version = version->older_version;
+    }
+    return version;
+}
+
+Node *AVLTree::insert_node(Node *node, uint32_t key, uint32_t value, EntryType type, uint64_t sequence,
+                           uint64_t newest_snapshot) {
     if (!node) {
-        return new Node(key, value);
+        return new Node(key, value, type, sequence);
     }
 
     if (key < node->key) {
-        node->left = insert_node(node->left, key, value);
+        node->left = insert_node(node->left, key, value, type, sequence, newest_snapshot);
     } else if (key > node->key) {
-        node->right = insert_node(node->right, key, value);
+        node->right = insert_node(node->right, key, value, type, sequence, newest_snapshot);
     } else {
+        if (newest_snapshot != 0 && node->sequence <= newest_snapshot) {
+            // the node keeps its place in the tree, the version it held moves down the chain
+            Node *older = new Node(node->key, node->value, node->type, node->sequence);
+            older->older_version = node->older_version;
+            node->older_version = older;
+        }
         node->value = value;
+        node->type = type;
+        node->sequence = sequence;
         return node;
     }
 
@@ -98,21 +115,53 @@ Node *AVLTree::get_node(Node *node, uint32_t key) {
     return nullptr;
 }
 
-void AVLTree::put(uint32_t key, uint32_t value) { root = insert_node(root, key, value); }
+void AVLTree::put(uint32_t key, uint32_t value, EntryType type, uint64_t sequence, uint64_t newest_snapshot) {
+    root = insert_node(root, key, value, type, sequence, newest_snapshot);
+}
 
-uint32_t AVLTree::get(uint32_t key) {
+bool AVLTree::get(uint32_t key, uint32_t *value, EntryType *type, uint64_t max_sequence) {
     Node *node = get_node(root, key);
-    if (node) {
-        return node->value;
+    const Node *version = node != nullptr ? node->get_version(max_sequence) : nullptr;
+    if (version) {
+        *value = version->value;
+        *type = version->type;
+        return true;
+    }
+    return false;
+}
+
+void AVLTree::scan_node(Node *node, uint32_t start_key, uint32_t end_key,
+                        const std::function<void(uint32_t, uint32_t, EntryType)> &visit, uint64_t max_sequence) {
+    if (node == nullptr) return;
+
+    if (start_key < node->key) {
+        scan_node(node->left, start_key, end_key, visit, max_sequence);
+    }
+    const Node *version = node->get_version(max_sequence);
+    if (start_key <= node->key && node->key <= end_key && version != nullptr) {
+        visit(version->key, version->value, version->type);
+    }
+    if (node->key < end_key) {
+        scan_node(node->right, start_key, end_key, visit, max_sequence);
     }
-    return Utils::INVALID_VALUE;
 }
 
+void AVLTree::scan(uint32_t start_key, uint32_t end_key,
+                   const std::function<void(uint32_t, uint32_t, EntryType)> &visit, uint64_t max_sequence) {
+    scan_node(root, start_key, end_key, visit, max_sequence);
+}
+
+bool AVLTree::empty() const { return root == nullptr; }
+
 void AVLTree::clear_recursive(Node *node) {
     if (node) {
         clear_recursive(node->left);
         clear_recursive(node->right);
-        delete node;
+        while (node != nullptr) {
+            Node *older = node->older_version;
+            delete node;
+            node = older;
+        }
     }
     root = nullptr;
 }
@@ -0,0 +1,216 @@
+#include "b_plus_tree.hpp"
+
+#include <algorithm>
+
+#include "page_search.hpp"
+
+/* Implementation for BPlusTree (Memtable) */
+
+BPlusTree::~BPlusTree() { clear(); }
+
+int BPlusTree::find_child(const InnerNode *node, uint32_t key) {
+    // the number of keys <= key
+    int index = PageSearch::lower_bound(node->keys, node->num_keys, key);
+    return index < node->num_keys && node->keys[index] == key ? index + 1 : index;
+}
+
+BPlusTree::LeafNode *BPlusTree::find_leaf(uint32_t key) const {
+    void *node = root;
+    for (int depth = 0; depth < height - 1; depth++) {
+        const InnerNode *inner_node = (const InnerNode *)node;
+        node = inner_node->children[find_child(inner_node, key)];
+    }
+    return (LeafNode *)node;
+}
+
+const BPlusTree::Version *BPlusTree::get_version(const Version *version, uint64_t max_sequence) {
+    while (version != nullptr && version->sequence > max_sequence) {
+        version = version->older_version;
+    }
+    return version;
+}
+
+bool BPlusTree::insert_into_leaf(LeafNode *leaf, uint32_t key, const Version &version, uint64_t newest_snapshot,
+                                 Split *split) {
+    int index = PageSearch::lower_bound(leaf->keys, leaf->num_keys, key);
+    if (index < leaf->num_keys && leaf->keys[index] == key) {
+        Version &current = leaf->versions[index];
+        Version *older_version = current.older_version;
+        if (newest_snapshot != 0 && current.sequence <= newest_snapshot) {
+            // the version it held moves down the list
+            older_version = new Version(current);
+        }
+        current = version;
+        current.older_version = older_version;
+        return false;
+    }
+
+    LeafNode *right = nullptr;
+    if (leaf->num_keys == LEAF_KEYS) {
+        right = new LeafNode();
+        // keys written in increasing order fill the leaves instead of leaving them half full
+        int num_left = index == LEAF_KEYS && leaf->next == nullptr ? LEAF_KEYS : LEAF_KEYS / 2;
+        right->num_keys = LEAF_KEYS - num_left;
+        std::copy(leaf->keys + num_left, leaf->keys + LEAF_KEYS, right->keys);
+        std::copy(leaf->versions + num_left, leaf->versions + LEAF_KEYS, right->versions);
+        leaf->num_keys = num_left;
+        right->next = leaf->next;
+        leaf->next = right;
+        if (index >= num_left) {
+            leaf = right;
+            index -= num_left;
+        }
+    }
+    std::copy_backward(leaf->keys + index, leaf->keys + leaf->num_keys, leaf->keys + leaf->num_keys + 1);
+    std::copy_backward(leaf->versions + index, leaf->versions + leaf->num_keys,
+                       leaf->versions + leaf->num_keys + 1);
+    leaf->keys[index] = key;
+    leaf->versions[index] = version;
+    leaf->num_keys++;
+
+    if (right == nullptr) {
+        return false;
+    }
+    split->key = right->keys[0];
+    split->node = right;
+    return true;
+}
+
+bool BPlusTree::insert_into_inner_node(InnerNode *node, int index, const Split &child_split, Split *split) {
+    if (node->num_keys < INNER_KEYS) {
+        std::copy_backward(node->keys + index, node->keys + node->num_keys, node->keys + node->num_keys + 1);
+        std::copy_backward(node->children + index + 1, node->children + node->num_keys + 1,
+                           node->children + node->num_keys + 2);
+        node->keys[index] = child_split.key;
+        node->children[index + 1] = child_split.node;
+        node->num_keys++;
+        return false;
+    }
+
+    // the node is full: the middle key of the keys with the new one moves up, the keys after it to a new node
+    uint32_t keys[INNER_KEYS + 1];
+    void *children[INNER_KEYS + 2];
+    std::copy(node->keys, node->keys + index, keys);
+    keys[index] = child_split.key;
+    std::copy(node->keys + index, node->keys + INNER_KEYS, keys + index + 1);
+    std::copy(node->children, node->children + index + 1, children);
+    children[index + 1] = child_split.node;
+    std::copy(node->children + index + 1, node->children + INNER_KEYS + 1, children + index + 2);
+
+    const int middle = (INNER_KEYS + 1) / 2;
+    InnerNode *right = new InnerNode();
+    node->num_keys = middle;
+    std::copy(keys, keys + middle, node->keys);
+    std::copy(children, children + middle + 1, node->children);
+    right->num_keys = INNER_KEYS - middle;
+    std::copy(keys + middle + 1, keys + INNER_KEYS + 1, right->keys);
+    std::copy(children + middle + 1, children + INNER_KEYS + 2, right->children);
+
+    split->key = keys[middle];
+    split->node = right;
+    return true;
+}
+
+bool BPlusTree::insert(void *node, int depth, uint32_t key, const Version &version, uint64_t newest_snapshot,
+                       Split *split) {
+    if (depth == height - 1) {
+        return insert_into_leaf((LeafNode *)node, key, version, newest_snapshot, split);
+    }
+    InnerNode *inner_node = (InnerNode *)node;
+    int index = find_child(inner_node, key);
+    Split child_split;
+    if (!insert(inner_node->children[index], depth + 1, key, version, newest_snapshot, &child_split)) {
+        return false;
+    }
+    return insert_into_inner_node(inner_node, index, child_split, split);
+}
+
+void BPlusTree::put(uint32_t key, uint32_t value, EntryType type, uint64_t sequence, uint64_t newest_snapshot) {
+    if (root == nullptr) {
+        root = new LeafNode();
+        height = 1;
+    }
+    Split split;
+    if (insert(root, 0, key, {value, type, sequence, nullptr}, newest_snapshot, &split)) {
+        // the tree grows by a new root above the two halves of the old one
+        InnerNode *new_root = new InnerNode();
+        new_root->num_keys = 1;
+        new_root->keys[0] = split.key;
+        new_root->children[0] = root;
+        new_root->children[1] = split.node;
+        root = new_root;
+        height++;
+    }
+}
+
+bool BPlusTree::get(uint32_t key, uint32_t *value, EntryType *type, uint64_t max_sequence) {
+    if (root == nullptr) {
+        return false;
+    }
+    const LeafNode *leaf = find_leaf(key);
+    int index = PageSearch::lower_bound(leaf->keys, leaf->num_keys, key);
+    if (index == leaf->num_keys || leaf->keys[index] != key) {
+        return false;
+    }
+    const Version *version = get_version(&leaf->versions[index], max_sequence);
+    if (version == nullptr) {
+        return false;
+    }
+    *value = version->value;
+    *type = version->type;
+    return true;
+}
+
+void BPlusTree::scan(uint32_t start_key, uint32_t end_key,
+                     const std::function<void(uint32_t, uint32_t, EntryType)> &visit, uint64_t max_sequence) {
+    if (root == nullptr) {
+        return;
+    }
+    const LeafNode *leaf = find_leaf(start_key);
+    int index = PageSearch::lower_bound(leaf->keys, leaf->num_keys, start_key);
+    // the leaves after the first one are read in order through their links
+    for (; leaf != nullptr; leaf = leaf->next, index = 0) {
+        for (; index < leaf->num_keys; index++) {
+            if (leaf->keys[index] > end_key) {
+                return;
+            }
+            const Version *version = get_version(&leaf->versions[index], max_sequence);
+            if (version != nullptr) {
+                visit(leaf->keys[index], version->value, version->type);
+            }
+        }
+    }
+}
+
+bool BPlusTree::empty() const { return root == nullptr; }
+
+void BPlusTree::clear_node(void *node, int depth) {
+    if (depth == height - 1) {
+        LeafNode *leaf = (LeafNode *)node;
+        for (int i = 0; i < leaf->num_keys; i++) {
+            Version *version = leaf->versions[i].older_version;
+            while (version != nullptr) {
+                Version *older = version->older_version;
+                delete version;
+                version = older;
+            }
+        }
+        delete leaf;
+        return;
+    }
+    InnerNode *inner_node = (InnerNode *)node;
+    for (int i = 0; i <= inner_node->num_keys; i++) {
+        clear_node(inner_node->children[i], depth + 1);
+    }
+    delete inner_node;
+}
+
+void BPlusTree::clear() {
+    if (root != nullptr) {
+        clear_node(root, 0);
+    }
+    root = nullptr;
+    height = 0;
+}
+
+int BPlusTree::get_height() const { return height; }
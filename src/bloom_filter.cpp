@@ -1,33 +1,122 @@
 #include "bloom_filter.hpp"
 
+#include <algorithm>
 #include <cmath>
 #include <string>
 
 #include "xxhash.h"
 
-BloomFilter::BloomFilter(int m, int num_entries) {
-    this->total_bits = m * num_entries >= MAX_BITMAP_SIZE ? MAX_BITMAP_SIZE : m * num_entries;
-    for (int i = 0; i < total_bits; i++) {
-        this->bitmap[i] = 0;
-    }
+namespace {
+
+// bit of a page of the filter for the i-th hash function of a key, by double hashing
+inline int get_bit(uint64_t hash, int i, int bits_per_page) {
+    uint32_t h1 = (uint32_t)hash;
+    uint32_t h2 = (uint32_t)(hash >> 32) | 1;
+    return (h1 + i * h2) % bits_per_page;
+}
+
+}  // namespace
+
+BloomFilter::BloomFilter(double m, int64_t num_entries) {
+    int64_t total_bits = m * num_entries;
+    // the bits are spread evenly over the pages, so that every page has the same false positive rate
+    num_pages = (total_bits + MAX_BITS_PER_PAGE - 1) / MAX_BITS_PER_PAGE;
+    bits_per_page = num_pages == 0 ? 0 : (total_bits + num_pages - 1) / num_pages;
+    bits.assign((int64_t)num_pages * Utils::PAGE_SIZE, 0);
     // compute optimal number of hash functions
-    this->hash_functions = std::round(std::log(2) * m);
+    // a filter without bits has no hash functions, so every lookup is a (false) positive
+    num_hash_functions = num_pages == 0 ? 0 : std::max(1, (int)std::round(std::log(2) * m));
 }
 
 void BloomFilter::insert(uint32_t key) {
-    // we simulate different hash functions by choosing a different seed for each one
-    for (int i = 0; i < this->hash_functions; i++) {
-        this->bitmap[this->hash(key, i)] = 1;
+    if (num_pages == 0) {
+        return;
+    }
+    uint8_t* page = bits.data() + (int64_t)get_page_index(key, num_pages) * Utils::PAGE_SIZE;
+    uint64_t hash = XXH64(&key, sizeof(uint32_t), 1);
+    for (int i = 0; i < num_hash_functions; i++) {
+        int bit = get_bit(hash, i, bits_per_page);
+        page[bit / 8] |= 1 << (bit % 8);
     }
 }
 
-bool BloomFilter::get(uint32_t key) {
-    for (int i = 0; i < this->hash_functions; i++) {
-        if (this->bitmap[this->hash(key, i)] == 0) {
+bool BloomFilter::get(uint32_t key) const {
+    if (num_pages == 0) {
+        return true;
+    }
+    return page_may_contain(get_page(get_page_index(key, num_pages)), key, bits_per_page, num_hash_functions);
+}
+
+int BloomFilter::get_num_pages() const { return num_pages; }
+
+int BloomFilter::get_bits_per_page() const { return bits_per_page; }
+
+int BloomFilter::get_num_hash_functions() const { return num_hash_functions; }
+
+const char* BloomFilter::get_page(int page) const {
+    return (const char*)bits.data() + (int64_t)page * Utils::PAGE_SIZE;
+}
+
+int BloomFilter::get_page_index(uint32_t key, int num_pages) {
+    // the page is taken from another hash than the bits, scaled to the number of pages
+    uint64_t hash = XXH64(&key, sizeof(uint32_t), 0);
+    return ((hash >> 32) * num_pages) >> 32;
+}
+
+bool BloomFilter::page_may_contain(const char* page, uint32_t key, int bits_per_page, int num_hash_functions) {
+    uint64_t hash = XXH64(&key, sizeof(uint32_t), 1);
+    for (int i = 0; i < num_hash_functions; i++) {
+        int bit = get_bit(hash, i, bits_per_page);
+        if ((page[bit / 8] & (1 << (bit % 8))) == 0) {
             return false;
         }
     }
     return true;
 }
 
-int BloomFilter::hash(uint32_t key, int seed) { return XXH64(&key, sizeof(uint32_t), seed) % this->total_bits; }
+std::vector<double> BloomFilter::get_optimal_bits_per_entry(const std::vector<double>& entries_per_level,
+                                                            double total_bits) {
+    // With b bits per entry a level has a false positive rate p = e^(-b * ln(2)^2).
+    // Minimizing sum(p_i) subject to sum(n_i * b_i) = total_bits gives p_i = c * n_i,
+    // i.e. deeper (larger) levels get a proportionally higher false positive rate.
+    // Plugging p_i back into the budget: ln(c) = -(total_bits * ln(2)^2 + sum(n_i * ln(n_i))) / sum(n_i).
+    // Levels where p_i would reach 1 get no filter at all, and the budget is re-solved for the others.
+    const double ln2_squared = std::log(2) * std::log(2);
+    int num_levels = entries_per_level.size();
+    std::vector<double> bits_per_entry(num_levels, 0);
+    std::vector<bool> has_filter(num_levels);
+    for (int i = 0; i < num_levels; i++) {
+        has_filter[i] = entries_per_level[i] > 0;
+    }
+
+    while (true) {
+        double sum_entries = 0;
+        double sum_entries_log_entries = 0;
+        for (int i = 0; i < num_levels; i++) {
+            if (has_filter[i]) {
+                sum_entries += entries_per_level[i];
+                sum_entries_log_entries += entries_per_level[i] * std::log(entries_per_level[i]);
+            }
+        }
+        if (sum_entries == 0) {
+            return bits_per_entry;
+        }
+
+        double log_c = -(total_bits * ln2_squared + sum_entries_log_entries) / sum_entries;
+        bool dropped_level = false;
+        for (int i = 0; i < num_levels; i++) {
+            if (has_filter[i] && log_c + std::log(entries_per_level[i]) >= 0) {
+                has_filter[i] = false;
+                dropped_level = true;
+            }
+        }
+        if (!dropped_level) {
+            for (int i = 0; i < num_levels; i++) {
+                if (has_filter[i]) {
+                    bits_per_entry[i] = -(log_c + std::log(entries_per_level[i])) / ln2_squared;
+                }
+            }
+            return bits_per_entry;
+        }
+    }
+}
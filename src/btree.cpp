@@ -1,488 +1,591 @@
 #include "btree.hpp"
 
 #include <algorithm>
-#include <cmath>
+#include <cstring>
 #include <filesystem>
 #include <fstream>
+#include <memory>
+#include <stdexcept>
 #include <vector>
 
 #include "bloom_filter.hpp"
+#include "compressed_cache.hpp"
+#include "compression.hpp"
 #include "kv_store.hpp"
+#include "learned_index.hpp"
+#include "packed_leaf.hpp"
+#include "page_search.hpp"
+#include "range_filter.hpp"
+#include "sst_builder.hpp"
+#include "sst_iterator.hpp"
 #include "utils.hpp"
 
-// Function to convert AVL tree to sorted list of leaf nodes
-// basically we keep adding key-value pairs to a leaf node
-// once the leaf node is full, we move on to the next one
-void BTreeNode::extract_leaf_nodes_from_avl(Node* root, std::vector<BTreeNode*>& leaf_nodes) {
+double SSTOptions::get_bits_per_entry(int level) const {
+    if (level_bits_per_entry.empty()) {
+        return DEFAULT_BITS_PER_ENTRY;
+    }
+    return level_bits_per_entry[std::min(level, (int)level_bits_per_entry.size() - 1)];
+}
+
+// Function to convert AVL tree to sorted list of entries
+void BTreeNode::extract_entries_from_avl(Node* root, std::vector<TypedEntry>& entries, uint64_t max_sequence) {
     if (root == nullptr) {
         return;
     }
-
-    extract_leaf_nodes_from_avl(root->left, leaf_nodes);
-
-    // if leaf nodes vector is empty, or the current B tree node we are inserting
-    // to is full
-    //  we need to make a new B tree node
-    if (leaf_nodes.empty() || leaf_nodes.back()->num_keys == BTreeNode::MAX_KEYS) {
-        leaf_nodes.push_back(new BTreeNode());
+    extract_entries_from_avl(root->left, entries, max_sequence);
+    const Node* version = root->get_version(max_sequence);
+    if (version != nullptr) {
+        entries.push_back({version->key, version->value, version->type});
     }
-    BTreeNode* leaf_node = leaf_nodes.back();
-
-    leaf_node->entries[leaf_node->num_keys].key = root->key;
-    leaf_node->entries[leaf_node->num_keys].value = root->value;
-    leaf_node->num_keys++;
-    leaf_node->is_leaf = true;
-
-    extract_leaf_nodes_from_avl(root->right, leaf_nodes);
+    extract_entries_from_avl(root->right, entries, max_sequence);
 }
 
-int get_total_number_of_nodes(int num_of_leaf_nodes) {
-    if (num_of_leaf_nodes == 1) {
-        // this ensures that there is always a root node
-        return 2;
+bool BTreeNode::search_value_by_key(uint32_t key, std::filesystem::path file_path, BufferPool* buffer_pool,
+                                    uint32_t* value, EntryType* type, const LearnedIndex* learned_index,
+                                    const FilterLayout* filter_layout) {
+    SSTReader reader(buffer_pool);
+
+    // root node offset is 1, it is only read here if it tells where the bloom filter is
+    const BTreeNode* root = nullptr;
+    FilterLayout root_filter_layout;
+    if (filter_layout == nullptr) {
+        root = find_node(file_path, &reader, 1, buffer_pool, nullptr, PageType::INDEX);
+        root_filter_layout = root->get_filter_layout();
+        filter_layout = &root_filter_layout;
     }
-    int current_level_node_count = num_of_leaf_nodes;
-    int total_number_of_nodes = num_of_leaf_nodes;
-    while (current_level_node_count > 1) {
-        // the number of internal nodes of the next level is ceil(number of children
-        // / (MAX + 1)) note that we add 1 to MAX because of how delimiter works
-        current_level_node_count = std::ceil(current_level_node_count / (BTreeNode::MAX_KEYS + 1.0));
-        total_number_of_nodes += current_level_node_count;
+    if (!filter_may_contain(key, file_path, &reader, buffer_pool, *filter_layout)) {
+        return false;
     }
-    return total_number_of_nodes;
-}
 
-// Function to build internal nodes from a list of leaf nodes, and also write
-// them to file simultaneously
-BTreeNode* BTreeNode::construct_internal_nodes_and_write_to_file(std::vector<BTreeNode*>& leaf_nodes,
-                                                                 std::ofstream file) {
-    // bloom filter
-    BloomFilter filter(5, leaf_nodes.size());  // Number of bits in the bloom filter = 5
-    for (BTreeNode* node : leaf_nodes) {
-        for (int i = 0; i < node->num_keys; i++) {
-            filter.insert(node->entries[i].key);
+    const char* leaf_page;
+
+    if (learned_index != nullptr) {
+        // the model gives the leaf directly, it is only written for plain uncompressed leaves
+        int offset;
+        leaf_page =
+            (const char*)find_leaf_with_learned_index(key, file_path, &reader, buffer_pool, learned_index, &offset);
+    } else {
+        if (root == nullptr) {
+            root = find_node(file_path, &reader, 1, buffer_pool, nullptr, PageType::INDEX);
         }
-    }
-    file.seekp(0);
-    file.write((char*)&filter, sizeof(BloomFilter));
-
-    // get total number of nodes
-    // this is because we are processing nodes starting from the leaves, and then
-    // all the way up to the root since the root must be at offset 0, the leaf
-    // nodes must be at the maximum offset therefore, we need to compute the total
-    // number of nodes to get the maximum offset
-    int num_of_leaf_nodes = leaf_nodes.size();
-    int total_number_of_nodes = get_total_number_of_nodes(num_of_leaf_nodes);
-    int node_offset = total_number_of_nodes;
-
-    for (BTreeNode* node : leaf_nodes) {
-        node->file_offset = node_offset;
-        node_offset--;
-
-        // make sure nodes are page aligned
-        file.seekp(Utils::PAGE_SIZE * node->file_offset);
-        file.write((char*)node, sizeof(BTreeNode));
-    }
-    // we process all of the leaf nodes in order to create one level
-    // we add all of the internal nodes of that level into result
-    // then we check if the size of result == 1, if so we have reached the root
-    // and we're done, otherwise we process result recursively
-    std::vector<BTreeNode*> queue = leaf_nodes;
-
-    while (true) {
-        std::vector<BTreeNode*> result;
-        while (!queue.empty()) {
-            // Create a new internal node
-            BTreeNode* internal_node = new BTreeNode();
-            // because of how delimiters work, a node can have at most MAX_KEYS + 1
-            // children
-            int n = std::min(BTreeNode::MAX_KEYS + 1, (int)queue.size());
-            // note that we are still adding the last child node because we need the
-            // offset
-            for (int i = 0; i < n; i++) {
-                BTreeNode* node = queue[i];
-                // get the largest/right-most key of the child node
-                internal_node->entries[i].key = node->entries[node->num_keys - 1].key;
-                internal_node->entries[i].value = node->file_offset;
+        const BTreeNode* node = root;
+        int last_leaf_offset = root->num_of_leaf_nodes + 1;
+        int offset;
+        // Continue searching until the leaf is found or search concludes
+        while (true) {
+            // If the node has no keys, the search is unsuccessful
+            if (node->num_keys == 0) {
+                return false;
             }
-            internal_node->num_keys = n;
-            // pop from queue
-            for (int i = 0; i < n; i++) {
-                queue.erase(queue.begin());
+            // For internal nodes, the child to follow is the first one whose largest key is >= key.
+            // If there is none, the key is larger than every key of the SST
+            int index = node->lower_bound(key);
+            if (index == node->num_keys) {
+                return false;
             }
-
-            internal_node->file_offset = node_offset;
-            node_offset--;
-
-            // make sure nodes are page aligned
-            // note that the root should have an offset of exactly one page (because
-            // the first page stores the bloom filter)
-            file.seekp(Utils::PAGE_SIZE * internal_node->file_offset);
-            file.write((char*)internal_node, sizeof(BTreeNode));
-
-            result.push_back(internal_node);
+            offset = node->values[index];
+            // leaves are the pages right after the root
+            if (offset <= last_leaf_offset) {
+                break;
+            }
+            node = find_node(file_path, &reader, offset, buffer_pool, root, PageType::INDEX);
         }
-        if (result.size() == 1) {
-            // write metadata to root node
-            BTreeNode* root = result.front();
-            root->total_number_of_nodes = total_number_of_nodes;
-            root->num_of_leaf_nodes = num_of_leaf_nodes;
-            file.seekp(Utils::PAGE_SIZE);
-            file.write((char*)root, sizeof(BTreeNode));
-            return result.front();
+        leaf_page = find_leaf(file_path, &reader, offset, buffer_pool, root);
+        if (root->leaf_format == LeafFormat::PACKED) {
+            // the packed keys are searched without unpacking the page
+            const PackedLeaf* leaf = (const PackedLeaf*)leaf_page;
+            int index = leaf->lower_bound(key);
+            if (index < leaf->num_keys && leaf->get_key(index) == key) {
+                *value = leaf->get_value(index);
+                *type = leaf->get_type(index);
+                return true;
+            }
+            return false;
         }
-        queue = result;
-    }
-}
-
-uint32_t BTreeNode::search_value_by_key(uint32_t key, std::filesystem::path file_path, BufferPool* buffer_pool) {
-    std::ifstream file;
-
-    // bloom filter
-    BloomFilter* filter;
-    std::string filter_id = Page::generate_page_id(file_path, 0);
-    const char* page_data = buffer_pool->get(filter_id);
-    if (page_data == nullptr) {
-        // not in buffer pool, we have to access the file
-        if (!file.is_open()) {
-            file.open(file_path, std::ios::binary | std::ios::in);
+        if (root->leaf_format == LeafFormat::HASHED) {
+            // one or two probes of the hash index instead of a binary search
+            const BTreeNode* leaf = (const BTreeNode*)leaf_page;
+            int index = leaf->find_with_hash_index(key);
+            if (index < 0) {
+                return false;
+            }
+            *value = leaf->values[index];
+            *type = leaf->types[index];
+            return true;
         }
-        page_data = new char[Utils::PAGE_SIZE];
-        file.seekg(0);
-        file.read((char*)page_data, sizeof(BloomFilter));
-        // add to buffer pool
-        buffer_pool->insert(filter_id, page_data);
     }
-    filter = (BloomFilter*)page_data;
-    if (!filter->get(key)) {
-        return Utils::INVALID_VALUE;
+
+    const BTreeNode* leaf = (const BTreeNode*)leaf_page;
+    int index = leaf->lower_bound(key);
+    if (index < leaf->num_keys && leaf->keys[index] == key) {
+        *value = leaf->values[index];
+        *type = leaf->types[index];
+        return true;
     }
+    // Key not found in the leaf node
+    return false;
+}
 
-    BTreeNode* node;
-    int offset = 1;  // root node offset is 1
+std::unique_ptr<LearnedIndex> BTreeNode::read_learned_index(std::filesystem::path file_path) {
+    std::ifstream file(file_path, std::ios::binary);
+    BTreeNode* root = new BTreeNode();
+    file.seekg(Utils::PAGE_SIZE);
+    file.read((char*)root, sizeof(BTreeNode));
+    if (root->num_learned_index_blocks == 0) {
+        delete root;
+        return nullptr;
+    }
 
-    // Continue searching until the correct node is found or search concludes
-    while (true) {
-        node = find_node(file_path, &file, offset, buffer_pool);
+    std::vector<LearnedIndex::Block> blocks(root->num_learned_index_blocks);
+    int first_block_offset = root->total_number_of_nodes + 1 + root->num_range_filter_blocks;
+    file.seekg(Utils::PAGE_SIZE * root->get_page_in_file(first_block_offset));
+    file.read((char*)blocks.data(), sizeof(LearnedIndex::Block) * blocks.size());
+    delete root;
+    return std::make_unique<LearnedIndex>(LearnedIndex::from_blocks(blocks));
+}
 
-        // If the node has no keys, the search is unsuccessful
-        if (node->num_keys == 0) {
-            return Utils::INVALID_VALUE;
-        }
+std::vector<RangeTombstone> BTreeNode::read_range_tombstones(std::filesystem::path file_path) {
+    std::ifstream file(file_path, std::ios::binary);
+    BTreeNode* root = new BTreeNode();
+    file.seekg(Utils::PAGE_SIZE);
+    file.read((char*)root, sizeof(BTreeNode));
+    std::vector<Entry> entries(root->num_range_tombstones);
+    if (!entries.empty()) {
+        int first_block_offset = root->total_number_of_nodes + 1 + root->num_range_filter_blocks +
+                                 root->num_learned_index_blocks + root->num_block_index_blocks;
+        file.seekg(Utils::PAGE_SIZE * root->get_page_in_file(first_block_offset));
+        file.read((char*)entries.data(), sizeof(Entry) * entries.size());
+    }
+    delete root;
 
-        // If the current node is a leaf, perform binary search
-        if (node->is_leaf) {
-            int low = 0, high = node->num_keys - 1;
-            while (low <= high) {
-                int mid = low + (high - low) / 2;
-                // Check if the mid value matches the key
-                if (node->entries[mid].key == key) {
-                    return node->entries[mid].value;
-                } else if (node->entries[mid].key < key) {
-                    low = mid + 1;
-                } else {
-                    high = mid - 1;
-                }
-            }
-            // Key not found in the leaf node
-            return Utils::INVALID_VALUE;
-        } else {
-            // For internal nodes, find the correct child to follow
-            bool is_key_included = false;
-
-            int low = 0, high = node->num_keys - 1;
-            while (low <= high) {
-                int mid = low + (high - low) / 2;
-                // Choose the child node whose range includes the key
-                if (node->entries[mid].key >= key) {
-                    if (mid == 0 || node->entries[mid - 1].key < key) {
-                        offset = node->entries[mid].value;
-                        is_key_included = true;
-                        break;
-                    }
-                    high = mid - 1;
-                } else {
-                    low = mid + 1;
-                }
-            }
-            // If no appropriate child is found, the key is not present
-            if (!is_key_included) {
-                return Utils::INVALID_VALUE;
-            }
-        }
+    std::vector<RangeTombstone> tombstones;
+    for (const Entry& entry : entries) {
+        tombstones.push_back({entry.key, entry.value});
     }
+    return tombstones;
 }
 
-void BTreeNode::read_leaf_nodes_from_file(std::ifstream& file, int offset, std::vector<BTreeNode*>& leaf_nodes) {
+BTreeNode::FilterLayout BTreeNode::read_filter_layout(std::filesystem::path file_path) {
+    std::ifstream file(file_path, std::ios::binary);
+    BTreeNode* root = new BTreeNode();
+    file.seekg(Utils::PAGE_SIZE);
+    file.read((char*)root, sizeof(BTreeNode));
+    FilterLayout filter_layout = root->get_filter_layout();
+    delete root;
+    return filter_layout;
+}
+
+void BTreeNode::read_key_range(std::filesystem::path file_path, uint32_t* min_key, uint32_t* max_key) {
+    std::ifstream file(file_path, std::ios::binary);
     BTreeNode* node = new BTreeNode();
-    file.seekg(Utils::PAGE_SIZE * offset);
-    file.read(reinterpret_cast<char*>(node), sizeof(BTreeNode));
+    *min_key = Utils::INVALID_VALUE;
+    *max_key = 0;
+
+    // the last delimiter of the root is the largest key of the SST
+    file.seekg(Utils::PAGE_SIZE);
+    file.read((char*)node, sizeof(BTreeNode));
+    if (node->num_keys > 0) {
+        *max_key = node->keys[node->num_keys - 1];
+    }
 
-    if (node->is_leaf) {
-        leaf_nodes.push_back(node);
-    } else {
-        for (int i = 0; i < node->num_keys; ++i) {
-            int child_offset = node->entries[i].value;
-            read_leaf_nodes_from_file(file, child_offset, leaf_nodes);
-        }
-        delete node;
+    delete node;
+
+    // the first leaf may be packed or compressed, the iterator reads it in any format
+    SSTIterator iterator(file_path);
+    if (iterator.valid()) {
+        *min_key = iterator.key();
     }
 }
 
 void BTreeNode::merge_ssts(std::filesystem::path old_sst_path, std::filesystem::path new_sst_path,
-                           std::filesystem::path output_path, bool is_last_level) {
-    std::ifstream old_sst(old_sst_path, std::ios::binary);
-    std::ifstream new_sst(new_sst_path, std::ios::binary);
-    std::ofstream output(output_path, std::ios::binary);
-    // write leaf nodes to a temp file
-    std::filesystem::path temp_path = output_path.replace_extension(".tmp");
-    std::ofstream temp_output(temp_path, std::ios::binary);
-
-    // get the root nodes
-    BTreeNode* old_root = new BTreeNode();
-    old_sst.seekg(Utils::PAGE_SIZE);
-    old_sst.read((char*)old_root, sizeof(BTreeNode));
-    BTreeNode* new_root = new BTreeNode();
-    new_sst.seekg(Utils::PAGE_SIZE);
-    new_sst.read((char*)new_root, sizeof(BTreeNode));
-
-    // we need to know exactly the total number of nodes in order to determine the
-    // correct offset to write the leaf nodes but we can't know that in advance
-    // unless we iterate through all of the nodes because there could be updates
-    // and deletes therefore, we write to a temp file (from the beginning) in
-    // order to get the number of leaf nodes
-    int offset = 0;
-    int old_offset = old_root->total_number_of_nodes;
-    int new_offset = new_root->total_number_of_nodes;
-    int old_min_offset = old_root->total_number_of_nodes - old_root->num_of_leaf_nodes + 1;
-    int new_min_offset = new_root->total_number_of_nodes - new_root->num_of_leaf_nodes + 1;
-    BTreeNode* old_node = new BTreeNode();
-    old_sst.seekg(Utils::PAGE_SIZE * old_offset);
-    old_sst.read((char*)old_node, sizeof(BTreeNode));
-    int old_index = 0;
-    BTreeNode* new_node = new BTreeNode();
-    new_sst.seekg(Utils::PAGE_SIZE * new_offset);
-    new_sst.read((char*)new_node, sizeof(BTreeNode));
-    int new_index = 0;
-    BTreeNode* output_node = new BTreeNode();
-    int output_index = 0;
-    BTreeNode::Entry invalid_entry = {Utils::INVALID_VALUE, Utils::INVALID_VALUE};
-    while (true) {
-        // an invalid entry is used if we ran out of leaf nodes for one of them
-        BTreeNode::Entry old_entry = old_index >= old_node->num_keys ? invalid_entry : old_node->entries[old_index];
-        BTreeNode::Entry new_entry = new_index >= new_node->num_keys ? invalid_entry : new_node->entries[new_index];
-        if (old_entry.value == Utils::TOMB_STONE && is_last_level && (new_entry.key == old_entry.key)) {
-            // When tombstones reach the largest level of the LSM-tree, they should be removed,
-            // as at this point there are no longer any older versions of the entry in existence
-            // for them to mask.
-            old_index++;
-            new_index++;
-        } else if (old_entry.key == Utils::INVALID_VALUE) {
-            output_node->entries[output_index].key = new_entry.key;
-            output_node->entries[output_index].value = new_entry.value;
-            new_index++;
-        } else if (new_entry.key == Utils::INVALID_VALUE) {
-            output_node->entries[output_index].key = old_entry.key;
-            output_node->entries[output_index].value = old_entry.value;
-            old_index++;
-        } else if (new_entry.key < old_entry.key) {
-            output_node->entries[output_index].key = new_entry.key;
-            output_node->entries[output_index].value = new_entry.value;
-            new_index++;
-        } else if (new_entry.key > old_entry.key) {
-            output_node->entries[output_index].key = old_entry.key;
-            output_node->entries[output_index].value = old_entry.value;
-            old_index++;
+                           std::filesystem::path output_path, bool is_last_level, const SSTOptions& options,
+                           int level) {
+    uint32_t old_min_key;
+    uint32_t old_max_key;
+    uint32_t new_min_key;
+    uint32_t new_max_key;
+    read_key_range(old_sst_path, &old_min_key, &old_max_key);
+    read_key_range(new_sst_path, &new_min_key, &new_max_key);
+    // both SSTs are read leaf by leaf, and the output is streamed to its file
+    SSTIterator old_sst(old_sst_path, options.rate_limiter);
+    SSTIterator new_sst(new_sst_path, options.rate_limiter);
+    SSTBuilder output(output_path, options, level, old_sst.get_num_entries() + new_sst.get_num_entries());
+    // SSTs whose key ranges do not overlap, e.g. those of sequential writes, have nothing to merge: their leaves
+    // are copied back to back. At the last level the entries are rewritten, to drop deletions and apply operands.
+    bool is_old_first = old_max_key < new_min_key;
+    if (!is_last_level && (is_old_first || new_max_key < old_min_key) && output.can_append_leaves(old_sst_path) &&
+        output.can_append_leaves(new_sst_path)) {
+        output.append_leaves(is_old_first ? old_sst_path : new_sst_path);
+        output.append_leaves(is_old_first ? new_sst_path : old_sst_path);
+        output.finish();
+        return;
+    }
+    // the range tombstones of the new SST delete entries of the old one, those of both delete entries of the
+    // SSTs older than the output
+    std::vector<RangeTombstone> new_tombstones = read_range_tombstones(new_sst_path);
+    std::vector<RangeTombstone> tombstones = read_range_tombstones(old_sst_path);
+    tombstones.insert(tombstones.end(), new_tombstones.begin(), new_tombstones.end());
+    tombstones = RangeTombstone::coalesce(tombstones);
+    while (old_sst.valid() || new_sst.valid()) {
+        uint32_t key;
+        uint32_t value;
+        EntryType type;
+        if (old_sst.valid() && RangeTombstone::covers(new_tombstones, old_sst.key())) {
+            old_sst.next();
+            continue;
+        }
+        if (!old_sst.valid() || (new_sst.valid() && new_sst.key() <= old_sst.key())) {
+            key = new_sst.key();
+            value = new_sst.value();
+            type = new_sst.type();
+            if (old_sst.valid() && key == old_sst.key()) {
+                // they have the same key, always prefer the new one, unless it is a merge operand that applies
+                // to the old one
+                if (type == EntryType::MERGE) {
+                    if (old_sst.type() == EntryType::VALUE || old_sst.type() == EntryType::MERGE) {
+                        value = MergeOperator::apply(options.merge_operator, old_sst.value(), value);
+                        type = old_sst.type();
+                    } else {
+                        // a deletion (or a blob) leaves no value to merge with
+                        type = EntryType::VALUE;
+                    }
+                }
+                old_sst.next();
+            }
+            new_sst.next();
         } else {
-            // they have the same key, always prefer the new one
-            output_node->entries[output_index].key = new_entry.key;
-            output_node->entries[output_index].value = new_entry.value;
-            new_index++;
-            old_index++;
+            key = old_sst.key();
+            value = old_sst.value();
+            type = old_sst.type();
+            old_sst.next();
         }
-        // check if we have exhausted the entries for a node
-        // we also check if we have gone through all leaf nodes already
-        if (old_index >= old_node->num_keys && old_offset > old_min_offset) {
-            old_offset--;
-            old_sst.seekg(Utils::PAGE_SIZE * old_offset);
-            old_sst.read((char*)old_node, sizeof(BTreeNode));
-            old_index = 0;
+        // When tombstones reach the largest level of the LSM-tree, they should be removed,
+        // as at this point there are no longer any older versions of the entry in existence
+        // for them to mask.
+        // Likewise, merge operands left at the largest level, or in a deleted range, have no older value to
+        // apply to, and a deletion in a deleted range is not needed.
+        bool is_covered = RangeTombstone::covers(tombstones, key);
+        if (type == EntryType::MERGE && (is_last_level || is_covered)) {
+            type = EntryType::VALUE;
         }
-        if (new_index >= new_node->num_keys && new_offset > new_min_offset) {
-            new_offset--;
-            new_sst.seekg(Utils::PAGE_SIZE * new_offset);
-            new_sst.read((char*)new_node, sizeof(BTreeNode));
-            new_index = 0;
+        if (type != EntryType::DELETION || (!is_last_level && !is_covered)) {
+            output.add(key, value, type);
         }
-        output_index++;
-        // check if we have filled up a node, or we are done
-        //  if we are done, both indexes would be 0
-        bool done = old_index >= old_node->num_keys && new_index >= new_node->num_keys;
-        if (output_index >= BTreeNode::MAX_KEYS || done) {
-            output_node->num_keys = output_index;
-            output_node->is_leaf = true;
-            // output_node->file_offset = offset;
-            temp_output.seekp(Utils::PAGE_SIZE * offset);
-            temp_output.write((char*)output_node, sizeof(BTreeNode));
-            offset++;
-            if (done) {
-                break;
-            }
-            output_node = new BTreeNode();
-            output_index = 0;
+    }
+    if (!is_last_level) {
+        for (const RangeTombstone& tombstone : tombstones) {
+            output.add_range_tombstone(tombstone.start_key, tombstone.end_key);
         }
     }
-    temp_output.close();
-
-    // offset now holds the number of leaf nodes/pages
-    int num_of_leaf_nodes = offset;
-    int total_number_of_nodes = get_total_number_of_nodes(num_of_leaf_nodes);
-    // bloom filter
-    BloomFilter filter(5, num_of_leaf_nodes);
-    // now read the nodes back from the temp file
-    std::ifstream temp_input(temp_path, std::ios::binary);
-    offset = total_number_of_nodes;  // we write the leaf nodes backwards
-    int input_offset = 0;
-    std::vector<BTreeNode::Entry> queue;  // we only need to know the largest key and its node's offset (to
-                                          // save memory)
-    // write leaf nodes from temp file to merge output file
-    while (input_offset < num_of_leaf_nodes) {
-        temp_input.seekg(Utils::PAGE_SIZE * input_offset);
-        temp_input.read((char*)output_node, sizeof(BTreeNode));
-        output_node->file_offset = offset;
-        for (int i = 0; i < output_node->num_keys; i++) {
-            filter.insert(output_node->entries[i].key);
+    output.finish();
+}
+
+int BTreeNode::lower_bound(uint32_t key) const { return PageSearch::lower_bound(keys, num_keys, key); }
+
+namespace {
+
+// bucket of a key in the hash index of a leaf, multiplicative hashing scaled to the number of buckets
+inline int get_hash_bucket(uint32_t key) {
+    return ((uint64_t)(key * 2654435761u) * BTreeNode::HASH_BUCKETS) >> 32;
+}
+
+}  // namespace
+
+void BTreeNode::build_hash_index() {
+    uint8_t* buckets = (uint8_t*)(values + HASHED_MAX_KEYS);
+    std::memset(buckets, 0, HASH_BUCKETS);
+    for (int i = 0; i < num_keys; i++) {
+        uint8_t slot = 1 + i / 2;
+        int bucket = get_hash_bucket(keys[i]);
+        // both keys of a pair can share a bucket
+        while (buckets[bucket] != 0 && buckets[bucket] != slot) {
+            bucket = bucket + 1 == HASH_BUCKETS ? 0 : bucket + 1;
         }
-        output.seekp(Utils::PAGE_SIZE * offset);
-        output.write((char*)output_node, sizeof(BTreeNode));
-        BTreeNode::Entry entry = {output_node->entries[output_node->num_keys - 1].key, (uint32_t)offset};
-        queue.push_back(entry);
-        input_offset++;
-        offset--;
-    }
-
-    // write bloom filter
-    output.seekp(0);
-    output.write((char*)&filter, sizeof(BloomFilter));
-
-    // delete temp file
-    std::filesystem::remove(temp_path);
-
-    // build internal nodes based on leaf nodes
-    // we had an in-memory vector (the queue) because we can't read and write to
-    // the same file
-    // reset offset
-    offset = total_number_of_nodes - num_of_leaf_nodes;
-
-    while (true) {
-        std::vector<BTreeNode::Entry> result;
-        BTreeNode* internal_node;
-        while (!queue.empty()) {
-            internal_node = new BTreeNode();
-            BTreeNode::Entry entry;
-            int n = std::min(BTreeNode::MAX_KEYS + 1, (int)queue.size());
-            for (int i = 0; i < n; i++) {
-                entry = queue[i];
-                internal_node->entries[i].key = entry.key;
-                internal_node->entries[i].value = entry.value;
-            }
-            internal_node->num_keys = n;
-            // pop from queue
-            for (int i = 0; i < n; i++) {
-                queue.erase(queue.begin());
-            }
-            internal_node->file_offset = offset;
-            offset--;
-            output.seekp(Utils::PAGE_SIZE * internal_node->file_offset);
-            output.write((char*)internal_node, sizeof(BTreeNode));
-            entry = {internal_node->entries[internal_node->num_keys - 1].key, (uint32_t)internal_node->file_offset};
-            result.push_back(entry);
+        buckets[bucket] = slot;
+    }
+}
+
+int BTreeNode::find_with_hash_index(uint32_t key) const {
+    const uint8_t* buckets = (const uint8_t*)(values + HASHED_MAX_KEYS);
+    int bucket = get_hash_bucket(key);
+    // there are more buckets than entries, so the probe always reaches an empty bucket
+    while (buckets[bucket] != 0) {
+        int index = (buckets[bucket] - 1) * 2;
+        if (keys[index] == key) {
+            return index;
         }
-        if (result.size() == 1) {
-            // we have written the root node, write metadata
-            internal_node->total_number_of_nodes = total_number_of_nodes;
-            internal_node->num_of_leaf_nodes = num_of_leaf_nodes;
-            output.seekp(Utils::PAGE_SIZE);
-            output.write((char*)internal_node, sizeof(BTreeNode));
-            // and then we're done!
-            return;
+        if (index + 1 < num_keys && keys[index + 1] == key) {
+            return index + 1;
         }
-        queue = result;
+        bucket = bucket + 1 == HASH_BUCKETS ? 0 : bucket + 1;
     }
+    return -1;
 }
 
-// find B tree node in either the buffer pool, or by getting its page from the
-// SST directly
-BTreeNode* BTreeNode::find_node(std::filesystem::path file_path, std::ifstream* file, int offset,
-                                BufferPool* buffer_pool) {
+int BTreeNode::get_page_in_file(int offset) const {
+    if (offset <= num_of_leaf_nodes + 1) {
+        return offset;
+    }
+    return offset - num_of_leaf_nodes + num_data_pages;
+}
+
+BTreeNode::FilterLayout BTreeNode::get_filter_layout() const {
+    int num_range_tombstone_blocks = (num_range_tombstones + RANGE_TOMBSTONES_PER_PAGE - 1) / RANGE_TOMBSTONES_PER_PAGE;
+    int second_page_offset = total_number_of_nodes + 1 + num_range_filter_blocks + num_learned_index_blocks +
+                             num_block_index_blocks + num_range_tombstone_blocks;
+    return {num_filter_pages, filter_bits_per_page, num_filter_hash_functions, second_page_offset,
+            get_page_in_file(second_page_offset)};
+}
+
+bool BTreeNode::filter_may_contain(uint32_t key, std::filesystem::path file_path, SSTReader* reader,
+                                   BufferPool* buffer_pool, const FilterLayout& filter_layout) {
+    if (filter_layout.num_pages == 0) {
+        return true;
+    }
+    // the first page is page 0 of the SST, the others are after the range tombstones
+    int page = BloomFilter::get_page_index(key, filter_layout.num_pages);
+    int offset = page == 0 ? 0 : filter_layout.second_page_offset + page - 1;
+    int page_in_file = page == 0 ? 0 : filter_layout.second_page_in_file + page - 1;
+    const char* filter_page =
+        find_page(file_path, reader, offset, page_in_file, buffer_pool, Utils::PAGE_SIZE, PageType::INDEX);
+    return BloomFilter::page_may_contain(filter_page, key, filter_layout.bits_per_page,
+                                         filter_layout.num_hash_functions);
+}
+
+BTreeNode::SSTReader::~SSTReader() {
+    if (!pages.empty()) {
+        buffer_pool->add_num_freed(pages.size());
+    }
+}
+
+void BTreeNode::keep_page(SSTReader* reader, BufferPool* buffer_pool, const std::string& page_id, char* data,
+                          PageType type) {
+    if (!buffer_pool->insert(page_id, data, type)) {
+        reader->pages.emplace_back(data);
+    }
+}
+
+// find a page in either the buffer pool, or by getting it from the SST directly
+const char* BTreeNode::find_page(std::filesystem::path file_path, SSTReader* reader, int offset,
+                                 BufferPool* buffer_pool, std::streamsize size, const BTreeNode* root,
+                                 PageType type) {
+    return find_page(file_path, reader, offset, root != nullptr ? root->get_page_in_file(offset) : offset, buffer_pool,
+                     size, type);
+}
+
+const char* BTreeNode::find_page(std::filesystem::path file_path, SSTReader* reader, int offset, int page_in_file,
+                                 BufferPool* buffer_pool, std::streamsize size, PageType type) {
     std::string page_id = Page::generate_page_id(file_path, offset);
     const char* page_data = buffer_pool->get(page_id);
     if (page_data == nullptr) {
         // not in buffer pool, we have to access the file
-        if (!file->is_open()) {
-            file->open(file_path, std::ios::binary | std::ios::in);
+        if (!reader->file.is_open()) {
+            reader->file.open(file_path, std::ios::binary | std::ios::in);
         }
-        file->seekg(offset * Utils::PAGE_SIZE);
-        page_data = (const char*)(new BTreeNode());
-        file->read((char*)page_data, sizeof(BTreeNode));
-        // add to buffer pool
-        buffer_pool->insert(page_id, page_data);
+        reader->file.seekg(page_in_file * Utils::PAGE_SIZE);
+        std::unique_ptr<char[]> data(new char[Utils::PAGE_SIZE]);
+        reader->file.read(data.get(), size);
+        // a missing or truncated SST must not leave an uninitialized page in the buffer pool
+        if (reader->file.gcount() != size) {
+            throw std::runtime_error("Cannot read page " + page_id);
+        }
+        page_data = data.get();
+        keep_page(reader, buffer_pool, page_id, data.release(), type);
     }
-    return (BTreeNode*)page_data;
+    return page_data;
 }
 
-void BTreeNode::scan(uint32_t start_key, uint32_t end_key, std::filesystem::path file_path, BufferPool* buffer_pool,
-                     std::vector<std::pair<uint32_t, uint32_t>>* result) {
-    std::ifstream file;
-    BTreeNode* node;
-    int offset = 1;  // root node offset is 1
-
-    // Continue searching until the correct node is found or search concludes
-    while (true) {
-        node = find_node(file_path, &file, offset, buffer_pool);
-
-        // we found the node that contains the smallest key that fits in the range
-        if (node->is_leaf) {
-            break;
+BTreeNode* BTreeNode::find_node(std::filesystem::path file_path, SSTReader* reader, int offset,
+                                BufferPool* buffer_pool, const BTreeNode* root, PageType type) {
+    return (BTreeNode*)find_page(file_path, reader, offset, buffer_pool, sizeof(BTreeNode), root, type);
+}
+
+const char* BTreeNode::find_leaf(std::filesystem::path file_path, SSTReader* reader, int offset,
+                                 BufferPool* buffer_pool, const BTreeNode* root) {
+    std::streamsize size = root->leaf_format == LeafFormat::PACKED ? sizeof(PackedLeaf) : sizeof(BTreeNode);
+    if (root->compression == CompressionType::NONE) {
+        return find_page(file_path, reader, offset, buffer_pool, size);
+    }
+    // decompressed leaves are cached in the buffer pool like any other page
+    std::string page_id = Page::generate_page_id(file_path, offset);
+    const char* page_data = buffer_pool->get(page_id);
+    if (page_data != nullptr) {
+        return page_data;
+    }
+
+    // the handle of the block holding the leaf, from the block index after the learned index
+    int leaf = offset - 2;
+    int block = leaf / LEAVES_PER_BLOCK;
+    int handles_offset = root->total_number_of_nodes + 1 + root->num_range_filter_blocks +
+                         root->num_learned_index_blocks + block / HANDLES_PER_PAGE;
+    const BlockHandle* handles =
+        (const BlockHandle*)find_page(file_path, reader, handles_offset, buffer_pool, Utils::PAGE_SIZE, root,
+                                      PageType::INDEX);
+    BlockHandle handle = handles[block % HANDLES_PER_PAGE];
+
+    // the compressed block, from the compressed cache if it is there
+    CompressedCache& compressed_cache = buffer_pool->get_compressed_cache();
+    std::string block_id = CompressedCache::generate_block_id(file_path, block);
+    std::string compressed_block;
+    if (!compressed_cache.get(block_id, &compressed_block)) {
+        if (!reader->file.is_open()) {
+            reader->file.open(file_path, std::ios::binary | std::ios::in);
         }
+        compressed_block.resize(handle.size);
+        reader->file.seekg(Utils::PAGE_SIZE * 2 + (int64_t)handle.offset);
+        reader->file.read(compressed_block.data(), handle.size);
+        if (reader->file.gcount() != (std::streamsize)handle.size) {
+            throw std::runtime_error("Cannot read block " + block_id);
+        }
+        compressed_cache.insert(block_id, compressed_block);
+    }
 
-        // Find the correct child to follow
-        bool is_key_included = false;
-
-        int low = 0, high = node->num_keys - 1;
-        while (low <= high) {
-            int mid = low + (high - low) / 2;
-            // Choose the child node whose range includes the key
-            if (node->entries[mid].key >= start_key) {
-                if (mid == 0 || node->entries[mid - 1].key < start_key) {
-                    offset = node->entries[mid].value;
-                    is_key_included = true;
-                    break;
-                }
-                high = mid - 1;
-            } else {
-                low = mid + 1;
+    int num_leaves = std::min(LEAVES_PER_BLOCK, root->num_of_leaf_nodes - block * LEAVES_PER_BLOCK);
+    std::vector<char> leaves(num_leaves * Utils::PAGE_SIZE);
+    if (!Compression::decompress(compressed_block.data(), compressed_block.size(), leaves.data(), leaves.size())) {
+        throw std::runtime_error("Corrupted block " + block_id);
+    }
+    char* leaf_data = new char[Utils::PAGE_SIZE];
+    std::memcpy(leaf_data, leaves.data() + (leaf % LEAVES_PER_BLOCK) * Utils::PAGE_SIZE, Utils::PAGE_SIZE);
+    keep_page(reader, buffer_pool, page_id, leaf_data);
+    return leaf_data;
+}
+
+BTreeNode* BTreeNode::find_leaf_with_learned_index(uint32_t key, std::filesystem::path file_path, SSTReader* reader,
+                                                   BufferPool* buffer_pool, const LearnedIndex* learned_index,
+                                                   int* offset) {
+    int first_leaf, leaf, last_leaf;
+    learned_index->get_search_window(key, &first_leaf, &leaf, &last_leaf);
+    *offset = learned_index->get_leaf_offset(leaf);
+    BTreeNode* node = find_node(file_path, reader, *offset, buffer_pool);
+    // the prediction is off by at most a few entries, so this is almost always the predicted leaf
+    // or one of its neighbours
+    while (node->num_keys > 0 && key < node->keys[0] && leaf > first_leaf) {
+        leaf--;
+        *offset = learned_index->get_leaf_offset(leaf);
+        node = find_node(file_path, reader, *offset, buffer_pool);
+    }
+    while (node->num_keys > 0 && key > node->keys[node->num_keys - 1] && leaf < last_leaf) {
+        leaf++;
+        *offset = learned_index->get_leaf_offset(leaf);
+        node = find_node(file_path, reader, *offset, buffer_pool);
+    }
+    return node;
+}
+
+bool BTreeNode::range_may_match(uint32_t start_key, uint32_t end_key, std::filesystem::path file_path,
+                                BufferPool* buffer_pool) {
+    SSTReader reader(buffer_pool);
+    BTreeNode* root = find_node(file_path, &reader, 1, buffer_pool, nullptr, PageType::INDEX);
+    int num_blocks = root->num_range_filter_blocks;
+    int first_block_offset = root->total_number_of_nodes + 1;
+    if (num_blocks == 0) {
+        // SST written without a range filter
+        return true;
+    }
+
+    int shift;
+    uint32_t first_prefix, last_prefix;
+    if (!RangeFilter::get_probe_range(start_key, end_key, &shift, &first_prefix, &last_prefix)) {
+        // too wide to be filtered
+        return true;
+    }
+    for (uint32_t prefix = first_prefix;; prefix++) {
+        // consecutive prefixes share a block unless they are in two groups, the buffer pool keeps it
+        int offset = first_block_offset + RangeFilter::get_block_index(prefix, shift, num_blocks);
+        std::string block_id = Page::generate_page_id(file_path, offset);
+        const char* page_data = buffer_pool->get(block_id);
+        if (page_data == nullptr) {
+            // not in buffer pool, we have to access the file
+            if (!reader.file.is_open()) {
+                reader.file.open(file_path, std::ios::binary | std::ios::in);
+            }
+            std::unique_ptr<char[]> data(new char[Utils::PAGE_SIZE]);
+            reader.file.seekg(Utils::PAGE_SIZE * root->get_page_in_file(offset));
+            reader.file.read(data.get(), sizeof(RangeFilter));
+            if (reader.file.gcount() != (std::streamsize)sizeof(RangeFilter)) {
+                throw std::runtime_error("Cannot read page " + block_id);
             }
+            page_data = data.get();
+            keep_page(&reader, buffer_pool, block_id, data.release(), PageType::INDEX);
         }
-        // If no appropriate child is found, the key is not present
-        if (!is_key_included) {
-            return;
+        RangeFilter* block = (RangeFilter*)page_data;
+        if (!block->overlaps(start_key, end_key)) {
+            return false;
+        }
+        if (block->probe(prefix, shift)) {
+            return true;
+        }
+        if (prefix == last_prefix) {
+            return false;
         }
     }
+}
 
-    // we keep going to the next page (because leaf nodes are stored contiguously)
-    while (node->is_leaf) {
-        for (int i = 0; i < node->num_keys; i++) {
-            BTreeNode::Entry entry = node->entries[i];
-            if (entry.key < start_key) {
-                continue;
-            } else if (entry.key > end_key) {
+void BTreeNode::scan(uint32_t start_key, uint32_t end_key, std::filesystem::path file_path, BufferPool* buffer_pool,
+                     std::vector<TypedEntry>* result, const LearnedIndex* learned_index) {
+    SSTReader reader(buffer_pool);
+    // root node offset is 1
+    const BTreeNode* root = find_node(file_path, &reader, 1, buffer_pool, nullptr, PageType::INDEX);
+    const BTreeNode* node = root;
+    int last_leaf_offset = root->num_of_leaf_nodes + 1;
+    int offset;
+
+    if (learned_index != nullptr) {
+        find_leaf_with_learned_index(start_key, file_path, &reader, buffer_pool, learned_index, &offset);
+    } else {
+        // Continue searching until the leaf that contains the smallest key that fits in the range is found
+        while (true) {
+            // Find the correct child to follow, the first one whose largest key is >= start_key
+            int index = node->lower_bound(start_key);
+            // If no appropriate child is found, the key is not present
+            if (index == node->num_keys) {
+                return;
+            }
+            offset = node->values[index];
+            if (offset <= last_leaf_offset) {
+                break;
+            }
+            node = find_node(file_path, &reader, offset, buffer_pool, root, PageType::INDEX);
+        }
+    }
+
+    // we keep going to the next page (because leaf nodes are stored contiguously),
+    // only the first leaf has keys smaller than start_key
+    std::vector<uint32_t> unpacked_keys;
+    std::vector<uint32_t> unpacked_values;
+    std::vector<EntryType> unpacked_types;
+    bool is_first_leaf = true;
+    for (; offset <= last_leaf_offset; offset++) {
+        const uint32_t* keys;
+        const uint32_t* values;
+        const EntryType* types;
+        int num_keys;
+        const char* leaf_page = find_leaf(file_path, &reader, offset, buffer_pool, root);
+        if (root->leaf_format == LeafFormat::PACKED) {
+            const PackedLeaf* leaf = (const PackedLeaf*)leaf_page;
+            num_keys = leaf->num_keys;
+            unpacked_keys.resize(num_keys);
+            unpacked_values.resize(num_keys);
+            unpacked_types.resize(num_keys);
+            leaf->unpack(unpacked_keys.data(), unpacked_values.data(), unpacked_types.data());
+            keys = unpacked_keys.data();
+            values = unpacked_values.data();
+            types = unpacked_types.data();
+        } else {
+            const BTreeNode* leaf = (const BTreeNode*)leaf_page;
+            num_keys = leaf->num_keys;
+            keys = leaf->keys;
+            values = leaf->values;
+            types = leaf->types;
+        }
+        int index = is_first_leaf ? PageSearch::lower_bound(keys, num_keys, start_key) : 0;
+        is_first_leaf = false;
+        for (int i = index; i < num_keys; i++) {
+            if (keys[i] > end_key) {
                 return;
             }
-            result->push_back({entry.key, entry.value});
+            result->push_back({keys[i], values[i], types[i]});
         }
-        offset--;  // we subtract because that's how the offsets were calculated
-                   // when we are writing the B Tree to the SST
-        node = find_node(file_path, &file, offset, buffer_pool);
     }
 }
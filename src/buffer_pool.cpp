@@ -6,7 +6,7 @@
 #include "lru.hpp"
 #include "utils.hpp"
 
-BufferPool::BufferPool(int min_size, int max_size) {
+BufferPool::BufferPool(int min_size, int max_size) : max_size(max_size) {
     this->hashtable = new ExtendibleHashtable(min_size, max_size);
     this->eviction_policy = new LRU();
 }
@@ -21,16 +21,32 @@ BufferPool::~BufferPool() {
 }
 
 const char *BufferPool::get(const std::string &page_id) {
-    // std::vector<uint32_t> page_data;
+    std::lock_guard<std::mutex> lock(mutex);
+    if (admission_filter != nullptr) {
+        admission_filter->record(page_id);
+    }
+    if (!priority_pages.empty()) {
+        auto it = priority_pages.find(page_id);
+        if (it != priority_pages.end()) {
+            this->num_hits++;
+            if (!it->second.is_pinned) {
+                index_eviction_policy.update(page_id);
+            }
+            return it->second.data;
+        }
+    }
     Page *accessed_page = this->hashtable->get_page(page_id);
     if (accessed_page != nullptr) {
+        this->num_hits++;
         this->eviction_policy->update(accessed_page->get_page_id());
         return accessed_page->get_data();
     }
+    this->num_misses++;
     return {};
 }
 
 void BufferPool::resize(int new_max_size) {
+    std::lock_guard<std::mutex> lock(mutex);
     int num_to_evict =
         std::ceil(this->hashtable->get_size() - (ExtendibleHashtable::EXPANSION_THRESHOLD * new_max_size));
     if (num_to_evict > 0) {
@@ -42,14 +58,52 @@ void BufferPool::resize(int new_max_size) {
         this->hashtable->shrink_directory();
     }
     this->hashtable->set_max_size(new_max_size);
+    this->max_size = new_max_size;
+    if (admission_filter != nullptr) {
+        admission_filter = std::make_unique<TinyLFU>(new_max_size * ExtendibleHashtable::EXPANSION_THRESHOLD);
+    }
+}
+
+void BufferPool::set_admission_filter(bool enabled) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!enabled) {
+        admission_filter.reset();
+    } else if (admission_filter == nullptr) {
+        admission_filter = std::make_unique<TinyLFU>(max_size * ExtendibleHashtable::EXPANSION_THRESHOLD);
+    }
 }
 
-void BufferPool::insert(const std::string &page_id, const char *data) {
+bool BufferPool::insert(const std::string &page_id, const char *data, PageType type) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (this->hashtable->get_page(page_id) != nullptr || priority_pages.count(page_id) > 0) {
+        return false;
+    }
+    if (!pinned_ssts.empty() && pinned_ssts.count(page_id.substr(0, page_id.rfind('-'))) > 0) {
+        priority_pages[page_id] = {data, true};
+        num_admitted++;
+        return true;
+    }
+    if (type == PageType::INDEX && index_capacity > 0) {
+        if (num_index_pages == index_capacity) {
+            remove_priority_page(index_eviction_policy.evict());
+        }
+        priority_pages[page_id] = {data, false};
+        index_eviction_policy.insert(page_id);
+        num_index_pages++;
+        num_admitted++;
+        return true;
+    }
     // Expand the directory if the total number of pages mapped to this hash table
     // is greater than a certain directory size threshold.
     if (this->hashtable->get_size() > this->hashtable->get_num_directory() * ExtendibleHashtable::EXPANSION_THRESHOLD) {
         bool need_to_evict = !this->hashtable->expand_directory();
         if (need_to_evict) {
+            // the page is not worth the one it would evict
+            if (admission_filter != nullptr && eviction_policy->rear != nullptr &&
+                !admission_filter->admit(page_id, eviction_policy->rear->key)) {
+                num_rejected++;
+                return false;
+            }
             // Evict when directory can't be expanded anymore
             this->evict();
         }
@@ -58,6 +112,8 @@ void BufferPool::insert(const std::string &page_id, const char *data) {
     Page *new_page = new Page(page_id, data);
     this->hashtable->insert_page(new_page);
     this->eviction_policy->insert(new_page->get_page_id());
+    num_admitted++;
+    return true;
 }
 
 void BufferPool::evict() {
@@ -65,12 +121,123 @@ void BufferPool::evict() {
     this->hashtable->remove_page(page_to_evict);
 }
 
-std::vector<Page *> BufferPool::get_all_pages() { return hashtable->get_all_pages(); }
+void BufferPool::remove_sst(std::filesystem::path sst_path) {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::string prefix = Page::generate_page_id(sst_path, 0);
+    prefix.resize(prefix.size() - 1);
+    std::vector<std::string> page_ids;
+    for (Page *page : hashtable->get_all_pages()) {
+        if (page->get_page_id().compare(0, prefix.size(), prefix) == 0) {
+            page_ids.push_back(page->get_page_id());
+        }
+    }
+    for (const auto &[page_id, page] : priority_pages) {
+        if (page_id.compare(0, prefix.size(), prefix) == 0) {
+            page_ids.push_back(page_id);
+        }
+    }
+    for (const std::string &page_id : page_ids) {
+        remove_page(page_id);
+    }
+    pinned_ssts.erase(sst_path.string());
+    compressed_cache.remove_sst(sst_path);
+}
+
+void BufferPool::set_index_capacity(int num_pages) {
+    std::lock_guard<std::mutex> lock(mutex);
+    index_capacity = num_pages;
+    while (num_index_pages > index_capacity) {
+        remove_priority_page(index_eviction_policy.evict());
+    }
+}
+
+void BufferPool::pin_sst(std::filesystem::path sst_path) {
+    std::lock_guard<std::mutex> lock(mutex);
+    pinned_ssts.insert(sst_path.string());
+}
+
+void BufferPool::unpin_sst(std::filesystem::path sst_path) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (pinned_ssts.erase(sst_path.string()) == 0) {
+        return;
+    }
+    std::string prefix = Page::generate_page_id(sst_path, 0);
+    prefix.resize(prefix.size() - 1);
+    for (auto it = priority_pages.begin(); it != priority_pages.end();) {
+        if (it->second.is_pinned && it->first.compare(0, prefix.size(), prefix) == 0) {
+            it = priority_pages.erase(it);
+        } else {
+            it++;
+        }
+    }
+}
+
+std::vector<Page *> BufferPool::get_all_pages() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return hashtable->get_all_pages();
+}
+
+CompressedCache &BufferPool::get_compressed_cache() { return compressed_cache; }
+
+int64_t BufferPool::get_num_hits() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return this->num_hits;
+}
+
+int64_t BufferPool::get_num_misses() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return this->num_misses;
+}
+
+int BufferPool::get_num_priority_pages() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return priority_pages.size();
+}
+
+int64_t BufferPool::get_num_admitted() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return this->num_admitted;
+}
+
+int64_t BufferPool::get_num_rejected() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return this->num_rejected;
+}
+
+void BufferPool::add_num_freed(int64_t num_pages) {
+    std::lock_guard<std::mutex> lock(mutex);
+    this->num_freed += num_pages;
+}
+
+int64_t BufferPool::get_num_freed() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return this->num_freed;
+}
 
 void BufferPool::remove(const std::string &page_id) {
+    std::lock_guard<std::mutex> lock(mutex);
+    remove_page(page_id);
+}
+
+void BufferPool::remove_page(const std::string &page_id) {
     Page *page = this->hashtable->get_page(page_id);
     if (page != nullptr) {
         this->hashtable->remove_page(page);
         this->eviction_policy->remove(page_id);
     }
+    auto it = priority_pages.find(page_id);
+    if (it != priority_pages.end()) {
+        if (!it->second.is_pinned) {
+            index_eviction_policy.remove(page_id);
+        }
+        remove_priority_page(page_id);
+    }
+}
+
+void BufferPool::remove_priority_page(const std::string &page_id) {
+    auto it = priority_pages.find(page_id);
+    if (!it->second.is_pinned) {
+        num_index_pages--;
+    }
+    priority_pages.erase(it);
 }
@@ -0,0 +1,109 @@
+#include "compressed_cache.hpp"
+
+#include <utility>
+#include <vector>
+
+CompressedCache::CompressedCache(int64_t capacity) : capacity(capacity) {}
+
+const std::string *CompressedCache::get(const std::string &block_id) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = blocks.find(block_id);
+    if (it == blocks.end()) {
+        num_misses++;
+        return nullptr;
+    }
+    num_hits++;
+    eviction_policy.update(block_id);
+    return &it->second;
+}
+
+bool CompressedCache::get(const std::string &block_id, std::string *data) {
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = blocks.find(block_id);
+    if (it == blocks.end()) {
+        num_misses++;
+        return false;
+    }
+    num_hits++;
+    eviction_policy.update(block_id);
+    *data = it->second;
+    return true;
+}
+
+void CompressedCache::insert(const std::string &block_id, std::string data) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if ((int64_t)data.size() > capacity) {
+        // also the case when the cache is disabled
+        return;
+    }
+    remove_block(block_id);
+    while (size + (int64_t)data.size() > capacity) {
+        evict();
+    }
+    size += data.size();
+    blocks.emplace(block_id, std::move(data));
+    eviction_policy.insert(block_id);
+}
+
+void CompressedCache::remove(const std::string &block_id) {
+    std::lock_guard<std::mutex> lock(mutex);
+    remove_block(block_id);
+}
+
+void CompressedCache::remove_block(const std::string &block_id) {
+    auto it = blocks.find(block_id);
+    if (it != blocks.end()) {
+        size -= it->second.size();
+        blocks.erase(it);
+        eviction_policy.remove(block_id);
+    }
+}
+
+void CompressedCache::remove_sst(std::filesystem::path sst_path) {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::string prefix = generate_block_id(sst_path, 0);
+    prefix.resize(prefix.size() - 1);
+    std::vector<std::string> block_ids;
+    for (const auto &block : blocks) {
+        if (block.first.compare(0, prefix.size(), prefix) == 0) {
+            block_ids.push_back(block.first);
+        }
+    }
+    for (const std::string &block_id : block_ids) {
+        remove_block(block_id);
+    }
+}
+
+void CompressedCache::evict() {
+    std::string block_id = eviction_policy.evict();
+    auto it = blocks.find(block_id);
+    size -= it->second.size();
+    blocks.erase(it);
+}
+
+void CompressedCache::set_capacity(int64_t new_capacity) {
+    std::lock_guard<std::mutex> lock(mutex);
+    capacity = new_capacity;
+    while (size > capacity) {
+        evict();
+    }
+}
+
+int64_t CompressedCache::get_size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return size;
+}
+
+int64_t CompressedCache::get_num_hits() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return num_hits;
+}
+
+int64_t CompressedCache::get_num_misses() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return num_misses;
+}
+
+std::string CompressedCache::generate_block_id(std::filesystem::path sst_path, int block) {
+    return sst_path.string() + "-block-" + std::to_string(block);
+}
@@ -0,0 +1,166 @@
+#include "compression.hpp"
+
+#include <cstring>
+
+namespace {
+
+constexpr int MIN_MATCH = 4;
+// the format requires the last 5 bytes to be literals, and the last match to start 12 bytes before the end
+constexpr int LAST_LITERALS = 5;
+constexpr int MATCH_FIND_LIMIT = 12;
+constexpr int MAX_OFFSET = 65535;
+constexpr int HASH_LOG = 12;
+// after this many bytes without a match, the compressor skips ahead faster (incompressible data)
+constexpr int SKIP_TRIGGER = 6;
+
+inline uint32_t read32(const uint8_t* p) {
+    uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return value;
+}
+
+inline uint32_t hash(uint32_t sequence) { return (sequence * 2654435761u) >> (32 - HASH_LOG); }
+
+// lengths that do not fit in the 4 bits of the token continue in bytes of 255, then the remainder
+inline uint8_t* write_length(uint8_t* op, int length) {
+    for (; length >= 255; length -= 255) {
+        *op++ = 255;
+    }
+    *op++ = length;
+    return op;
+}
+
+inline bool read_length(const uint8_t** ip, const uint8_t* end, int* length) {
+    uint8_t byte;
+    do {
+        if (*ip >= end) {
+            return false;
+        }
+        byte = *(*ip)++;
+        *length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+uint8_t* write_sequence(uint8_t* op, const uint8_t* literals, int num_literals, int offset, int match_length) {
+    uint8_t* token = op++;
+    int match_code = match_length - MIN_MATCH;
+    *token = (num_literals < 15 ? num_literals : 15) << 4;
+    if (num_literals >= 15) {
+        op = write_length(op, num_literals - 15);
+    }
+    // an empty input has no literals to copy, and may be a null pointer
+    if (num_literals > 0) {
+        std::memcpy(op, literals, num_literals);
+    }
+    op += num_literals;
+    if (match_length == 0) {
+        // last literals, no match
+        return op;
+    }
+    *op++ = offset & 0xff;
+    *op++ = offset >> 8;
+    *token |= match_code < 15 ? match_code : 15;
+    if (match_code >= 15) {
+        op = write_length(op, match_code - 15);
+    }
+    return op;
+}
+
+}  // namespace
+
+namespace Compression {
+
+int get_max_compressed_size(int size) { return size + size / 255 + 16; }
+
+int compress(const char* source, int size, char* destination) {
+    const uint8_t* src = (const uint8_t*)source;
+    uint8_t* op = (uint8_t*)destination;
+    int anchor = 0;
+
+    if (size > MATCH_FIND_LIMIT) {
+        // positions of recently seen 4 byte sequences, -1 if none
+        int table[1 << HASH_LOG];
+        std::memset(table, -1, sizeof(table));
+        const int match_limit = size - LAST_LITERALS;
+        int position = 0;
+        int misses = 0;
+        while (position < size - MATCH_FIND_LIMIT) {
+            uint32_t sequence = read32(src + position);
+            uint32_t h = hash(sequence);
+            int candidate = table[h];
+            table[h] = position;
+            if (candidate < 0 || position - candidate > MAX_OFFSET || read32(src + candidate) != sequence) {
+                position += 1 + (misses++ >> SKIP_TRIGGER);
+                continue;
+            }
+            misses = 0;
+            int length = MIN_MATCH;
+            while (position + length < match_limit && src[position + length] == src[candidate + length]) {
+                length++;
+            }
+            op = write_sequence(op, src + anchor, position - anchor, position - candidate, length);
+            position += length;
+            anchor = position;
+            // the end of a match is often the start of the next one
+            if (position - 2 < size - MATCH_FIND_LIMIT) {
+                table[hash(read32(src + position - 2))] = position - 2;
+            }
+        }
+    }
+    op = write_sequence(op, src + anchor, size - anchor, 0, 0);
+    return op - (uint8_t*)destination;
+}
+
+bool decompress(const char* source, int compressed_size, char* destination, int size) {
+    const uint8_t* ip = (const uint8_t*)source;
+    const uint8_t* end = ip + compressed_size;
+    uint8_t* dst = (uint8_t*)destination;
+    int position = 0;
+    while (ip < end) {
+        uint8_t token = *ip++;
+        int num_literals = token >> 4;
+        if (num_literals == 15 && !read_length(&ip, end, &num_literals)) {
+            return false;
+        }
+        if (num_literals > end - ip || num_literals > size - position) {
+            return false;
+        }
+        if (num_literals > 0) {
+            std::memcpy(dst + position, ip, num_literals);
+        }
+        ip += num_literals;
+        position += num_literals;
+        if (ip == end) {
+            // the block ends with literals
+            break;
+        }
+
+        if (end - ip < 2) {
+            return false;
+        }
+        int offset = ip[0] | (ip[1] << 8);
+        ip += 2;
+        int match_length = (token & 15);
+        if (match_length == 15 && !read_length(&ip, end, &match_length)) {
+            return false;
+        }
+        match_length += MIN_MATCH;
+        if (offset == 0 || offset > position || match_length > size - position) {
+            return false;
+        }
+        const uint8_t* match = dst + position - offset;
+        if (offset >= match_length) {
+            std::memcpy(dst + position, match, match_length);
+        } else {
+            // the match overlaps the bytes it produces (a repeated pattern), it has to be copied in order
+            for (int i = 0; i < match_length; i++) {
+                dst[position + i] = match[i];
+            }
+        }
+        position += match_length;
+    }
+    return position == size;
+}
+
+}  // namespace Compression
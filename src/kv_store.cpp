@@ -4,17 +4,86 @@
 #include <unistd.h>
 
 #include <algorithm>
+#include <chrono>
 #include <cmath>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
 #include <vector>
 
+#include "bloom_filter.hpp"
 #include "btree.hpp"
+#include "sst_builder.hpp"
+#include "sst_writer.hpp"
 #include "utils.hpp"
 
+uint64_t Snapshot::get_sequence() const { return sequence; }
+
 KVStore::KVStore(int memtable_size, int initial_size, int max_size)
-    : memtable_size(memtable_size), buffer_pool(initial_size, max_size) {}
+    : memtable(Memtable::create(MemtableType::AVL_TREE)),
+      memtable_size(memtable_size),
+      buffer_pool(initial_size, max_size),
+      current_version(std::make_shared<Version>()) {}
+
+void KVStore::set_rate_limiter(RateLimiter *rate_limiter) { sst_options.rate_limiter = rate_limiter; }
+
+void KVStore::set_bloom_bits_per_entry(double bits_per_entry) {
+    filter_memory_budget = 0;
+    sst_options.level_bits_per_entry = {bits_per_entry};
+}
+
+void KVStore::set_filter_memory_budget(int64_t total_bits) {
+    filter_memory_budget = total_bits;
+    update_filter_allocation();
+}
+
+void KVStore::set_range_filter(bool enabled) { sst_options.use_range_filter = enabled; }
+
+void KVStore::set_learned_index(bool enabled) { sst_options.use_learned_index = enabled; }
+
+void KVStore::set_leaf_format(LeafFormat leaf_format) { sst_options.leaf_format = leaf_format; }
+
+void KVStore::set_compression(CompressionType compression) { sst_options.compression = compression; }
+
+void KVStore::set_compressed_cache_capacity(int64_t capacity_bytes) {
+    buffer_pool.get_compressed_cache().set_capacity(capacity_bytes);
+}
+
+void KVStore::set_buffer_pool_admission_filter(bool enabled) { buffer_pool.set_admission_filter(enabled); }
+
+void KVStore::set_row_cache_capacity(int64_t num_rows) { row_cache.set_capacity(num_rows); }
+
+void KVStore::set_index_cache_capacity(int num_pages) { buffer_pool.set_index_capacity(num_pages); }
+
+void KVStore::set_pin_level0(bool enabled) {
+    std::lock_guard<std::mutex> lock(flush_mutex);
+    pin_level0 = enabled;
+    update_pinned_ssts();
+}
+
+void KVStore::set_value_log_segment_size(int64_t bytes) { value_log.set_segment_size(bytes); }
+
+void KVStore::set_memtable_type(MemtableType type) {
+    if (!memtable->empty() || !appended_entries.empty()) {
+        throw std::runtime_error("The memtable type of a store is changed while its memtable has entries: " + db_name);
+    }
+    memtable = Memtable::create(type);
+}
+
+void KVStore::set_merge_operator(const MergeOperator *merge_operator) { sst_options.merge_operator = merge_operator; }
+
+BufferPool &KVStore::get_buffer_pool() { return buffer_pool; }
+
+RowCache &KVStore::get_row_cache() { return row_cache; }
+
+ValueLog &KVStore::get_value_log() { return value_log; }
 
 /*
  * Basic API
@@ -25,120 +94,722 @@ void KVStore::open(const std::string &name) {
 
     if (!fs::exists(db_path)) {
         fs::create_directory(db_path);
+        manifest.open(db_path);
+    } else if (manifest.open(db_path)) {
+        // reconstruct LSM tree levels by replaying the manifest
+        Level::load_from_manifest(levels, manifest, db_path);
+        manifest.remove_orphan_files();
     } else {
-        // reconstruct LSM tree levels based on SST files
+        // database written before manifests existed, infer the levels from the SST file names
+        VersionEdit edit;
         for (const auto &entry : fs::directory_iterator(db_path)) {
-            if (fs::is_regular_file(entry)) {
+            if (fs::is_regular_file(entry) && entry.path().extension() == ".dat") {
                 Level::load_into_lsm_tree(levels, entry.path());
             }
         }
+        for (int level = 0; level < (int)levels.size(); level++) {
+            for (auto &sst_path : levels[level].sst_list) {
+                edit.add_file(Level::get_file_meta(level, sst_path));
+            }
+        }
+        manifest.log_and_apply(edit);
+    }
+    // links of the Versions of a store that was not destroyed cleanly
+    for (const auto &entry : fs::directory_iterator(db_path)) {
+        std::string file_name = entry.path().filename().string();
+        if (file_name.rfind("link_", 0) == 0 && entry.path().extension() == ".sst") {
+            fs::remove(entry.path());
+        }
     }
+    // the links of this open are named after a random number, so that a store closed but not destroyed yet never
+    // removes them when it drops the links it had
+    std::random_device random;
+    link_prefix = "link_" + std::to_string(((uint64_t)random() << 32) | random()) + "_";
+    next_link_id = 0;
+    install_version();
+    value_log.open(db_path);
 }
 
-void KVStore::put(uint32_t key, uint32_t value) {
-    memtable.put(key, value);
-    current_memtable_entries++;
+void KVStore::put(uint32_t key, uint32_t value) { put_entry(key, value, EntryType::VALUE); }
 
-    // if memtable is full, write it to SST
-    if (current_memtable_entries >= memtable_size) {
-        write_memtable_to_sst();
+void KVStore::put_entry(uint32_t key, uint32_t value, EntryType type) {
+    {
+        std::unique_lock<std::shared_mutex> lock(memtable_mutex);
+        insert_into_memtable(key, value, type, get_newest_snapshot_sequence());
+        current_memtable_entries++;
     }
+    flush_if_full();
 }
 
-uint32_t KVStore::get(uint32_t key) {
-    uint32_t value = memtable.get(key);
+void KVStore::flush_if_full() {
+    {
+        std::shared_lock<std::shared_mutex> lock(memtable_mutex);
+        if (current_memtable_entries < memtable_size) {
+            return;
+        }
+    }
+    // if memtable is full, write it to SST (unless another writer did meanwhile)
+    std::lock_guard<std::mutex> flush_lock(flush_mutex);
+    {
+        std::shared_lock<std::shared_mutex> lock(memtable_mutex);
+        if (current_memtable_entries < memtable_size) {
+            return;
+        }
+    }
+    write_memtable_to_sst();
+}
 
-    if (value == Utils::TOMB_STONE) {
-        // Key does not exist since it has been deleted.
-        return Utils::INVALID_VALUE;
-    } else if (value != Utils::INVALID_VALUE) {
-        return value;
+void KVStore::insert_into_memtable(uint32_t key, uint32_t value, EntryType type, uint64_t newest_snapshot) {
+    uint32_t existing;
+    EntryType existing_type;
+    // the memtable keeps one entry per key, so an operand is combined right away with the entry it applies to
+    // (the older entries, in the SSTs, are not read)
+    if (is_memtable_appending) {
+        // a key larger than every key of the memtable has no entry to merge with
+        if (appended_entries.empty() || key > appended_entries.back().key) {
+            appended_entries.push_back({key, value, type, ++last_sequence});
+            return;
+        }
+        move_appended_entries_to_tree();
+    }
+    if (type == EntryType::MERGE && memtable->get(key, &existing, &existing_type)) {
+        if (existing_type == EntryType::VALUE || existing_type == EntryType::MERGE) {
+            value = MergeOperator::apply(sst_options.merge_operator, existing, value);
+            type = existing_type;
+        } else {
+            // a deletion (or a blob) leaves no value to merge with
+            type = EntryType::VALUE;
+        }
     }
+    memtable->put(key, value, type, ++last_sequence, newest_snapshot);
+}
 
-    // Search SSTs if you cannot find the key in memtable
-    value = find_value_in_ssts(key);
-    return value;
+void KVStore::move_appended_entries_to_tree() {
+    for (const AppendedEntry &entry : appended_entries) {
+        // every key has a single version, no snapshot needs an older one
+        memtable->put(entry.key, entry.value, entry.type, entry.sequence);
+    }
+    appended_entries.clear();
+    is_memtable_appending = false;
 }
 
-std::vector<std::pair<uint32_t, uint32_t>> KVStore::scan(uint32_t start_key, uint32_t end_key) {
-    std::vector<std::pair<uint32_t, uint32_t>> *result = new std::vector<std::pair<uint32_t, uint32_t>>();
+bool KVStore::find_in_memtable(uint32_t key, uint32_t *value, EntryType *type, uint64_t max_sequence) {
+    if (!is_memtable_appending) {
+        return memtable->get(key, value, type, max_sequence);
+    }
+    auto it = std::lower_bound(appended_entries.begin(), appended_entries.end(), key,
+                               [](const AppendedEntry &entry, uint32_t key) { return entry.key < key; });
+    if (it == appended_entries.end() || it->key != key || it->sequence > max_sequence) {
+        return false;
+    }
+    *value = it->value;
+    *type = it->type;
+    return true;
+}
 
-    scan_memtable(memtable.root, start_key, end_key, result);
-    scan_ssts(start_key, end_key, result);
+void KVStore::get_memtable_entries(uint32_t start_key, uint32_t end_key, std::vector<BTreeNode::TypedEntry> *result,
+                                   uint64_t max_sequence) {
+    if (!is_memtable_appending) {
+        memtable->scan(
+            start_key, end_key,
+            [result](uint32_t key, uint32_t value, EntryType type) { result->push_back({key, value, type}); },
+            max_sequence);
+        return;
+    }
+    auto it = std::lower_bound(appended_entries.begin(), appended_entries.end(), start_key,
+                               [](const AppendedEntry &entry, uint32_t key) { return entry.key < key; });
+    for (; it != appended_entries.end() && it->key <= end_key; it++) {
+        if (it->sequence <= max_sequence) {
+            result->push_back({it->key, it->value, it->type});
+        }
+    }
+}
 
-    std::sort(
-        result->begin(), result->end(),
-        [](const std::pair<uint32_t, uint32_t> a, const std::pair<uint32_t, uint32_t> b) { return a.first < b.first; });
+uint32_t KVStore::get(uint32_t key) {
+    uint32_t value;
+    if (!get(key, &value)) {
+        return Utils::INVALID_VALUE;
+    }
+    return value;
+}
+
+bool KVStore::get(uint32_t key, uint32_t *value, const Snapshot *snapshot) {
+    EntryType type;
+    // Key does not exist if it has been deleted.
+    return find_entry(key, value, &type, snapshot) && type == EntryType::VALUE;
+}
+
+bool KVStore::find_entry(uint32_t key, uint32_t *value, EntryType *type, const Snapshot *snapshot) {
+    reopen_if_closed();
+    std::shared_lock<std::shared_mutex> lock(memtable_mutex);
+    bool in_memtable = false;
+    if (snapshot == nullptr || !snapshot->is_memtable_copied) {
+        in_memtable = find_in_memtable(key, value, type, snapshot != nullptr ? snapshot->sequence : Memtable::LATEST);
+    } else {
+        const std::vector<BTreeNode::TypedEntry> &entries = snapshot->memtable_entries;
+        auto it = std::lower_bound(entries.begin(), entries.end(), key,
+                                   [](const BTreeNode::TypedEntry &entry, uint32_t key) { return entry.key < key; });
+        if (it != entries.end() && it->key == key) {
+            *value = it->value;
+            *type = it->type;
+            in_memtable = true;
+        }
+    }
+    if (in_memtable && *type != EntryType::MERGE) {
+        return true;
+    }
+    // a range tombstone of the memtable deletes the entries of the SSTs
+    if (is_deleted_by_memtable_range(key, snapshot)) {
+        if (in_memtable) {
+            // the merge operand has no value to apply to
+            *type = EntryType::VALUE;
+        } else {
+            *value = 0;
+            *type = EntryType::DELETION;
+        }
+        return true;
+    }
+    // a merge operand in the memtable applies to the entry of the key in the SSTs
+    uint32_t operand = in_memtable ? *value : 0;
+    // the SSTs are read without the lock, from the version they had at the time of the lookup
+    std::shared_ptr<const Version> version = snapshot != nullptr ? snapshot->version : current_version;
+    // the row cache holds the results of the latest SSTs
+    bool use_row_cache = snapshot == nullptr && row_cache.get_capacity() > 0;
+    uint64_t row_cache_epoch = use_row_cache ? row_cache.get_epoch() : 0;
+    lock.unlock();
 
-    for (auto it = result->begin(); it != result->end();) {
-        if (it->second == Utils::TOMB_STONE) {
-            it->second = Utils::INVALID_VALUE;
+    // Search SSTs if you cannot find the key in memtable
+    bool found;
+    if (!use_row_cache || !row_cache.get(key, &found, value, type)) {
+        RateLimiter *rate_limiter = sst_options.rate_limiter;
+        if (rate_limiter != nullptr && rate_limiter->is_auto_tune()) {
+            // report how long SST lookups take so the limiter can back off compaction I/O
+            auto start_time = std::chrono::steady_clock::now();
+            found = find_value_in_ssts(key, value, type, *version);
+            auto stop_time = std::chrono::steady_clock::now();
+            rate_limiter->record_foreground_latency(
+                std::chrono::duration<double, std::micro>(stop_time - start_time).count());
         } else {
-            it++;
+            found = find_value_in_ssts(key, value, type, *version);
         }
+        if (use_row_cache) {
+            row_cache.insert(key, found, *value, *type, row_cache_epoch);
+        }
+    }
+    if (in_memtable) {
+        bool has_value = found && (*type == EntryType::VALUE || *type == EntryType::MERGE);
+        *value = has_value ? MergeOperator::apply(sst_options.merge_operator, *value, operand) : operand;
+        *type = EntryType::VALUE;
+        return true;
     }
+    // no older entry is left for the operands of the SSTs to apply to
+    if (found && *type == EntryType::MERGE) {
+        *type = EntryType::VALUE;
+    }
+    return found;
+}
 
-    return *result;
+std::vector<std::pair<uint32_t, uint32_t>> KVStore::scan(uint32_t start_key, uint32_t end_key,
+                                                         const Snapshot *snapshot) {
+    // entries from the newest to the oldest, so that the first entry of a key is its latest one
+    std::vector<BTreeNode::TypedEntry> entries;
+    reopen_if_closed();
+    std::shared_lock<std::shared_mutex> lock(memtable_mutex);
+    std::vector<RangeTombstone> range_tombstones = get_memtable_range_tombstones(snapshot);
+    if (snapshot == nullptr || !snapshot->is_memtable_copied) {
+        get_memtable_entries(start_key, end_key, &entries, snapshot != nullptr ? snapshot->sequence : Memtable::LATEST);
+    } else {
+        for (const BTreeNode::TypedEntry &entry : snapshot->memtable_entries) {
+            if (start_key <= entry.key && entry.key <= end_key) {
+                entries.push_back(entry);
+            }
+        }
+    }
+    std::shared_ptr<const Version> version = snapshot != nullptr ? snapshot->version : current_version;
+    lock.unlock();
+    scan_ssts(start_key, end_key, &entries, *version, range_tombstones);
+
+    std::stable_sort(entries.begin(), entries.end(),
+                     [](const BTreeNode::TypedEntry &a, const BTreeNode::TypedEntry &b) { return a.key < b.key; });
+
+    std::vector<std::pair<uint32_t, uint32_t>> result;
+    for (size_t i = 0; i < entries.size(); i++) {
+        bool is_latest = i == 0 || entries[i].key != entries[i - 1].key;
+        if (!is_latest) {
+            continue;
+        }
+        if (entries[i].type == EntryType::VALUE) {
+            result.push_back({entries[i].key, entries[i].value});
+        } else if (entries[i].type == EntryType::MERGE) {
+            // apply the operands to the older entries of the key, from the oldest one the operands reach
+            size_t end = i + 1;
+            while (end < entries.size() && entries[end].key == entries[i].key &&
+                   entries[end - 1].type == EntryType::MERGE) {
+                end++;
+            }
+            const BTreeNode::TypedEntry &oldest = entries[end - 1];
+            uint32_t value = oldest.value;
+            size_t first_operand = end - 1;
+            if (oldest.type != EntryType::VALUE && oldest.type != EntryType::MERGE) {
+                // a deletion (or a blob) leaves no value to merge with
+                value = entries[end - 2].value;
+                first_operand = end - 2;
+            }
+            for (size_t j = first_operand; j > i; j--) {
+                value = MergeOperator::apply(sst_options.merge_operator, value, entries[j - 1].value);
+            }
+            result.push_back({entries[i].key, value});
+        }
+    }
+    return result;
 }
 
 void KVStore::delete_key(uint32_t key) {
     // When deleting a key, we just put a tombstone in the memtable
-    memtable.put(key, Utils::TOMB_STONE);
+    std::unique_lock<std::shared_mutex> lock(memtable_mutex);
+    insert_into_memtable(key, 0, EntryType::DELETION, get_newest_snapshot_sequence());
+}
+
+void KVStore::merge(uint32_t key, uint32_t operand) { put_entry(key, operand, EntryType::MERGE); }
+
+void KVStore::delete_range(uint32_t start_key, uint32_t end_key) {
+    if (start_key > end_key) {
+        return;
+    }
+    std::unique_lock<std::shared_mutex> lock(memtable_mutex);
+    // the keys of the range that the memtable holds are deleted one by one, so that the range tombstone only
+    // has to delete the entries of the SSTs
+    std::vector<BTreeNode::TypedEntry> entries;
+    get_memtable_entries(start_key, end_key, &entries);
+    if (is_memtable_appending && !entries.empty()) {
+        move_appended_entries_to_tree();
+    }
+    uint64_t sequence = ++last_sequence;
+    uint64_t newest_snapshot = get_newest_snapshot_sequence();
+    for (const BTreeNode::TypedEntry &entry : entries) {
+        if (entry.type != EntryType::DELETION) {
+            memtable->put(entry.key, 0, EntryType::DELETION, sequence, newest_snapshot);
+        }
+    }
+    memtable_range_tombstones.push_back({start_key, end_key, sequence});
+    current_memtable_entries++;
+    lock.unlock();
+
+    flush_if_full();
+}
+
+void KVStore::bulk_load(BulkLoadIterator *iterator) {
+    std::lock_guard<std::mutex> flush_lock(flush_mutex);
+    bool is_empty;
+    {
+        std::shared_lock<std::shared_mutex> lock(memtable_mutex);
+        is_empty = memtable->empty() && appended_entries.empty() && memtable_range_tombstones.empty();
+    }
+    for (auto &level : levels) {
+        is_empty = is_empty && level.sst_list.empty();
+    }
+    if (!is_empty) {
+        throw std::runtime_error("Bulk load into a store that is not empty: " + db_name);
+    }
+
+    // the level whose SSTs hold as many entries, as if they had been put and compacted
+    int64_t num_entries = iterator->get_num_entries();
+    int level = 0;
+    while (Level::get_max_entries(level, memtable_size) < num_entries) {
+        level++;
+    }
+    update_filter_allocation(level + 1);
+
+    // the SST is written under a temporary name, which opening the store deletes if the load did not finish
+    fs::path tmp_path = db_path / "bulk_load.tmp";
+    try {
+        SSTWriter writer(tmp_path, num_entries, sst_options, level);
+        for (; iterator->valid(); iterator->next()) {
+            writer.put(iterator->key(), iterator->value());
+        }
+        writer.finish();
+    } catch (const std::runtime_error &) {
+        fs::remove(tmp_path);
+        throw;
+    }
+    Level::install_sst(levels, level, tmp_path, db_path, &manifest);
+    sst_count++;
+    install_version();
+    // lookups may have cached that the keys were not found
+    row_cache.invalidate(0, UINT32_MAX);
+}
+
+void KVStore::ingest(const std::vector<fs::path> &sst_paths, bool move_files) {
+    std::lock_guard<std::mutex> flush_lock(flush_mutex);
+    // the range tombstones of the SSTs are checked in their VersionFiles
+    if (is_closed) {
+        install_version();
+    }
+    for (const fs::path &sst_path : sst_paths) {
+        // the keys the file holds or deletes
+        uint32_t min_key;
+        uint32_t max_key;
+        BTreeNode::read_key_range(sst_path, &min_key, &max_key);
+        for (const RangeTombstone &tombstone : BTreeNode::read_range_tombstones(sst_path)) {
+            min_key = std::min(min_key, tombstone.start_key);
+            max_key = std::max(max_key, tombstone.end_key);
+        }
+
+        // the memtable is older than the file but read before it, so it is flushed first if they overlap
+        std::vector<BTreeNode::TypedEntry> memtable_entries;
+        bool memtable_overlaps;
+        {
+            std::shared_lock<std::shared_mutex> lock(memtable_mutex);
+            get_memtable_entries(min_key, max_key, &memtable_entries);
+            memtable_overlaps = !memtable_entries.empty();
+            for (const RangeTombstone &tombstone : memtable_range_tombstones) {
+                memtable_overlaps =
+                    memtable_overlaps || (tombstone.start_key <= max_key && min_key <= tombstone.end_key);
+            }
+        }
+        if (memtable_overlaps) {
+            write_memtable_to_sst();
+        }
+
+        // the file is newer than every SST, so it cannot go below the first level with an SST it overlaps. It goes
+        // to the deepest empty level above that one (a new last level if it overlaps none), so that it is not
+        // compacted right away, or else as the newest SST of the level it overlaps.
+        int level = -1;
+        for (int i = 0; i <= (int)levels.size(); i++) {
+            if (level_overlaps(i, min_key, max_key)) {
+                level = level == -1 ? i : level;
+                break;
+            }
+            if (i == (int)levels.size() || levels[i].sst_list.empty()) {
+                level = i;
+            }
+        }
+
+        // the file is not part of the store until it is installed, opening the store deletes the temporary name
+        fs::path tmp_path = db_path / "ingest.tmp";
+        if (move_files) {
+            fs::rename(sst_path, tmp_path);
+        } else {
+            fs::create_hard_link(sst_path, tmp_path);
+        }
+        Level::install_sst(levels, level, tmp_path, db_path, &manifest);
+        sst_count++;
+        update_filter_allocation(level + 1);
+        Level::compact_levels(levels, level, db_path, buffer_pool, sst_options, &manifest);
+        install_version();
+        row_cache.invalidate(min_key, max_key);
+    }
+}
+
+void KVStore::write(const WriteBatch &batch) {
+    Writer writer(&batch);
+    std::unique_lock<std::mutex> lock(write_mutex);
+    writers.push_back(&writer);
+    // wait until a leader applied the batch, or until this writer is the leader
+    while (!writer.done && &writer != writers.front()) {
+        writer.cv.wait(lock);
+    }
+    if (writer.done) {
+        return;
+    }
+
+    // the leader takes the batches queued so far (about a memtable's worth at most), the writers that come
+    // meanwhile queue up behind them
+    std::vector<Writer *> group;
+    int num_operations = 0;
+    for (Writer *member : writers) {
+        if (!group.empty() && num_operations + member->batch->get_num_operations() > memtable_size) {
+            break;
+        }
+        group.push_back(member);
+        num_operations += member->batch->get_num_operations();
+    }
+    lock.unlock();
+
+    {
+        // readers see all the batches of the group or none of them
+        std::unique_lock<std::shared_mutex> memtable_lock(memtable_mutex);
+        uint64_t newest_snapshot = get_newest_snapshot_sequence();
+        for (Writer *member : group) {
+            for (const BTreeNode::TypedEntry &operation : member->batch->get_operations()) {
+                insert_into_memtable(operation.key, operation.value, operation.type, newest_snapshot);
+            }
+        }
+        current_memtable_entries += num_operations;
+    }
+    flush_if_full();
+
+    lock.lock();
+    for (Writer *member : group) {
+        writers.pop_front();
+        member->done = true;
+        member->cv.notify_one();
+    }
+    if (!writers.empty()) {
+        writers.front()->cv.notify_one();
+    }
+}
+
+void KVStore::put_blob(uint32_t key, const std::string &value) {
+    put_entry(key, value_log.append(key, value), EntryType::BLOB);
+}
+
+bool KVStore::get_blob(uint32_t key, std::string *value, const Snapshot *snapshot) {
+    uint32_t pointer;
+    EntryType type;
+    if (!find_entry(key, &pointer, &type, snapshot) || type != EntryType::BLOB) {
+        return false;
+    }
+    uint32_t record_key;
+    if (!value_log.read(pointer, &record_key, value) || record_key != key) {
+        throw std::runtime_error("Corrupted value log record " + std::to_string(pointer));
+    }
+    return true;
+}
+
+int64_t KVStore::collect_value_log_garbage() {
+    // the file being appended to is never collected
+    if (value_log.get_num_segments() < 2 || !snapshots.empty()) {
+        return 0;
+    }
+    std::vector<ValueLog::Record> records;
+    value_log.read_oldest_segment(&records);
+    for (const ValueLog::Record &record : records) {
+        // a blob is live if the LSM tree still points to its record, otherwise it was overwritten or deleted
+        uint32_t pointer;
+        EntryType type;
+        if (find_entry(record.key, &pointer, &type) && type == EntryType::BLOB && pointer == record.pointer) {
+            put_entry(record.key, value_log.append(record.key, record.value), EntryType::BLOB);
+        }
+    }
+    // the new pointers must be in an SST before the file they replace is gone
+    std::lock_guard<std::mutex> flush_lock(flush_mutex);
+    write_memtable_to_sst();
+    return value_log.remove_oldest_segment();
+}
+
+const Snapshot *KVStore::snapshot() {
+    reopen_if_closed();
+    std::unique_ptr<Snapshot> snapshot = std::make_unique<Snapshot>();
+    std::unique_lock<std::shared_mutex> lock(memtable_mutex);
+    snapshot->sequence = last_sequence;
+    snapshot->version = current_version;
+    snapshots.push_back(std::move(snapshot));
+    return snapshots.back().get();
+}
+
+void KVStore::release_snapshot(const Snapshot *snapshot) {
+    std::unique_ptr<Snapshot> released;
+    std::unique_lock<std::shared_mutex> lock(memtable_mutex);
+    auto it = std::find_if(snapshots.begin(), snapshots.end(),
+                           [snapshot](const std::unique_ptr<Snapshot> &live) { return live.get() == snapshot; });
+    if (it == snapshots.end()) {
+        return;
+    }
+    // the SSTs that only the snapshot still reads are removed once the lock is released
+    released = std::move(*it);
+    snapshots.erase(it);
+}
+
+uint64_t KVStore::get_newest_snapshot_sequence() const {
+    return snapshots.empty() ? 0 : snapshots.back()->sequence;
+}
+
+std::vector<RangeTombstone> KVStore::get_memtable_range_tombstones(const Snapshot *snapshot) const {
+    if (snapshot != nullptr && snapshot->is_memtable_copied) {
+        return snapshot->memtable_range_tombstones;
+    }
+    std::vector<RangeTombstone> result;
+    for (const RangeTombstone &tombstone : memtable_range_tombstones) {
+        if (snapshot == nullptr || tombstone.sequence <= snapshot->sequence) {
+            result.push_back(tombstone);
+        }
+    }
+    return result;
+}
+
+bool KVStore::is_deleted_by_memtable_range(uint32_t key, const Snapshot *snapshot) const {
+    const std::vector<RangeTombstone> &tombstones = snapshot != nullptr && snapshot->is_memtable_copied
+                                                        ? snapshot->memtable_range_tombstones
+                                                        : memtable_range_tombstones;
+    for (const RangeTombstone &tombstone : tombstones) {
+        bool is_visible = snapshot == nullptr || tombstone.sequence <= snapshot->sequence;
+        if (is_visible && tombstone.start_key <= key && key <= tombstone.end_key) {
+            return true;
+        }
+    }
+    return false;
 }
 
 void KVStore::close() {
     // when closing, flush memtable to SSTs
+    std::lock_guard<std::mutex> flush_lock(flush_mutex);
     write_memtable_to_sst();
+    manifest.checkpoint();
+
+    // drop the links of the SSTs (those a snapshot still holds go with it), another store may open the directory
+    for (auto &link_path : pinned_links) {
+        buffer_pool.unpin_sst(link_path);
+    }
+    pinned_links.clear();
+    version_files.clear();
+    std::shared_ptr<const Version> old_version;
+    std::unique_lock<std::shared_mutex> lock(memtable_mutex);
+    old_version = std::move(current_version);
+    current_version = std::make_shared<Version>();
+    is_closed = true;
 }
 
 /*
  * Helper Functions
  */
 
-void KVStore::scan_memtable(Node *node, uint32_t start_key, uint32_t end_key,
-                            std::vector<std::pair<uint32_t, uint32_t>> *result) {
-    if (node == nullptr) return;
-
-    if (start_key < node->key) {
-        scan_memtable(node->left, start_key, end_key, result);
+void KVStore::scan_ssts(uint32_t start_key, uint32_t end_key, std::vector<BTreeNode::TypedEntry> *result,
+                        const Version &version, std::vector<RangeTombstone> range_tombstones) {
+    range_tombstones = RangeTombstone::coalesce(range_tombstones);
+    // the memtable being flushed is newer than every SST
+    for (const BTreeNode::TypedEntry &entry : version.flushing_entries) {
+        if (start_key <= entry.key && entry.key <= end_key && !RangeTombstone::covers(range_tombstones, entry.key)) {
+            result->push_back(entry);
+        }
     }
-    if (start_key <= node->key && node->key <= end_key) {
-        result->push_back({node->key, node->value});
+    if (!version.flushing_range_tombstones.empty()) {
+        range_tombstones.insert(range_tombstones.end(), version.flushing_range_tombstones.begin(),
+                                version.flushing_range_tombstones.end());
+        range_tombstones = RangeTombstone::coalesce(range_tombstones);
     }
-    if (node->key < end_key) {
-        scan_memtable(node->right, start_key, end_key, result);
+    for (const auto &level : version.levels) {
+        // the SSTs of a level are in the order they were added, the newest last
+        for (auto it = level.rbegin(); it != level.rend(); it++) {
+            const VersionFile &file = **it;
+            // skip SSTs whose key range does not overlap the scan, without any I/O, then ask the range filter,
+            // which also rules out gaps inside the key range
+            bool may_match = file.may_overlap(start_key, end_key) &&
+                             BTreeNode::range_may_match(start_key, end_key, file.get_path(), &buffer_pool);
+            if (may_match) {
+                size_t first = result->size();
+                BTreeNode::scan(start_key, end_key, file.get_path(), &buffer_pool, result, file.get_learned_index());
+                if (!range_tombstones.empty()) {
+                    result->erase(std::remove_if(result->begin() + first, result->end(),
+                                                 [&range_tombstones](const BTreeNode::TypedEntry &entry) {
+                                                     return RangeTombstone::covers(range_tombstones, entry.key);
+                                                 }),
+                                  result->end());
+                }
+            }
+            // the SST's own range tombstones delete the entries of the older SSTs only (even if it was skipped)
+            const std::vector<RangeTombstone> &sst_range_tombstones = file.get_range_tombstones();
+            if (!sst_range_tombstones.empty()) {
+                range_tombstones.insert(range_tombstones.end(), sst_range_tombstones.begin(),
+                                        sst_range_tombstones.end());
+                range_tombstones = RangeTombstone::coalesce(range_tombstones);
+            }
+        }
     }
 }
 
-void KVStore::scan_ssts(uint32_t start_key, uint32_t end_key, std::vector<std::pair<uint32_t, uint32_t>> *result) {
-    for (auto &level : levels) {
-        for (auto &sst_path : level.sst_list) {
-            BTreeNode::scan(start_key, end_key, sst_path, &buffer_pool, result);
+bool KVStore::find_value_in_ssts(uint32_t key, uint32_t *value, EntryType *type, const Version &version) {
+    // merge operands found so far, combined, they apply to the next older entry
+    bool has_operand = false;
+    uint32_t operand = 0;
+    // takes the entry of the next older SST, if it has or deletes the key; true once the lookup is done
+    auto take_entry = [&](bool found, bool is_deleted) {
+        if (!found && !is_deleted) {
+            return false;
+        }
+        if (!found) {
+            *value = 0;
+            *type = EntryType::DELETION;
+        } else if (*type == EntryType::MERGE) {
+            operand = has_operand ? MergeOperator::apply(sst_options.merge_operator, *value, operand) : *value;
+            has_operand = true;
+            if (!is_deleted) {
+                return false;
+            }
+            // the operands have no value to apply to
+            *type = EntryType::DELETION;
+        }
+        if (has_operand) {
+            // a deletion (or a blob) leaves no value to merge with
+            *value = *type == EntryType::VALUE ? MergeOperator::apply(sst_options.merge_operator, *value, operand)
+                                               : operand;
+            *type = EntryType::VALUE;
         }
+        return true;
+    };
+
+    // the memtable being flushed is newer than every SST
+    const std::vector<BTreeNode::TypedEntry> &entries = version.flushing_entries;
+    auto entry = std::lower_bound(entries.begin(), entries.end(), key,
+                                  [](const BTreeNode::TypedEntry &entry, uint32_t key) { return entry.key < key; });
+    bool found = entry != entries.end() && entry->key == key;
+    if (found) {
+        *value = entry->value;
+        *type = entry->type;
     }
-}
-
-uint32_t KVStore::find_value_in_ssts(uint32_t key) {
-    for (auto &level : levels) {
-        for (auto &sst_path : level.sst_list) {
-            uint32_t value = BTreeNode::search_value_by_key(key, sst_path, &buffer_pool);
-            if (value == Utils::TOMB_STONE) {
-                return Utils::INVALID_VALUE;  // Key does not exist since it has been
-                                              // deleted.
-            } else if (value != Utils::INVALID_VALUE) {
-                return value;
+    if (take_entry(found, RangeTombstone::covers(version.flushing_range_tombstones, key))) {
+        return true;
+    }
+    for (const auto &level : version.levels) {
+        for (auto it = level.rbegin(); it != level.rend(); it++) {
+            const VersionFile &file = **it;
+            found = BTreeNode::search_value_by_key(key, file.get_path(), &buffer_pool, value, type,
+                                                   file.get_learned_index(), file.get_filter_layout());
+            // the SST's range tombstones delete the key in the older SSTs
+            if (take_entry(found, RangeTombstone::covers(file.get_range_tombstones(), key))) {
+                return true;
             }
         }
     }
 
-    return Utils::INVALID_VALUE;
+    if (has_operand) {
+        *value = operand;
+        *type = EntryType::MERGE;
+    }
+    return has_operand;
 }
 
 void KVStore::write_memtable_to_sst() {
-    std::vector<BTreeNode *> leaf_nodes;
-    BTreeNode::extract_leaf_nodes_from_avl(memtable.root, leaf_nodes);
-    if (leaf_nodes.size() == 0) {
-        return;
+    std::vector<BTreeNode::TypedEntry> entries;
+    std::vector<RangeTombstone> range_tombstones;
+    {
+        std::unique_lock<std::shared_mutex> lock(memtable_mutex);
+        // snapshots taken since the last flush still read from the memtable, they keep the versions they see
+        for (auto &snapshot : snapshots) {
+            if (!snapshot->is_memtable_copied) {
+                get_memtable_entries(0, UINT32_MAX, &snapshot->memtable_entries, snapshot->sequence);
+                snapshot->memtable_range_tombstones = get_memtable_range_tombstones(snapshot.get());
+                snapshot->is_memtable_copied = true;
+            }
+        }
+
+        get_memtable_entries(0, UINT32_MAX, &entries);
+        if (entries.size() == 0 && memtable_range_tombstones.empty()) {
+            return;
+        }
+        range_tombstones = std::move(memtable_range_tombstones);
+        current_memtable_entries = 0;
+        memtable->clear();
+        appended_entries.clear();
+        is_memtable_appending = true;
+        memtable_range_tombstones.clear();
+
+        // writes go on into the empty memtable while the SST is written, reads find its entries in the version
+        std::shared_ptr<Version> version = std::make_shared<Version>(*current_version);
+        version->flushing_entries = entries;
+        version->flushing_range_tombstones = RangeTombstone::coalesce(range_tombstones);
+        current_version = std::move(version);
+        // the results of the keys change in the SSTs
+        if (row_cache.get_capacity() > 0) {
+            std::vector<uint32_t> keys;
+            for (const BTreeNode::TypedEntry &entry : entries) {
+                keys.push_back(entry.key);
+            }
+            row_cache.invalidate(keys);
+            for (const RangeTombstone &tombstone : range_tombstones) {
+                row_cache.invalidate(tombstone.start_key, tombstone.end_key);
+            }
+        }
     }
 
     int sst_num = 0;
@@ -148,19 +819,117 @@ void KVStore::write_memtable_to_sst() {
 
     auto file_path = db_path / ("sst_" + std::to_string(sst_num) + ".dat");
 
-    std::ofstream file(file_path, std::ios::binary);
+    update_filter_allocation();
+    SSTBuilder builder(file_path, sst_options, 0, entries.size());
+    for (const BTreeNode::TypedEntry &entry : entries) {
+        builder.add(entry.key, entry.value, entry.type);
+    }
+    for (const RangeTombstone &tombstone : range_tombstones) {
+        builder.add_range_tombstone(tombstone.start_key, tombstone.end_key);
+    }
+    builder.finish();
+    sst_count++;
+
+    Level::update_levels(levels, file_path, db_path, buffer_pool, sst_options, &manifest);
+    install_version();
+}
 
-    if (!file.is_open()) {
-        throw std::runtime_error("Failed to open file: " + file_path.string());
+bool KVStore::level_overlaps(int level, uint32_t start_key, uint32_t end_key) const {
+    if (level >= (int)levels.size()) {
+        return false;
     }
+    for (const fs::path &sst_path : levels[level].sst_list) {
+        const FileMetaData *meta = manifest.find_file(level, sst_path.filename().string());
+        if (meta == nullptr || (meta->min_key <= end_key && start_key <= meta->max_key)) {
+            return true;
+        }
+        for (const RangeTombstone &tombstone : version_files.at(sst_path)->get_range_tombstones()) {
+            if (tombstone.start_key <= end_key && start_key <= tombstone.end_key) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
 
-    // Build internal nodes
-    BTreeNode::construct_internal_nodes_and_write_to_file(leaf_nodes, std::move(file));
-    file.close();
+void KVStore::update_filter_allocation(int min_num_levels) {
+    if (filter_memory_budget <= 0) {
+        return;
+    }
+    // plan for the levels the tree has after the next flush: a compaction only adds one once every level is
+    // full. Planning for a level that does not exist yet would leave its share of the budget unused.
+    bool is_full = true;
+    for (const Level &level : levels) {
+        is_full = is_full && level.is_full();
+    }
+    int num_levels = std::max<int>(levels.size() + (is_full ? 1 : 0), min_num_levels);
+    std::vector<double> entries_per_level;
+    for (int level = 0; level < num_levels; level++) {
+        entries_per_level.push_back(Level::get_max_entries(level, memtable_size));
+    }
+    sst_options.level_bits_per_entry = BloomFilter::get_optimal_bits_per_entry(entries_per_level, filter_memory_budget);
+}
 
-    sst_count++;
-    current_memtable_entries = 0;
-    memtable.clear();
+void KVStore::install_version() {
+    std::shared_ptr<Version> version = std::make_shared<Version>();
+    std::map<fs::path, std::shared_ptr<const VersionFile>> live_files;
+    for (auto &level : levels) {
+        version->levels.emplace_back();
+        for (auto &sst_path : level.sst_list) {
+            // a file name is only reused after the file has left the tree, so an SST that was
+            // already live in the last version still has the same content
+            auto it = version_files.find(sst_path);
+            std::shared_ptr<const VersionFile> file;
+            if (it != version_files.end()) {
+                file = it->second;
+            } else {
+                fs::path link_path;
+                do {
+                    link_path = db_path / (link_prefix + std::to_string(next_link_id++) + ".sst");
+                } while (fs::exists(link_path));
+                file = std::make_shared<VersionFile>(sst_path, link_path, &buffer_pool);
+            }
+            live_files[sst_path] = file;
+            version->levels.back().push_back(file);
+        }
+    }
+    version_files = std::move(live_files);
+    update_pinned_ssts();
+
+    // the old version is dropped once the lock is released, its SSTs that no read holds any more with it
+    std::shared_ptr<const Version> old_version;
+    std::unique_lock<std::shared_mutex> lock(memtable_mutex);
+    old_version = std::move(current_version);
+    current_version = std::move(version);
+    is_closed = false;
+}
+
+void KVStore::reopen_if_closed() {
+    if (is_closed) {
+        std::lock_guard<std::mutex> flush_lock(flush_mutex);
+        if (is_closed) {
+            install_version();
+        }
+    }
+}
 
-    Level::update_levels(levels, file_path, db_path, buffer_pool);
+void KVStore::update_pinned_ssts() {
+    std::set<fs::path> links;
+    // a closed store has no links to pin until it installs a Version again
+    if (pin_level0 && !version_files.empty() && !levels.empty()) {
+        for (auto &sst_path : levels[0].sst_list) {
+            links.insert(version_files[sst_path]->get_path());
+        }
+    }
+    for (auto &link_path : pinned_links) {
+        if (links.count(link_path) == 0) {
+            buffer_pool.unpin_sst(link_path);
+        }
+    }
+    for (auto &link_path : links) {
+        if (pinned_links.count(link_path) == 0) {
+            buffer_pool.pin_sst(link_path);
+        }
+    }
+    pinned_links = std::move(links);
 }
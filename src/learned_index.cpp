@@ -0,0 +1,108 @@
+#include "learned_index.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "page_search.hpp"
+
+LearnedIndex::LearnedIndex(int entries_per_leaf) : entries_per_leaf(entries_per_leaf) {}
+
+void LearnedIndex::start_segment(uint32_t key) {
+    segments.push_back({key, (uint32_t)num_entries, 0});
+    first_keys.push_back(key);
+    // positions only grow with keys, so the slope is never negative
+    min_slope = 0;
+    max_slope = std::numeric_limits<double>::infinity();
+}
+
+void LearnedIndex::add(uint32_t key) {
+    if (segments.empty()) {
+        start_segment(key);
+    } else {
+        // narrow the cone of slopes that keep this key within EPSILON of its position
+        const Segment& segment = segments.back();
+        double dx = (double)key - segment.first_key;
+        double dy = (double)num_entries - segment.first_position;
+        double low = std::max(min_slope, (dy - EPSILON) / dx);
+        double high = std::min(max_slope, (dy + EPSILON) / dx);
+        if (low > high) {
+            finish();
+            start_segment(key);
+        } else {
+            min_slope = low;
+            max_slope = high;
+        }
+    }
+    num_entries++;
+}
+
+void LearnedIndex::finish() {
+    if (segments.empty()) {
+        return;
+    }
+    // a segment with a single key has no upper bound on its slope
+    segments.back().slope = std::isinf(max_slope) ? min_slope : (min_slope + max_slope) / 2;
+}
+
+int LearnedIndex::predict(uint32_t key) const {
+    int num_segments = segments.size();
+    // last segment whose first key is <= key
+    int index = PageSearch::lower_bound(first_keys.data(), num_segments, key);
+    if (index == num_segments || first_keys[index] != key) {
+        index--;
+    }
+    if (index < 0) {
+        return 0;
+    }
+    const Segment& segment = segments[index];
+    double position = segment.first_position + segment.slope * ((double)key - segment.first_key);
+    // keys after the last key of a segment are extrapolated, but they come before the next segment
+    int limit = index + 1 < num_segments ? segments[index + 1].first_position : num_entries;
+    return (int)std::min((double)limit, std::floor(position));
+}
+
+void LearnedIndex::get_search_window(uint32_t key, int* first_leaf, int* predicted_leaf, int* last_leaf) const {
+    int last_position = std::max(0, num_entries - 1);
+    int position = predict(key);
+    // one more position than EPSILON for rounding, and one more for keys that are not in the SST,
+    // whose position is the one of the next key
+    int first_position = std::max(0, position - EPSILON - 2);
+    *first_leaf = first_position / entries_per_leaf;
+    *predicted_leaf = std::min(position, last_position) / entries_per_leaf;
+    *last_leaf = std::min(position + EPSILON + 2, last_position) / entries_per_leaf;
+}
+
+void LearnedIndex::set_first_leaf_offset(int offset) { first_leaf_offset = offset; }
+
+int LearnedIndex::get_leaf_offset(int leaf) const { return first_leaf_offset + leaf; }
+
+int LearnedIndex::get_num_entries() const { return num_entries; }
+
+int LearnedIndex::get_num_segments() const { return segments.size(); }
+
+std::vector<LearnedIndex::Block> LearnedIndex::to_blocks() const {
+    int num_blocks = std::max(1, (int)std::ceil(segments.size() / (double)SEGMENTS_PER_BLOCK));
+    std::vector<Block> blocks(num_blocks);
+    for (int i = 0; i < num_blocks; i++) {
+        blocks[i].num_entries = num_entries;
+        blocks[i].entries_per_leaf = entries_per_leaf;
+        blocks[i].first_leaf_offset = first_leaf_offset;
+        blocks[i].num_segments = std::min(SEGMENTS_PER_BLOCK, (int)segments.size() - i * SEGMENTS_PER_BLOCK);
+        std::copy_n(segments.begin() + i * SEGMENTS_PER_BLOCK, blocks[i].num_segments, blocks[i].segments);
+    }
+    return blocks;
+}
+
+LearnedIndex LearnedIndex::from_blocks(const std::vector<Block>& blocks) {
+    LearnedIndex index(blocks[0].entries_per_leaf);
+    index.num_entries = blocks[0].num_entries;
+    index.first_leaf_offset = blocks[0].first_leaf_offset;
+    for (const Block& block : blocks) {
+        for (int i = 0; i < block.num_segments; i++) {
+            index.segments.push_back(block.segments[i]);
+            index.first_keys.push_back(block.segments[i].first_key);
+        }
+    }
+    return index;
+}
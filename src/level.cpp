@@ -27,11 +27,23 @@ int Level::extract_number_from_filename(const std::string& file_name) {
     return -1;
 }
 
-void Level::compact(std::filesystem::path db_path, int sst_num, bool is_last_level) {
+void Level::compact(std::filesystem::path db_path, int sst_num, int level_num, bool is_last_level,
+                    const SSTOptions& options, Manifest* manifest) {
     std::filesystem::path new_sst_path = db_path / ("sst_" + std::to_string(sst_num) + ".dat");
 
     // TODO rewrite the merging code to use buffers and handle updates
-    BTreeNode::merge_ssts(sst_list[0], sst_list[1], new_sst_path, is_last_level);
+    BTreeNode::merge_ssts(sst_list[0], sst_list[1], new_sst_path, is_last_level, options, level_num + 1);
+
+    // Log the compaction before removing its inputs, a crash in between only leaves orphaned files
+    // which are deleted the next time the database is opened
+    if (manifest != nullptr) {
+        VersionEdit edit;
+        for (const auto& old_sst_path : sst_list) {
+            edit.remove_file(level_num, old_sst_path.filename().string());
+        }
+        edit.add_file(get_file_meta(level_num + 1, new_sst_path));
+        manifest->log_and_apply(edit);
+    }
 
     // Remove old SSTables
     for (const auto& old_sst_path : sst_list) {
@@ -46,14 +58,24 @@ void Level::compact(std::filesystem::path db_path, int sst_num, bool is_last_lev
 }
 
 void Level::update_levels(std::vector<Level>& levels, std::filesystem::path sst_path, std::filesystem::path db_path,
-                          BufferPool& buffer_pool) {
+                          BufferPool& buffer_pool, const SSTOptions& options, Manifest* manifest) {
     if (levels.size() == 0) {
         add_new_level(levels);
     }
     // add to current level
     levels[0].sst_list.push_back(sst_path);
+    if (manifest != nullptr) {
+        VersionEdit edit;
+        edit.add_file(get_file_meta(0, sst_path));
+        manifest->log_and_apply(edit);
+    }
+    compact_levels(levels, 0, db_path, buffer_pool, options, manifest);
+}
+
+void Level::compact_levels(std::vector<Level>& levels, int level_num, std::filesystem::path db_path,
+                           BufferPool& buffer_pool, const SSTOptions& options, Manifest* manifest) {
     // compaction, we use a while loop because compaction can happen recursively
-    int current_level = 0;
+    int current_level = level_num;
     while (current_level < (int)levels.size()) {
         // Level& level = levels[current_level];
         if ((int)levels[current_level].sst_list.size() >= SIZE_RATIO) {
@@ -66,13 +88,9 @@ void Level::update_levels(std::vector<Level>& levels, std::filesystem::path sst_
             }
 
             // remove SSTs from the buffer pool because their pages are no longer
-            // valid
+            // valid (compressed SSTs have more pages than their file size suggests)
             for (auto& sst : levels[current_level].sst_list) {
-                // get the number of pages the sst has based on its file size
-                int num_pages = std::ceil(std::filesystem::file_size(sst) / (double)Utils::PAGE_SIZE);
-                for (int i = 0; i < num_pages; i++) {
-                    buffer_pool.remove(Page::generate_page_id(sst, i));
-                }
+                buffer_pool.remove_sst(sst);
             }
 
             // generate the new SST number
@@ -81,7 +99,7 @@ void Level::update_levels(std::vector<Level>& levels, std::filesystem::path sst_
 
             // check if we are at the last level
             // this is used for the merge function to know whether to delete tombstones
-            levels[current_level].compact(db_path, new_sst_num, is_last_level);
+            levels[current_level].compact(db_path, new_sst_num, current_level, is_last_level, options, manifest);
             // note that now the level itself contains the compacted SST
             //  we now manually move it to the next level
             levels[current_level + 1].sst_list.push_back(levels[current_level].sst_list[0]);
@@ -97,6 +115,16 @@ void Level::update_levels(std::vector<Level>& levels, std::filesystem::path sst_
     }
 }
 
+void Level::load_from_manifest(std::vector<Level>& levels, const Manifest& manifest, std::filesystem::path db_path) {
+    levels.clear();
+    for (int level = 0; level < manifest.get_num_levels(); level++) {
+        add_new_level(levels);
+        for (const auto& meta : manifest.get_files(level)) {
+            levels[level].sst_list.push_back(db_path / meta.file_name);
+        }
+    }
+}
+
 void Level::load_into_lsm_tree(std::vector<Level>& levels, std::filesystem::path sst_path) {
     int sst_num = extract_number_from_filename(sst_path);
     // because the SST numbers are static, we can use them to infer the
@@ -108,6 +136,40 @@ void Level::load_into_lsm_tree(std::vector<Level>& levels, std::filesystem::path
     levels[level].sst_list.push_back(sst_path);
 }
 
+std::filesystem::path Level::install_sst(std::vector<Level>& levels, int level_num, std::filesystem::path sst_path,
+                                         std::filesystem::path db_path, Manifest* manifest) {
+    while ((int)levels.size() <= level_num) {
+        add_new_level(levels);
+    }
+    int sst_num = level_num * SIZE_RATIO + levels[level_num].sst_list.size();
+    std::filesystem::path new_sst_path = db_path / ("sst_" + std::to_string(sst_num) + ".dat");
+    // the file is not part of the tree until the manifest says so, a crash in between leaves an orphaned file
+    std::filesystem::rename(sst_path, new_sst_path);
+    levels[level_num].sst_list.push_back(new_sst_path);
+    if (manifest != nullptr) {
+        VersionEdit edit;
+        edit.add_file(get_file_meta(level_num, new_sst_path));
+        manifest->log_and_apply(edit);
+    }
+    return new_sst_path;
+}
+
+FileMetaData Level::get_file_meta(int level_num, std::filesystem::path sst_path) {
+    FileMetaData meta;
+    meta.file_name = sst_path.filename().string();
+    meta.level = level_num;
+    meta.file_size = std::filesystem::file_size(sst_path);
+    BTreeNode::read_key_range(sst_path, &meta.min_key, &meta.max_key);
+    return meta;
+}
+
+int64_t Level::get_max_entries(int level_num, int memtable_size) {
+    // level i holds up to SIZE_RATIO - 1 SSTs, each made of SIZE_RATIO^i memtables
+    return (int64_t)memtable_size * std::pow(SIZE_RATIO, level_num) * (SIZE_RATIO - 1);
+}
+
+bool Level::is_full() const { return (int)sst_list.size() >= SIZE_RATIO - 1; }
+
 void Level::add_new_level(std::vector<Level>& levels) {
     Level new_level;
     levels.push_back(new_level);
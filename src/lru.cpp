@@ -52,6 +52,7 @@ void LRU::update(std::string key) {
             node->next->prev = node->prev;
         }
         front->prev = node;
+        node->prev = nullptr;
         node->next = front;
         front = node;
     }
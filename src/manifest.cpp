@@ -0,0 +1,285 @@
+#include "manifest.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <set>
+#include <stdexcept>
+
+#include "xxhash.h"
+
+namespace {
+
+/*
+ * Encoding helpers, all integers are stored in host byte order like the SST pages
+ */
+template <typename T>
+void put_fixed(std::string* dst, T value) {
+    dst->append((const char*)&value, sizeof(T));
+}
+
+template <typename T>
+bool get_fixed(const std::string& src, size_t* pos, T* value) {
+    if (*pos + sizeof(T) > src.size()) {
+        return false;
+    }
+    std::memcpy(value, src.data() + *pos, sizeof(T));
+    *pos += sizeof(T);
+    return true;
+}
+
+void put_string(std::string* dst, const std::string& value) {
+    put_fixed<uint16_t>(dst, value.size());
+    dst->append(value);
+}
+
+bool get_string(const std::string& src, size_t* pos, std::string* value) {
+    uint16_t size;
+    if (!get_fixed(src, pos, &size) || *pos + size > src.size()) {
+        return false;
+    }
+    value->assign(src.data() + *pos, size);
+    *pos += size;
+    return true;
+}
+
+// fsync a file or a directory, std::ofstream does not give its file descriptor
+void sync_path(const fs::path& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("Failed to open file: " + path.string());
+    }
+    bool synced = ::fsync(fd) == 0;
+    ::close(fd);
+    if (!synced) {
+        throw std::runtime_error("Failed to sync file: " + path.string());
+    }
+}
+
+}  // namespace
+
+/*
+ * VersionEdit
+ */
+void VersionEdit::add_file(const FileMetaData& meta) { added_files.push_back(meta); }
+
+void VersionEdit::remove_file(int level, const std::string& file_name) { removed_files.push_back({level, file_name}); }
+
+void VersionEdit::encode(std::string* dst) const {
+    put_fixed<uint32_t>(dst, removed_files.size());
+    for (auto& [level, file_name] : removed_files) {
+        put_fixed<int32_t>(dst, level);
+        put_string(dst, file_name);
+    }
+    put_fixed<uint32_t>(dst, added_files.size());
+    for (auto& meta : added_files) {
+        put_fixed<int32_t>(dst, meta.level);
+        put_fixed<uint32_t>(dst, meta.min_key);
+        put_fixed<uint32_t>(dst, meta.max_key);
+        put_fixed<uint64_t>(dst, meta.file_size);
+        put_string(dst, meta.file_name);
+    }
+}
+
+bool VersionEdit::decode(const std::string& src) {
+    size_t pos = 0;
+    uint32_t count;
+    if (!get_fixed(src, &pos, &count)) {
+        return false;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        int32_t level;
+        std::string file_name;
+        if (!get_fixed(src, &pos, &level) || !get_string(src, &pos, &file_name)) {
+            return false;
+        }
+        remove_file(level, file_name);
+    }
+    if (!get_fixed(src, &pos, &count)) {
+        return false;
+    }
+    for (uint32_t i = 0; i < count; i++) {
+        FileMetaData meta;
+        int32_t level;
+        if (!get_fixed(src, &pos, &level) || !get_fixed(src, &pos, &meta.min_key) ||
+            !get_fixed(src, &pos, &meta.max_key) || !get_fixed(src, &pos, &meta.file_size) ||
+            !get_string(src, &pos, &meta.file_name)) {
+            return false;
+        }
+        meta.level = level;
+        add_file(meta);
+    }
+    return pos == src.size();
+}
+
+/*
+ * Manifest
+ */
+bool Manifest::open(const fs::path& db_path) {
+    this->db_path = db_path;
+    files_per_level.clear();
+    edits_since_checkpoint = 0;
+
+    fs::path manifest_path = db_path / FILE_NAME;
+    bool exists = fs::exists(manifest_path);
+    if (exists) {
+        // replay all complete records in one sequential pass
+        std::ifstream file(manifest_path, std::ios::binary);
+        while (true) {
+            uint32_t size;
+            uint64_t checksum;
+            if (!file.read((char*)&size, sizeof(size)) || !file.read((char*)&checksum, sizeof(checksum))) {
+                break;
+            }
+            std::string payload(size, '\0');
+            if (!file.read(payload.data(), size) || XXH64(payload.data(), size, 0) != checksum) {
+                std::cerr << "Ignoring torn record at the end of " << manifest_path << std::endl;
+                break;
+            }
+            VersionEdit edit;
+            if (!edit.decode(payload)) {
+                std::cerr << "Ignoring malformed record in " << manifest_path << std::endl;
+                break;
+            }
+            apply(edit);
+            edits_since_checkpoint++;
+        }
+        file.close();
+        // rewrite it so that a torn tail (if any) is not followed by new records
+        checkpoint();
+    } else {
+        open_log();
+    }
+    return exists;
+}
+
+void Manifest::log_and_apply(const VersionEdit& edit) {
+    append_record(log, db_path / FILE_NAME, edit);
+    apply(edit);
+
+    edits_since_checkpoint++;
+    if (edits_since_checkpoint >= CHECKPOINT_INTERVAL) {
+        checkpoint();
+    }
+}
+
+void Manifest::checkpoint() {
+    if (db_path.empty()) {
+        // never opened
+        return;
+    }
+    VersionEdit snapshot;
+    for (auto& files : files_per_level) {
+        for (auto& meta : files) {
+            snapshot.add_file(meta);
+        }
+    }
+
+    // write the snapshot next to the log, then rename it over the log (rename is atomic)
+    fs::path temp_path = db_path / (std::string(FILE_NAME) + ".tmp");
+    std::ofstream temp(temp_path, std::ios::binary | std::ios::trunc);
+    if (!temp.is_open()) {
+        throw std::runtime_error("Failed to open file: " + temp_path.string());
+    }
+    append_record(temp, temp_path, snapshot);
+    temp.close();
+
+    if (log.is_open()) {
+        log.close();
+    }
+    fs::rename(temp_path, db_path / FILE_NAME);
+    // the rename is only durable once the directory is synced
+    sync_path(db_path);
+    open_log();
+    edits_since_checkpoint = 0;
+}
+
+void Manifest::remove_orphan_files() {
+    std::set<std::string> live_files;
+    for (auto& files : files_per_level) {
+        for (auto& meta : files) {
+            live_files.insert(meta.file_name);
+        }
+    }
+
+    for (const auto& entry : fs::directory_iterator(db_path)) {
+        if (!fs::is_regular_file(entry)) {
+            continue;
+        }
+        std::string extension = entry.path().extension().string();
+        std::string file_name = entry.path().filename().string();
+        if ((extension == ".dat" || extension == ".tmp") && live_files.count(file_name) == 0) {
+            fs::remove(entry.path());
+        }
+    }
+}
+
+int Manifest::get_num_levels() const { return files_per_level.size(); }
+
+const std::vector<FileMetaData>& Manifest::get_files(int level) const { return files_per_level.at(level); }
+
+const FileMetaData* Manifest::find_file(int level, const std::string& file_name) const {
+    if (level >= (int)files_per_level.size()) {
+        return nullptr;
+    }
+    for (auto& meta : files_per_level[level]) {
+        if (meta.file_name == file_name) {
+            return &meta;
+        }
+    }
+    return nullptr;
+}
+
+void Manifest::apply(const VersionEdit& edit) {
+    for (auto& [level, file_name] : edit.removed_files) {
+        if (level >= (int)files_per_level.size()) {
+            continue;
+        }
+        auto& files = files_per_level[level];
+        files.erase(std::remove_if(files.begin(), files.end(),
+                                   [&](const FileMetaData& meta) { return meta.file_name == file_name; }),
+                    files.end());
+    }
+    for (auto& meta : edit.added_files) {
+        while ((int)files_per_level.size() <= meta.level) {
+            files_per_level.emplace_back();
+        }
+        files_per_level[meta.level].push_back(meta);
+    }
+}
+
+void Manifest::append_record(std::ofstream& file, const fs::path& path, const VersionEdit& edit) {
+    std::string payload;
+    edit.encode(&payload);
+    uint32_t size = payload.size();
+    uint64_t checksum = XXH64(payload.data(), size, 0);
+
+    // one write per record so that a crash leaves at most one torn record at the end
+    std::string record;
+    put_fixed(&record, size);
+    put_fixed(&record, checksum);
+    record.append(payload);
+    file.write(record.data(), record.size());
+    file.flush();
+    if (!file) {
+        throw std::runtime_error("Failed to write file: " + path.string());
+    }
+    // the record is on disk before the caller deletes the files it removes
+    sync_path(path);
+}
+
+void Manifest::open_log() {
+    fs::path manifest_path = db_path / FILE_NAME;
+    bool exists = fs::exists(manifest_path);
+    log.open(manifest_path, std::ios::binary | std::ios::app);
+    if (!log.is_open()) {
+        throw std::runtime_error("Failed to open file: " + manifest_path.string());
+    }
+    // a new log is only durable once the directory that names it is synced
+    if (!exists) {
+        sync_path(db_path);
+    }
+}
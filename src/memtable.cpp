@@ -0,0 +1,17 @@
+#include "memtable.hpp"
+
+#include <stdexcept>
+#include <string>
+
+#include "avl_tree.hpp"
+#include "b_plus_tree.hpp"
+
+std::unique_ptr<Memtable> Memtable::create(MemtableType type) {
+    switch (type) {
+        case MemtableType::AVL_TREE:
+            return std::make_unique<AVLTree>();
+        case MemtableType::B_PLUS_TREE:
+            return std::make_unique<BPlusTree>();
+    }
+    throw std::runtime_error("Unknown memtable type: " + std::to_string((int)type));
+}
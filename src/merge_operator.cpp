@@ -0,0 +1,15 @@
+#include "merge_operator.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+
+uint32_t MergeOperator::apply(const MergeOperator* merge_operator, uint32_t existing, uint32_t operand) {
+    if (merge_operator == nullptr) {
+        throw std::runtime_error("Found merge operands but no merge operator is set");
+    }
+    return merge_operator->merge(existing, operand);
+}
+
+uint32_t AddOperator::merge(uint32_t existing, uint32_t operand) const { return existing + operand; }
+
+uint32_t MaxOperator::merge(uint32_t existing, uint32_t operand) const { return std::max(existing, operand); }
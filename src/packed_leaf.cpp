@@ -0,0 +1,157 @@
+#include "packed_leaf.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define PACKED_LEAF_X86
+#include <immintrin.h>
+#endif
+
+namespace {
+
+int get_num_bytes(int num_entries, int bits) { return ((int64_t)num_entries * bits + 7) / 8; }
+
+inline uint32_t read_field(const uint8_t* src, int index, int bits) {
+    uint64_t bit = (uint64_t)index * bits;
+    uint64_t word;
+    std::memcpy(&word, src + (bit >> 3), sizeof(word));
+    return (word >> (bit & 7)) & ((1ULL << bits) - 1);
+}
+
+inline void write_field(uint8_t* dst, int index, int bits, uint32_t field) {
+    uint64_t bit = (uint64_t)index * bits;
+    uint64_t word;
+    std::memcpy(&word, dst + (bit >> 3), sizeof(word));
+    word |= (uint64_t)field << (bit & 7);
+    std::memcpy(dst + (bit >> 3), &word, sizeof(word));
+}
+
+void unpack_fields_scalar(const uint8_t* src, int num_entries, int bits, uint32_t base, uint32_t* out) {
+    for (int i = 0; i < num_entries; i++) {
+        out[i] = base + read_field(src, i, bits);
+    }
+}
+
+#ifdef PACKED_LEAF_X86
+__attribute__((target("avx2"))) void unpack_fields_avx2(const uint8_t* src, int num_entries, int bits,
+                                                        uint32_t base, uint32_t* out) {
+    // each 64-bit lane loads the 8 bytes holding its field and shifts it into place
+    const __m256i mask = _mm256_set1_epi64x((1ULL << bits) - 1);
+    const __m256i seven = _mm256_set1_epi64x(7);
+    const __m256i step = _mm256_set1_epi64x(4 * (int64_t)bits);
+    const __m256i low_halves = _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6);
+    const __m128i base_vector = _mm_set1_epi32(base);
+    __m256i bit = _mm256_setr_epi64x(0, bits, 2 * (int64_t)bits, 3 * (int64_t)bits);
+    int i = 0;
+    for (; i + 4 <= num_entries; i += 4) {
+        __m256i words = _mm256_i64gather_epi64((const long long*)src, _mm256_srli_epi64(bit, 3), 1);
+        __m256i fields = _mm256_and_si256(_mm256_srlv_epi64(words, _mm256_and_si256(bit, seven)), mask);
+        __m128i packed = _mm256_castsi256_si128(_mm256_permutevar8x32_epi32(fields, low_halves));
+        _mm_storeu_si128((__m128i*)(out + i), _mm_add_epi32(packed, base_vector));
+        bit = _mm256_add_epi64(bit, step);
+    }
+    for (; i < num_entries; i++) {
+        out[i] = base + read_field(src, i, bits);
+    }
+}
+#endif
+
+void unpack_fields(const uint8_t* src, int num_entries, int bits, uint32_t base, uint32_t* out) {
+#ifdef PACKED_LEAF_X86
+    static const bool has_avx2 = __builtin_cpu_supports("avx2");
+    if (has_avx2) {
+        unpack_fields_avx2(src, num_entries, bits, base, out);
+        return;
+    }
+#endif
+    unpack_fields_scalar(src, num_entries, bits, base, out);
+}
+
+}  // namespace
+
+int PackedLeaf::get_bit_width(uint32_t range) { return range == 0 ? 0 : 32 - __builtin_clz(range); }
+
+bool PackedLeaf::fits(int num_entries, int key_bits, int value_bits, int type_bits) {
+    int num_bytes = get_num_bytes(num_entries, key_bits) + get_num_bytes(num_entries, value_bits) +
+                    get_num_bytes(num_entries, type_bits);
+    return num_entries <= MAX_ENTRIES && num_bytes + SLACK_BYTES <= DATA_BYTES;
+}
+
+void PackedLeaf::pack(const uint32_t* keys, const uint32_t* values, const EntryType* types, int num_entries) {
+    // the values of deletions are left out of the frame of reference, and stored as min_value
+    uint32_t max_value = 0;
+    uint8_t max_type = 0;
+    min_value = Utils::INVALID_VALUE;
+    min_type = num_entries > 0 ? (uint8_t)types[0] : 0;
+    for (int i = 0; i < num_entries; i++) {
+        if (types[i] != EntryType::DELETION) {
+            min_value = std::min(min_value, values[i]);
+            max_value = std::max(max_value, values[i]);
+        }
+        min_type = std::min(min_type, (uint8_t)types[i]);
+        max_type = std::max(max_type, (uint8_t)types[i]);
+    }
+    if (max_value < min_value) {
+        min_value = 0;
+    }
+    num_keys = num_entries;
+    min_key = num_entries > 0 ? keys[0] : 0;
+    key_bits = get_bit_width(num_entries > 0 ? keys[num_entries - 1] - min_key : 0);
+    value_bits = get_bit_width(max_value - min_value);
+    type_bits = get_bit_width(max_type - min_type);
+
+    std::memset(data, 0, DATA_BYTES);
+    uint8_t* values_data = data + get_num_bytes(num_entries, key_bits);
+    uint8_t* types_data = values_data + get_num_bytes(num_entries, value_bits);
+    for (int i = 0; i < num_entries; i++) {
+        write_field(data, i, key_bits, keys[i] - min_key);
+        if (types[i] != EntryType::DELETION) {
+            write_field(values_data, i, value_bits, values[i] - min_value);
+        }
+        write_field(types_data, i, type_bits, (uint8_t)types[i] - min_type);
+    }
+}
+
+const uint8_t* PackedLeaf::get_values_data() const { return data + get_num_bytes(num_keys, key_bits); }
+
+const uint8_t* PackedLeaf::get_types_data() const {
+    return get_values_data() + get_num_bytes(num_keys, value_bits);
+}
+
+uint32_t PackedLeaf::get_key(int index) const { return min_key + read_field(data, index, key_bits); }
+
+uint32_t PackedLeaf::get_value(int index) const {
+    return min_value + read_field(get_values_data(), index, value_bits);
+}
+
+EntryType PackedLeaf::get_type(int index) const {
+    return (EntryType)(min_type + read_field(get_types_data(), index, type_bits));
+}
+
+int PackedLeaf::lower_bound(uint32_t key) const {
+    if (num_keys == 0 || key <= min_key) {
+        return 0;
+    }
+    // compare in the packed domain, without adding min_key back
+    uint32_t delta = key - min_key;
+    int base = 0;
+    int len = num_keys;
+    while (len > 1) {
+        int half = len / 2;
+        base = read_field(data, base + half, key_bits) < delta ? base + half : base;
+        len -= half;
+    }
+    return base + (read_field(data, base, key_bits) < delta);
+}
+
+void PackedLeaf::unpack(uint32_t* keys, uint32_t* values, EntryType* types) const {
+    unpack_fields(data, num_keys, key_bits, min_key, keys);
+    unpack_fields(get_values_data(), num_keys, value_bits, min_value, values);
+    // types are a frame-of-reference stream of at most 2 bits per entry (none if the leaf has a single type),
+    // too narrow to be worth the SIMD path
+    const uint8_t* types_data = get_types_data();
+    for (int i = 0; i < num_keys; i++) {
+        types[i] = (EntryType)(min_type + read_field(types_data, i, type_bits));
+    }
+}
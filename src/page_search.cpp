@@ -0,0 +1,157 @@
+#include "page_search.hpp"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define PAGE_SEARCH_X86
+#include <immintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_NEON)
+#define PAGE_SEARCH_NEON
+#include <arm_neon.h>
+#endif
+
+namespace {
+
+// number of keys left for the linear part of the search, a few vectors for each kernel
+const int SCALAR_WINDOW = 8;
+const int AVX2_WINDOW = 32;
+const int AVX512_WINDOW = 64;
+const int NEON_WINDOW = 16;
+
+// Narrow keys[0, n) down to a window of at most window_size keys that holds the answer.
+// Returns the start of the window, *n becomes its size.
+inline const uint32_t* narrow(const uint32_t* keys, int* n, uint32_t key, int window_size) {
+    const uint32_t* base = keys;
+    int len = *n;
+    while (len > window_size) {
+        int half = len / 2;
+        // no branch on the comparison, it compiles to a conditional move
+        base = base[half - 1] < key ? base + half : base;
+        len -= half;
+    }
+    *n = len;
+    return base;
+}
+
+int lower_bound_scalar(const uint32_t* keys, int n, uint32_t key) {
+    const uint32_t* base = narrow(keys, &n, key, SCALAR_WINDOW);
+    int count = 0;
+    for (int i = 0; i < n; i++) {
+        count += base[i] < key;
+    }
+    return base - keys + count;
+}
+
+#ifdef PAGE_SEARCH_X86
+__attribute__((target("avx2"))) int lower_bound_avx2(const uint32_t* keys, int n, uint32_t key) {
+    const uint32_t* base = narrow(keys, &n, key, AVX2_WINDOW);
+    // AVX2 only compares signed integers, flipping the sign bit of both sides gives the unsigned order
+    const __m256i sign = _mm256_set1_epi32(INT32_MIN);
+    const __m256i target = _mm256_xor_si256(_mm256_set1_epi32(key), sign);
+    int count = 0;
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i v = _mm256_xor_si256(_mm256_loadu_si256((const __m256i*)(base + i)), sign);
+        __m256i less = _mm256_cmpgt_epi32(target, v);
+        count += __builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(less)));
+    }
+    for (; i < n; i++) {
+        count += base[i] < key;
+    }
+    return base - keys + count;
+}
+
+__attribute__((target("avx512f"))) int lower_bound_avx512(const uint32_t* keys, int n, uint32_t key) {
+    const uint32_t* base = narrow(keys, &n, key, AVX512_WINDOW);
+    const __m512i target = _mm512_set1_epi32(key);
+    int count = 0;
+    for (int i = 0; i < n; i += 16) {
+        // the last vector only loads the keys that are left
+        __mmask16 valid = n - i >= 16 ? 0xFFFF : (__mmask16)((1u << (n - i)) - 1);
+        __m512i v = _mm512_maskz_loadu_epi32(valid, base + i);
+        count += __builtin_popcount(_mm512_mask_cmplt_epu32_mask(valid, v, target));
+    }
+    return base - keys + count;
+}
+#endif
+
+#ifdef PAGE_SEARCH_NEON
+int lower_bound_neon(const uint32_t* keys, int n, uint32_t key) {
+    const uint32_t* base = narrow(keys, &n, key, NEON_WINDOW);
+    const uint32x4_t target = vdupq_n_u32(key);
+    int count = 0;
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        // lanes are all ones where the key is smaller, keep one bit of each
+        uint32x4_t less = vcltq_u32(vld1q_u32(base + i), target);
+        count += vaddvq_u32(vshrq_n_u32(less, 31));
+    }
+    for (; i < n; i++) {
+        count += base[i] < key;
+    }
+    return base - keys + count;
+}
+#endif
+
+PageSearch::Kernel detect_kernel() {
+#if defined(PAGE_SEARCH_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        return PageSearch::Kernel::AVX512;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        return PageSearch::Kernel::AVX2;
+    }
+#elif defined(PAGE_SEARCH_NEON)
+    return PageSearch::Kernel::NEON;
+#endif
+    return PageSearch::Kernel::SCALAR;
+}
+
+}  // namespace
+
+namespace PageSearch {
+
+Kernel get_active_kernel() {
+    static const Kernel kernel = detect_kernel();
+    return kernel;
+}
+
+bool is_supported(Kernel kernel) {
+    switch (kernel) {
+        case Kernel::SCALAR:
+            return true;
+#if defined(PAGE_SEARCH_X86)
+        case Kernel::AVX2:
+            return __builtin_cpu_supports("avx2");
+        case Kernel::AVX512:
+            return __builtin_cpu_supports("avx512f");
+#elif defined(PAGE_SEARCH_NEON)
+        case Kernel::NEON:
+            return true;
+#endif
+        default:
+            return false;
+    }
+}
+
+int lower_bound(const uint32_t* keys, int n, uint32_t key, Kernel kernel) {
+    switch (kernel) {
+#if defined(PAGE_SEARCH_X86)
+        case Kernel::AVX2:
+            return lower_bound_avx2(keys, n, key);
+        case Kernel::AVX512:
+            return lower_bound_avx512(keys, n, key);
+#elif defined(PAGE_SEARCH_NEON)
+        case Kernel::NEON:
+            return lower_bound_neon(keys, n, key);
+#endif
+        default:
+            return lower_bound_scalar(keys, n, key);
+    }
+}
+
+int lower_bound(const uint32_t* keys, int n, uint32_t key) {
+    static const Kernel kernel = get_active_kernel();
+    return lower_bound(keys, n, key, kernel);
+}
+
+}  // namespace PageSearch
@@ -0,0 +1,114 @@
+#include "range_filter.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+#include "xxhash.h"
+
+RangeFilter::RangeFilter(int num_entries, int num_blocks) {
+    this->min_key = Utils::INVALID_VALUE;
+    this->max_key = 0;
+    this->total_bits = MAX_BITMAP_BYTES * 8;
+    for (int i = 0; i < MAX_BITMAP_BYTES; i++) {
+        this->bitmap[i] = 0;
+    }
+    // optimal number of hash functions for the bits available per inserted prefix
+    double bits_per_prefix = total_bits * num_blocks / (double)std::max(1, num_entries * NUM_PREFIX_SHIFTS);
+    this->hash_functions = std::clamp((int)std::round(std::log(2) * bits_per_prefix), 1, MAX_HASH_FUNCTIONS);
+}
+
+void RangeFilter::insert_prefix(uint32_t prefix, int shift) {
+    for (int i = 0; i < hash_functions; i++) {
+        int bit = hash(prefix, shift, i);
+        bitmap[bit / 8] |= 1 << (bit % 8);
+    }
+}
+
+bool RangeFilter::probe(uint32_t prefix, int shift) {
+    for (int i = 0; i < hash_functions; i++) {
+        int bit = hash(prefix, shift, i);
+        if ((bitmap[bit / 8] & (1 << (bit % 8))) == 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool RangeFilter::overlaps(uint32_t start_key, uint32_t end_key) const {
+    return start_key <= end_key && start_key <= max_key && end_key >= min_key;
+}
+
+int RangeFilter::get_num_blocks(int num_entries) {
+    int bits_per_block = MAX_BITMAP_BYTES * 8;
+    return std::max(1, (int)std::ceil((double)num_entries * BITS_PER_ENTRY / bits_per_block));
+}
+
+int RangeFilter::get_block_index(uint32_t prefix, int shift, int num_blocks) {
+    // the group and the prefix length are hashed together, a different input than the bits of a prefix
+    uint64_t group = ((uint64_t)shift << 32) | (prefix >> GROUP_SHIFT);
+    return XXH64(&group, sizeof(uint64_t), 0) % num_blocks;
+}
+
+std::vector<RangeFilter> RangeFilter::create_blocks(int num_entries) {
+    int num_blocks = get_num_blocks(num_entries);
+    return std::vector<RangeFilter>(num_blocks, RangeFilter(num_entries, num_blocks));
+}
+
+void RangeFilter::insert(std::vector<RangeFilter>& blocks, uint32_t key) {
+    // the key range is tracked by the first block and copied to the others by finish()
+    blocks[0].min_key = std::min(blocks[0].min_key, key);
+    blocks[0].max_key = std::max(blocks[0].max_key, key);
+    for (int shift : PREFIX_SHIFTS) {
+        uint32_t prefix = key >> shift;
+        blocks[get_block_index(prefix, shift, blocks.size())].insert_prefix(prefix, shift);
+    }
+}
+
+void RangeFilter::finish(std::vector<RangeFilter>& blocks) {
+    for (auto& block : blocks) {
+        block.min_key = blocks[0].min_key;
+        block.max_key = blocks[0].max_key;
+    }
+}
+
+bool RangeFilter::may_contain(std::vector<RangeFilter>& blocks, uint32_t start_key, uint32_t end_key) {
+    if (!blocks[0].overlaps(start_key, end_key)) {
+        return false;
+    }
+    int shift;
+    uint32_t first_prefix, last_prefix;
+    if (!get_probe_range(start_key, end_key, &shift, &first_prefix, &last_prefix)) {
+        return true;
+    }
+    for (uint32_t prefix = first_prefix;; prefix++) {
+        if (blocks[get_block_index(prefix, shift, blocks.size())].probe(prefix, shift)) {
+            return true;
+        }
+        if (prefix == last_prefix) {
+            return false;
+        }
+    }
+}
+
+bool RangeFilter::get_probe_range(uint32_t start_key, uint32_t end_key, int* shift, uint32_t* first_prefix,
+                                  uint32_t* last_prefix) {
+    // every key in the range has its prefix in [start_key >> shift, end_key >> shift],
+    // so the range is empty if none of those prefixes was inserted
+    for (int prefix_shift : PREFIX_SHIFTS) {
+        if ((end_key >> prefix_shift) - (start_key >> prefix_shift) < MAX_PROBES) {
+            *shift = prefix_shift;
+            *first_prefix = start_key >> prefix_shift;
+            *last_prefix = end_key >> prefix_shift;
+            return true;
+        }
+    }
+    return false;
+}
+
+// double hashing, seeded by the prefix length so that equal prefixes of different lengths differ
+int RangeFilter::hash(uint32_t prefix, int shift, int i) {
+    uint64_t h = XXH64(&prefix, sizeof(uint32_t), shift);
+    uint32_t h1 = h;
+    uint32_t h2 = (h >> 32) | 1;
+    return (h1 + (uint64_t)i * h2) % total_bits;
+}
@@ -0,0 +1,26 @@
+#include "range_tombstone.hpp"
+
+#include <algorithm>
+
+std::vector<RangeTombstone> RangeTombstone::coalesce(std::vector<RangeTombstone> tombstones) {
+    std::sort(tombstones.begin(), tombstones.end(),
+              [](const RangeTombstone& a, const RangeTombstone& b) { return a.start_key < b.start_key; });
+    std::vector<RangeTombstone> result;
+    for (const RangeTombstone& tombstone : tombstones) {
+        // ranges that overlap or touch are merged
+        if (!result.empty() &&
+            (tombstone.start_key <= result.back().end_key || tombstone.start_key - 1 == result.back().end_key)) {
+            result.back().end_key = std::max(result.back().end_key, tombstone.end_key);
+        } else {
+            result.push_back({tombstone.start_key, tombstone.end_key});
+        }
+    }
+    return result;
+}
+
+bool RangeTombstone::covers(const std::vector<RangeTombstone>& coalesced, uint32_t key) {
+    // the last range that starts at or before the key
+    auto it = std::upper_bound(coalesced.begin(), coalesced.end(), key,
+                               [](uint32_t key, const RangeTombstone& tombstone) { return key < tombstone.start_key; });
+    return it != coalesced.begin() && key <= (it - 1)->end_key;
+}
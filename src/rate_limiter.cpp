@@ -0,0 +1,106 @@
+#include "rate_limiter.hpp"
+
+#include <algorithm>
+#include <thread>
+
+RateLimiter::RateLimiter(int64_t bytes_per_sec, bool auto_tune, double target_latency_us) {
+    this->bytes_per_sec = std::max<int64_t>(bytes_per_sec, 1);
+    this->max_bytes_per_sec = this->bytes_per_sec;
+    this->min_bytes_per_sec = std::max<int64_t>(this->bytes_per_sec / MIN_RATE_DIVISOR, 1);
+    this->available_bytes = 0;
+    this->last_refill = Clock::now();
+    this->charge_reads = false;
+    this->auto_tune = auto_tune;
+    this->target_latency_us = target_latency_us;
+    this->latency_ewma_us = 0;
+    this->samples_since_tune = 0;
+    this->total_bytes_through = 0;
+}
+
+// Add the tokens accumulated since the last refill, capped to the burst size.
+// The caller must hold the mutex.
+void RateLimiter::refill() {
+    Clock::time_point now = Clock::now();
+    double elapsed_sec = std::chrono::duration<double>(now - last_refill).count();
+    last_refill = now;
+    double burst = bytes_per_sec * BURST_SECONDS;
+    available_bytes = std::min(burst, available_bytes + elapsed_sec * bytes_per_sec);
+}
+
+void RateLimiter::request(int64_t bytes) {
+    double wait_sec = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        refill();
+        available_bytes -= bytes;
+        total_bytes_through += bytes;
+        if (available_bytes < 0) {
+            // the debt is paid off by the refills that happen while we sleep
+            wait_sec = -available_bytes / bytes_per_sec;
+        }
+    }
+    if (wait_sec > 0) {
+        std::this_thread::sleep_for(std::chrono::duration<double>(wait_sec));
+    }
+}
+
+void RateLimiter::request_read(int64_t bytes) {
+    bool charge;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        charge = charge_reads;
+    }
+    if (charge) {
+        request(bytes);
+    }
+}
+
+void RateLimiter::record_foreground_latency(double latency_us) {
+    if (!auto_tune) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex);
+    if (latency_ewma_us == 0) {
+        latency_ewma_us = latency_us;
+    } else {
+        latency_ewma_us = LATENCY_EWMA_WEIGHT * latency_us + (1 - LATENCY_EWMA_WEIGHT) * latency_ewma_us;
+    }
+
+    samples_since_tune++;
+    if (samples_since_tune < AUTO_TUNE_INTERVAL) {
+        return;
+    }
+    samples_since_tune = 0;
+
+    // back off quickly when foreground reads suffer, recover slowly when they are well below target
+    if (latency_ewma_us > target_latency_us) {
+        bytes_per_sec = std::max(min_bytes_per_sec, (int64_t)(bytes_per_sec * BACKOFF_FACTOR));
+    } else if (latency_ewma_us < target_latency_us / 2) {
+        bytes_per_sec = std::min(max_bytes_per_sec, (int64_t)(bytes_per_sec * RECOVERY_FACTOR) + 1);
+    }
+}
+
+void RateLimiter::set_bytes_per_sec(int64_t new_bytes_per_sec) {
+    std::lock_guard<std::mutex> lock(mutex);
+    refill();
+    bytes_per_sec = std::max<int64_t>(new_bytes_per_sec, 1);
+    max_bytes_per_sec = bytes_per_sec;
+    min_bytes_per_sec = std::max<int64_t>(bytes_per_sec / MIN_RATE_DIVISOR, 1);
+}
+
+void RateLimiter::set_charge_reads(bool charge) {
+    std::lock_guard<std::mutex> lock(mutex);
+    charge_reads = charge;
+}
+
+int64_t RateLimiter::get_bytes_per_sec() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return bytes_per_sec;
+}
+
+int64_t RateLimiter::get_total_bytes_through() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return total_bytes_through;
+}
+
+bool RateLimiter::is_auto_tune() const { return auto_tune; }
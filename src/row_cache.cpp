@@ -0,0 +1,105 @@
+#include "row_cache.hpp"
+
+RowCache::RowCache(int64_t capacity) : capacity(capacity) {}
+
+bool RowCache::get(uint32_t key, bool *found, uint32_t *value, EntryType *type) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (capacity == 0) {
+        return false;
+    }
+    auto it = row_map.find(key);
+    if (it == row_map.end()) {
+        num_misses++;
+        return false;
+    }
+    num_hits++;
+    rows.splice(rows.begin(), rows, it->second);
+    *found = it->second->found;
+    *value = it->second->value;
+    *type = it->second->type;
+    return true;
+}
+
+void RowCache::insert(uint32_t key, bool found, uint32_t value, EntryType type, uint64_t epoch) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (capacity == 0 || epoch != this->epoch) {
+        return;
+    }
+    remove_row(key);
+    if ((int64_t)rows.size() == capacity) {
+        row_map.erase(rows.back().key);
+        rows.pop_back();
+    }
+    rows.push_front({key, found, value, type});
+    row_map[key] = rows.begin();
+}
+
+uint64_t RowCache::get_epoch() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return epoch;
+}
+
+void RowCache::invalidate(const std::vector<uint32_t> &keys) {
+    std::lock_guard<std::mutex> lock(mutex);
+    epoch++;
+    for (uint32_t key : keys) {
+        remove_row(key);
+    }
+}
+
+void RowCache::invalidate(uint32_t start_key, uint32_t end_key) {
+    std::lock_guard<std::mutex> lock(mutex);
+    epoch++;
+    if ((uint64_t)end_key - start_key < rows.size()) {
+        for (uint64_t key = start_key; key <= end_key; key++) {
+            remove_row(key);
+        }
+        return;
+    }
+    // the range has more keys than the cache has rows
+    for (auto it = rows.begin(); it != rows.end();) {
+        if (start_key <= it->key && it->key <= end_key) {
+            row_map.erase(it->key);
+            it = rows.erase(it);
+        } else {
+            it++;
+        }
+    }
+}
+
+void RowCache::remove_row(uint32_t key) {
+    auto it = row_map.find(key);
+    if (it != row_map.end()) {
+        rows.erase(it->second);
+        row_map.erase(it);
+    }
+}
+
+void RowCache::set_capacity(int64_t new_capacity) {
+    std::lock_guard<std::mutex> lock(mutex);
+    capacity = new_capacity;
+    while ((int64_t)rows.size() > capacity) {
+        row_map.erase(rows.back().key);
+        rows.pop_back();
+    }
+}
+
+int64_t RowCache::get_capacity() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return capacity;
+}
+
+int64_t RowCache::get_size() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return rows.size();
+}
+
+int64_t RowCache::get_num_hits() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return num_hits;
+}
+
+int64_t RowCache::get_num_misses() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return num_misses;
+}
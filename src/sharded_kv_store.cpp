@@ -0,0 +1,133 @@
+#include "sharded_kv_store.hpp"
+
+#include <algorithm>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+
+#include "utils.hpp"
+#include "xxhash.h"
+
+ShardedKVStore::ShardedKVStore(int num_shards, int memtable_size, int initial_size, int max_size,
+                               ShardingType sharding_type)
+    : sharding_type(sharding_type) {
+    if (num_shards < 1) {
+        throw std::runtime_error("A sharded store needs at least one shard: " + std::to_string(num_shards));
+    }
+    int shard_initial_size = std::max(1, initial_size / num_shards);
+    int shard_max_size = std::max(shard_initial_size, max_size / num_shards);
+    for (int i = 0; i < num_shards; i++) {
+        shards.push_back(std::make_unique<KVStore>(memtable_size, shard_initial_size, shard_max_size));
+    }
+}
+
+void ShardedKVStore::open(const std::string &name) {
+    fs::path db_path = fs::current_path() / name;
+    if (!fs::exists(db_path)) {
+        fs::create_directory(db_path);
+    }
+    // the keys of a shard would be looked up in another one
+    int num_shard_dirs = 0;
+    for (const auto &entry : fs::directory_iterator(db_path)) {
+        num_shard_dirs += entry.is_directory() && entry.path().filename().string().rfind("shard_", 0) == 0;
+    }
+    if (num_shard_dirs != 0 && num_shard_dirs != (int)shards.size()) {
+        throw std::runtime_error("The sharded store " + name + " has " + std::to_string(num_shard_dirs) +
+                                 " shards, not " + std::to_string(shards.size()));
+    }
+    for (int i = 0; i < (int)shards.size(); i++) {
+        shards[i]->open((fs::path(name) / ("shard_" + std::to_string(i))).string());
+    }
+}
+
+void ShardedKVStore::close() {
+    for (auto &shard : shards) {
+        shard->close();
+    }
+}
+
+void ShardedKVStore::put(uint32_t key, uint32_t value) { shards[get_shard_index(key)]->put(key, value); }
+
+uint32_t ShardedKVStore::get(uint32_t key) { return shards[get_shard_index(key)]->get(key); }
+
+bool ShardedKVStore::get(uint32_t key, uint32_t *value) { return shards[get_shard_index(key)]->get(key, value); }
+
+void ShardedKVStore::delete_key(uint32_t key) { shards[get_shard_index(key)]->delete_key(key); }
+
+void ShardedKVStore::merge(uint32_t key, uint32_t operand) { shards[get_shard_index(key)]->merge(key, operand); }
+
+void ShardedKVStore::delete_range(uint32_t start_key, uint32_t end_key) {
+    if (start_key > end_key) {
+        return;
+    }
+    if (sharding_type == ShardingType::HASH) {
+        // any shard may hold keys of the range
+        for (auto &shard : shards) {
+            shard->delete_range(start_key, end_key);
+        }
+        return;
+    }
+    for (int i = get_shard_index(start_key); i <= get_shard_index(end_key); i++) {
+        uint32_t range_end = i + 1 < (int)shards.size() ? get_range_start(i + 1) - 1 : UINT32_MAX;
+        shards[i]->delete_range(std::max(start_key, get_range_start(i)), std::min(end_key, range_end));
+    }
+}
+
+void ShardedKVStore::write(const WriteBatch &batch) {
+    std::vector<WriteBatch> shard_batches(shards.size());
+    for (const BTreeNode::TypedEntry &operation : batch.get_operations()) {
+        WriteBatch &shard_batch = shard_batches[get_shard_index(operation.key)];
+        if (operation.type == EntryType::DELETION) {
+            shard_batch.delete_key(operation.key);
+        } else if (operation.type == EntryType::MERGE) {
+            shard_batch.merge(operation.key, operation.value);
+        } else {
+            shard_batch.put(operation.key, operation.value);
+        }
+    }
+    for (int i = 0; i < (int)shards.size(); i++) {
+        if (shard_batches[i].get_num_operations() > 0) {
+            shards[i]->write(shard_batches[i]);
+        }
+    }
+}
+
+std::vector<std::pair<uint32_t, uint32_t>> ShardedKVStore::scan(uint32_t start_key, uint32_t end_key) {
+    std::vector<std::pair<uint32_t, uint32_t>> result;
+    if (start_key > end_key) {
+        return result;
+    }
+    if (sharding_type == ShardingType::RANGE) {
+        // the shards of the range hold consecutive parts of it
+        for (int i = get_shard_index(start_key); i <= get_shard_index(end_key); i++) {
+            std::vector<std::pair<uint32_t, uint32_t>> shard_result = shards[i]->scan(start_key, end_key);
+            result.insert(result.end(), shard_result.begin(), shard_result.end());
+        }
+        return result;
+    }
+    // every shard holds keys of the range, their sorted results are merged as they come (a key is in one shard)
+    for (auto &shard : shards) {
+        std::vector<std::pair<uint32_t, uint32_t>> shard_result = shard->scan(start_key, end_key);
+        size_t middle = result.size();
+        result.insert(result.end(), shard_result.begin(), shard_result.end());
+        std::inplace_merge(result.begin(), result.begin() + middle, result.end());
+    }
+    return result;
+}
+
+int ShardedKVStore::get_num_shards() const { return shards.size(); }
+
+int ShardedKVStore::get_shard_index(uint32_t key) const {
+    if (sharding_type == ShardingType::HASH) {
+        return XXH64(&key, sizeof(uint32_t), 0) % shards.size();
+    }
+    // equal ranges of the key space, the last one takes the remainder
+    return ((uint64_t)key * shards.size()) >> 32;
+}
+
+KVStore &ShardedKVStore::get_shard(int index) { return *shards[index]; }
+
+uint32_t ShardedKVStore::get_range_start(int index) const {
+    // the smallest key whose shard is the index
+    return (((uint64_t)index << 32) + shards.size() - 1) / shards.size();
+}
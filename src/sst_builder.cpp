@@ -0,0 +1,342 @@
+#include "sst_builder.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include "compression.hpp"
+#include "packed_leaf.hpp"
+#include "utils.hpp"
+
+SSTBuilder::SSTBuilder(std::filesystem::path file_path, const SSTOptions& options, int level,
+                       int64_t expected_num_entries)
+    : file(file_path, std::ios::binary),
+      options(options),
+      learned_index(BTreeNode::MAX_KEYS),
+      use_learned_index(options.use_learned_index && options.leaf_format == LeafFormat::PLAIN &&
+                        options.compression == CompressionType::NONE) {
+    if (!file.is_open()) {
+        throw std::runtime_error("Failed to open file: " + file_path.string());
+    }
+    filter = std::make_unique<BloomFilter>(options.get_bits_per_entry(level), expected_num_entries);
+    if (options.use_range_filter) {
+        range_filter = RangeFilter::create_blocks(expected_num_entries);
+    }
+    if (options.compression != CompressionType::NONE) {
+        block.resize(BTreeNode::LEAVES_PER_BLOCK * Utils::PAGE_SIZE);
+    }
+}
+
+// Write a page, throttled by the rate limiter if there is one
+void SSTBuilder::write_page(int offset, const char* data, std::streamsize size) {
+    if (options.rate_limiter != nullptr) {
+        options.rate_limiter->request(Utils::PAGE_SIZE);
+    }
+    // the bloom filter and the root stay in place
+    file.seekp(Utils::PAGE_SIZE * (offset + (offset > 1 ? page_shift : 0)));
+    file.write(data, size);
+}
+
+bool SSTBuilder::leaf_has_room(uint32_t key, uint32_t value, EntryType type) const {
+    int num_keys = leaf_keys.size();
+    if (options.leaf_format == LeafFormat::PLAIN) {
+        return num_keys < BTreeNode::MAX_KEYS;
+    }
+    if (options.leaf_format == LeafFormat::HASHED) {
+        return num_keys < BTreeNode::HASHED_MAX_KEYS;
+    }
+    // the widths the packed leaf would need with this entry, the values of deletions are not stored
+    uint32_t min_value = min_leaf_value;
+    uint32_t max_value = max_leaf_value;
+    if (type != EntryType::DELETION) {
+        min_value = std::min(min_value, value);
+        max_value = std::max(max_value, value);
+    }
+    int key_bits = PackedLeaf::get_bit_width(key - leaf_keys[0]);
+    int value_bits = PackedLeaf::get_bit_width(max_value < min_value ? 0 : max_value - min_value);
+    int type_bits = PackedLeaf::get_bit_width(std::max(max_leaf_type, (uint8_t)type) -
+                                              std::min(min_leaf_type, (uint8_t)type));
+    return PackedLeaf::fits(num_keys + 1, key_bits, value_bits, type_bits);
+}
+
+void SSTBuilder::add(uint32_t key, uint32_t value, EntryType type) {
+    if (!leaf_keys.empty() && !leaf_has_room(key, value, type)) {
+        write_leaf();
+    }
+    if (leaf_keys.empty()) {
+        min_leaf_value = Utils::INVALID_VALUE;
+        max_leaf_value = 0;
+        min_leaf_type = (uint8_t)type;
+        max_leaf_type = (uint8_t)type;
+    }
+    leaf_keys.push_back(key);
+    leaf_values.push_back(value);
+    leaf_types.push_back(type);
+    if (type != EntryType::DELETION) {
+        min_leaf_value = std::min(min_leaf_value, value);
+        max_leaf_value = std::max(max_leaf_value, value);
+    }
+    min_leaf_type = std::min(min_leaf_type, (uint8_t)type);
+    max_leaf_type = std::max(max_leaf_type, (uint8_t)type);
+
+    filter->insert(key);
+    if (options.use_range_filter) {
+        RangeFilter::insert(range_filter, key);
+    }
+    if (use_learned_index) {
+        learned_index.add(key);
+    }
+    num_entries++;
+}
+
+void SSTBuilder::add_range_tombstone(uint32_t start_key, uint32_t end_key) {
+    range_tombstones.push_back({start_key, end_key});
+}
+
+bool SSTBuilder::can_append_leaves(std::filesystem::path sst_path) const {
+    if (!leaf_keys.empty() || options.compression != CompressionType::NONE || options.use_range_filter ||
+        use_learned_index) {
+        return false;
+    }
+    std::ifstream sst_file(sst_path, std::ios::binary);
+    std::unique_ptr<BTreeNode> root = std::make_unique<BTreeNode>();
+    sst_file.seekg(Utils::PAGE_SIZE);
+    sst_file.read((char*)root.get(), sizeof(BTreeNode));
+    return sst_file && root->leaf_format == options.leaf_format && root->compression == CompressionType::NONE &&
+           root->num_range_filter_blocks == 0 && root->num_learned_index_blocks == 0 &&
+           root->num_range_tombstones == 0;
+}
+
+void SSTBuilder::append_leaves(std::filesystem::path sst_path) {
+    std::ifstream sst_file(sst_path, std::ios::binary);
+    std::unique_ptr<BTreeNode> root = std::make_unique<BTreeNode>();
+    sst_file.seekg(Utils::PAGE_SIZE);
+    sst_file.read((char*)root.get(), sizeof(BTreeNode));
+    if (root->num_entries == 0) {
+        // its only leaf is empty
+        return;
+    }
+    // the leaves are the pages from 2 on, in either leaf format
+    std::vector<char> page(Utils::PAGE_SIZE);
+    sst_file.seekg(Utils::PAGE_SIZE * 2);
+    for (int i = 0; i < root->num_of_leaf_nodes; i++) {
+        if (options.rate_limiter != nullptr) {
+            options.rate_limiter->request_read(Utils::PAGE_SIZE);
+        }
+        sst_file.read(page.data(), Utils::PAGE_SIZE);
+        int offset = 2 + leaf_delimiters.size();
+        uint32_t max_key;
+        // the keys go into the filter of this SST, which is sized for its own level and number of entries
+        if (options.leaf_format == LeafFormat::PACKED) {
+            const PackedLeaf* packed_leaf = (const PackedLeaf*)page.data();
+            for (int j = 0; j < packed_leaf->num_keys; j++) {
+                filter->insert(packed_leaf->get_key(j));
+            }
+            max_key = packed_leaf->get_key(packed_leaf->num_keys - 1);
+        } else {
+            BTreeNode* leaf = (BTreeNode*)page.data();
+            for (int j = 0; j < leaf->num_keys; j++) {
+                filter->insert(leaf->keys[j]);
+            }
+            leaf->file_offset = offset;
+            max_key = leaf->keys[leaf->num_keys - 1];
+        }
+        write_page(offset, page.data(), Utils::PAGE_SIZE);
+        leaf_delimiters.push_back({max_key, (uint32_t)offset});
+    }
+    num_entries += root->num_entries;
+}
+
+void SSTBuilder::write_leaf() {
+    int offset = 2 + leaf_delimiters.size();
+    int num_keys = leaf_keys.size();
+    std::unique_ptr<PackedLeaf> packed_leaf;
+    std::unique_ptr<BTreeNode> leaf;
+    const char* data;
+    std::streamsize size;
+    if (options.leaf_format == LeafFormat::PACKED) {
+        packed_leaf = std::make_unique<PackedLeaf>();
+        packed_leaf->pack(leaf_keys.data(), leaf_values.data(), leaf_types.data(), num_keys);
+        data = (const char*)packed_leaf.get();
+        size = sizeof(PackedLeaf);
+    } else {
+        leaf = std::make_unique<BTreeNode>();
+        std::copy(leaf_keys.begin(), leaf_keys.end(), leaf->keys);
+        std::copy(leaf_values.begin(), leaf_values.end(), leaf->values);
+        std::copy(leaf_types.begin(), leaf_types.end(), leaf->types);
+        leaf->num_keys = num_keys;
+        leaf->is_leaf = true;
+        leaf->file_offset = offset;
+        if (options.leaf_format == LeafFormat::HASHED) {
+            leaf->build_hash_index();
+        }
+        data = (const char*)leaf.get();
+        size = sizeof(BTreeNode);
+    }
+    if (options.compression == CompressionType::NONE) {
+        write_page(offset, data, size);
+    } else {
+        std::copy(data, data + size, block.data() + num_block_leaves * Utils::PAGE_SIZE);
+        num_block_leaves++;
+        if (num_block_leaves == BTreeNode::LEAVES_PER_BLOCK) {
+            write_block();
+        }
+    }
+    // an empty leaf only exists when the SST has no entries at all
+    leaf_delimiters.push_back({num_keys > 0 ? leaf_keys.back() : 0, (uint32_t)offset});
+    leaf_keys.clear();
+    leaf_values.clear();
+    leaf_types.clear();
+}
+
+void SSTBuilder::write_block() {
+    int block_size = num_block_leaves * Utils::PAGE_SIZE;
+    std::vector<char> compressed(Compression::get_max_compressed_size(block_size));
+    int compressed_size = Compression::compress(block.data(), block_size, compressed.data());
+    if (options.rate_limiter != nullptr) {
+        options.rate_limiter->request(compressed_size);
+    }
+    file.seekp(Utils::PAGE_SIZE * 2 + data_size);
+    file.write(compressed.data(), compressed_size);
+    block_handles.push_back({(uint32_t)data_size, (uint32_t)compressed_size});
+    data_size += compressed_size;
+
+    std::fill(block.begin(), block.end(), 0);
+    num_block_leaves = 0;
+}
+
+void SSTBuilder::finish() {
+    // an SST always has at least one leaf
+    if (!leaf_keys.empty() || leaf_delimiters.empty()) {
+        write_leaf();
+    }
+    if (num_block_leaves > 0) {
+        write_block();
+    }
+    if (options.compression != CompressionType::NONE) {
+        int num_data_pages = (data_size + Utils::PAGE_SIZE - 1) / Utils::PAGE_SIZE;
+        page_shift = num_data_pages - leaf_delimiters.size();
+    }
+    write_internal_nodes();
+    // the first page of the bloom filter, which is empty if it has no bits
+    std::vector<char> first_filter_page(Utils::PAGE_SIZE);
+    if (filter->get_num_pages() > 0) {
+        std::copy(filter->get_page(0), filter->get_page(0) + Utils::PAGE_SIZE, first_filter_page.begin());
+    }
+    write_page(0, first_filter_page.data(), Utils::PAGE_SIZE);
+    file.close();
+}
+
+namespace {
+
+int get_total_number_of_nodes(int num_of_leaf_nodes) {
+    if (num_of_leaf_nodes == 1) {
+        // this ensures that there is always a root node
+        return 2;
+    }
+    int current_level_node_count = num_of_leaf_nodes;
+    int total_number_of_nodes = num_of_leaf_nodes;
+    while (current_level_node_count > 1) {
+        // the number of internal nodes of the next level is ceil(number of children
+        // / (MAX + 1)) note that we add 1 to MAX because of how delimiter works
+        current_level_node_count = std::ceil(current_level_node_count / (BTreeNode::MAX_KEYS + 1.0));
+        total_number_of_nodes += current_level_node_count;
+    }
+    return total_number_of_nodes;
+}
+
+}  // namespace
+
+void SSTBuilder::write_internal_nodes() {
+    int num_of_leaf_nodes = leaf_delimiters.size();
+    int total_number_of_nodes = get_total_number_of_nodes(num_of_leaf_nodes);
+    int node_offset = num_of_leaf_nodes + 2;
+
+    // we process all of the nodes of one level to create the level above it,
+    // until a level has a single node, which is the root
+    std::vector<BTreeNode::Entry> queue = leaf_delimiters;
+    while (true) {
+        // because of how delimiters work, a node can have at most MAX_KEYS + 1 children
+        int num_nodes = std::ceil(queue.size() / (BTreeNode::MAX_KEYS + 1.0));
+        bool is_root = num_nodes == 1;
+        std::vector<BTreeNode::Entry> result;
+        for (int first = 0; first < (int)queue.size(); first += BTreeNode::MAX_KEYS + 1) {
+            std::unique_ptr<BTreeNode> internal_node = std::make_unique<BTreeNode>();
+            int n = std::min(BTreeNode::MAX_KEYS + 1, (int)queue.size() - first);
+            // each child is represented by its largest key and its offset
+            for (int i = 0; i < n; i++) {
+                internal_node->keys[i] = queue[first + i].key;
+                internal_node->values[i] = queue[first + i].value;
+            }
+            internal_node->num_keys = n;
+            internal_node->is_leaf = false;
+            internal_node->file_offset = is_root ? 1 : node_offset++;
+
+            if (is_root) {
+                // write metadata to root node, and the blocks that follow the nodes
+                internal_node->total_number_of_nodes = total_number_of_nodes;
+                internal_node->num_of_leaf_nodes = num_of_leaf_nodes;
+                internal_node->num_entries = num_entries;
+                internal_node->leaf_format = options.leaf_format;
+                internal_node->compression = options.compression;
+                internal_node->num_data_pages = num_of_leaf_nodes + page_shift;
+                int block_offset = total_number_of_nodes + 1;
+                if (options.use_range_filter) {
+                    RangeFilter::finish(range_filter);
+                    for (auto& block : range_filter) {
+                        write_page(block_offset++, (char*)&block, sizeof(RangeFilter));
+                    }
+                    internal_node->num_range_filter_blocks = range_filter.size();
+                }
+                if (use_learned_index) {
+                    learned_index.finish();
+                    learned_index.set_first_leaf_offset(2);
+                    std::vector<LearnedIndex::Block> blocks = learned_index.to_blocks();
+                    for (auto& block : blocks) {
+                        write_page(block_offset++, (char*)&block, sizeof(LearnedIndex::Block));
+                    }
+                    internal_node->num_learned_index_blocks = blocks.size();
+                }
+                if (options.compression != CompressionType::NONE) {
+                    // the handles of the blocks, in as many pages as needed
+                    for (int first = 0; first < (int)block_handles.size(); first += BTreeNode::HANDLES_PER_PAGE) {
+                        int n = std::min(BTreeNode::HANDLES_PER_PAGE, (int)block_handles.size() - first);
+                        std::vector<BTreeNode::BlockHandle> handles(BTreeNode::HANDLES_PER_PAGE);
+                        std::copy(block_handles.begin() + first, block_handles.begin() + first + n, handles.begin());
+                        write_page(block_offset++, (char*)handles.data(), Utils::PAGE_SIZE);
+                        internal_node->num_block_index_blocks++;
+                    }
+                }
+                // the range tombstones, in as many pages as needed
+                range_tombstones = RangeTombstone::coalesce(range_tombstones);
+                for (int first = 0; first < (int)range_tombstones.size();
+                     first += BTreeNode::RANGE_TOMBSTONES_PER_PAGE) {
+                    int n = std::min(BTreeNode::RANGE_TOMBSTONES_PER_PAGE, (int)range_tombstones.size() - first);
+                    std::vector<BTreeNode::Entry> entries(BTreeNode::RANGE_TOMBSTONES_PER_PAGE);
+                    for (int i = 0; i < n; i++) {
+                        entries[i] = {range_tombstones[first + i].start_key, range_tombstones[first + i].end_key};
+                    }
+                    write_page(block_offset++, (char*)entries.data(), Utils::PAGE_SIZE);
+                }
+                internal_node->num_range_tombstones = range_tombstones.size();
+                // the pages of the bloom filter but the first, which is written at page 0
+                for (int page = 1; page < filter->get_num_pages(); page++) {
+                    write_page(block_offset++, filter->get_page(page), Utils::PAGE_SIZE);
+                }
+                internal_node->num_filter_pages = filter->get_num_pages();
+                internal_node->filter_bits_per_page = filter->get_bits_per_page();
+                internal_node->num_filter_hash_functions = filter->get_num_hash_functions();
+            }
+            write_page(internal_node->file_offset, (char*)internal_node.get(), sizeof(BTreeNode));
+            result.push_back({internal_node->keys[n - 1], (uint32_t)internal_node->file_offset});
+        }
+        if (is_root) {
+            return;
+        }
+        queue = result;
+    }
+}
+
+int64_t SSTBuilder::get_num_entries() const { return num_entries; }
+
+int SSTBuilder::get_num_leaf_nodes() const { return leaf_delimiters.size(); }
@@ -0,0 +1,112 @@
+#include "sst_iterator.hpp"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+
+#include "compression.hpp"
+#include "utils.hpp"
+
+SSTIterator::SSTIterator(std::filesystem::path file_path, RateLimiter* rate_limiter)
+    : file(file_path, std::ios::binary),
+      rate_limiter(rate_limiter),
+      node(std::make_unique<BTreeNode>()),
+      packed_leaf(std::make_unique<PackedLeaf>()) {
+    if (!file.is_open()) {
+        throw std::runtime_error("Failed to open file: " + file_path.string());
+    }
+    // the root holds the number of leaves and their format
+    read_page(1, (char*)node.get(), sizeof(BTreeNode));
+    leaf_format = node->leaf_format;
+    compression = node->compression;
+    num_entries = node->num_entries;
+    leaf_offset = 2;
+    last_leaf_offset = node->num_of_leaf_nodes + 1;
+    if (compression != CompressionType::NONE) {
+        // the block index is small enough to be kept in memory, one handle per LEAVES_PER_BLOCK leaves
+        block_handles.resize(node->num_block_index_blocks * BTreeNode::HANDLES_PER_PAGE);
+        int first_block_offset = node->total_number_of_nodes + 1 + node->num_range_filter_blocks +
+                                 node->num_learned_index_blocks;
+        for (int i = 0; i < node->num_block_index_blocks; i++) {
+            read_page(node->get_page_in_file(first_block_offset + i),
+                      (char*)(block_handles.data() + i * BTreeNode::HANDLES_PER_PAGE), Utils::PAGE_SIZE);
+        }
+    }
+    read_leaf();
+}
+
+// Read a page, throttled by the rate limiter if it also limits reads
+void SSTIterator::read_page(int offset, char* data, std::streamsize size) {
+    if (rate_limiter != nullptr) {
+        rate_limiter->request_read(Utils::PAGE_SIZE);
+    }
+    file.seekg(Utils::PAGE_SIZE * offset);
+    file.read(data, size);
+}
+
+void SSTIterator::read_leaf_page(int offset, char* data, std::streamsize size) {
+    if (compression == CompressionType::NONE) {
+        read_page(offset, data, size);
+        return;
+    }
+    int leaf = offset - 2;
+    int block_index = leaf / BTreeNode::LEAVES_PER_BLOCK;
+    int first_leaf = block_index * BTreeNode::LEAVES_PER_BLOCK;
+    if (block_index != current_block) {
+        BTreeNode::BlockHandle handle = block_handles[block_index];
+        if (rate_limiter != nullptr) {
+            rate_limiter->request_read(handle.size);
+        }
+        std::vector<char> compressed_block(handle.size);
+        file.seekg(Utils::PAGE_SIZE * 2 + (int64_t)handle.offset);
+        file.read(compressed_block.data(), handle.size);
+        // the last block may hold fewer leaves
+        int num_leaves = std::min(BTreeNode::LEAVES_PER_BLOCK, last_leaf_offset - 1 - first_leaf);
+        block.resize(num_leaves * Utils::PAGE_SIZE);
+        if (!Compression::decompress(compressed_block.data(), handle.size, block.data(), block.size())) {
+            throw std::runtime_error("Corrupted block " + std::to_string(block_index));
+        }
+        current_block = block_index;
+    }
+    const char* page = block.data() + (leaf - first_leaf) * Utils::PAGE_SIZE;
+    std::copy(page, page + size, data);
+}
+
+void SSTIterator::read_leaf() {
+    index = 0;
+    num_keys = 0;
+    while (num_keys == 0 && leaf_offset <= last_leaf_offset) {
+        if (leaf_format == LeafFormat::PACKED) {
+            read_leaf_page(leaf_offset, (char*)packed_leaf.get(), sizeof(PackedLeaf));
+            num_keys = packed_leaf->num_keys;
+            keys.resize(num_keys);
+            values.resize(num_keys);
+            types.resize(num_keys);
+            packed_leaf->unpack(keys.data(), values.data(), types.data());
+        } else {
+            read_leaf_page(leaf_offset, (char*)node.get(), sizeof(BTreeNode));
+            num_keys = node->num_keys;
+            keys.assign(node->keys, node->keys + num_keys);
+            values.assign(node->values, node->values + num_keys);
+            types.assign(node->types, node->types + num_keys);
+        }
+        leaf_offset++;
+    }
+}
+
+bool SSTIterator::valid() const { return index < num_keys; }
+
+uint32_t SSTIterator::key() const { return keys[index]; }
+
+uint32_t SSTIterator::value() const { return values[index]; }
+
+EntryType SSTIterator::type() const { return types[index]; }
+
+void SSTIterator::next() {
+    index++;
+    if (index >= num_keys) {
+        read_leaf();
+    }
+}
+
+int64_t SSTIterator::get_num_entries() const { return num_entries; }
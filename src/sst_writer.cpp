@@ -0,0 +1,30 @@
+#include "sst_writer.hpp"
+
+#include <stdexcept>
+#include <string>
+
+SSTWriter::SSTWriter(std::filesystem::path file_path, int64_t expected_num_entries, const SSTOptions& options,
+                     int level)
+    : builder(file_path, options, level, expected_num_entries) {}
+
+void SSTWriter::add(uint32_t key, uint32_t value, EntryType type) {
+    if (builder.get_num_entries() > 0 && key <= last_key) {
+        throw std::runtime_error("SST keys are not strictly increasing at key " + std::to_string(key));
+    }
+    builder.add(key, value, type);
+    last_key = key;
+}
+
+void SSTWriter::put(uint32_t key, uint32_t value) { add(key, value, EntryType::VALUE); }
+
+void SSTWriter::delete_key(uint32_t key) { add(key, 0, EntryType::DELETION); }
+
+void SSTWriter::delete_range(uint32_t start_key, uint32_t end_key) {
+    if (start_key <= end_key) {
+        builder.add_range_tombstone(start_key, end_key);
+    }
+}
+
+void SSTWriter::finish() { builder.finish(); }
+
+int64_t SSTWriter::get_num_entries() const { return builder.get_num_entries(); }
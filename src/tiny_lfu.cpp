@@ -0,0 +1,57 @@
+#include "tiny_lfu.hpp"
+
+#include <algorithm>
+
+#include "xxhash.h"
+
+TinyLFU::TinyLFU(int capacity) {
+    // a sample of ten accesses per item as in the TinyLFU paper, and a counter per access of the sample in each
+    // row, so that the many items accessed once in a sample seldom share counters with the frequent ones
+    sample_size = 10 * std::max(capacity, 1);
+    width = 16;
+    while (width < sample_size) {
+        width *= 2;
+    }
+    counters.assign(DEPTH * width, 0);
+}
+
+int TinyLFU::get_index(uint64_t hash, int row) const {
+    // the rows take their counters from the two halves of one hash (double hashing)
+    uint32_t row_hash = (uint32_t)hash + row * (uint32_t)(hash >> 32);
+    return row * width + (row_hash & (width - 1));
+}
+
+void TinyLFU::record(const std::string &id) {
+    uint64_t hash = XXH64(id.data(), id.size(), 0);
+    for (int row = 0; row < DEPTH; row++) {
+        uint8_t &counter = counters[get_index(hash, row)];
+        if (counter < MAX_COUNT) {
+            counter++;
+        }
+    }
+    if (++num_records == sample_size) {
+        age();
+    }
+}
+
+int TinyLFU::estimate(const std::string &id) const {
+    uint64_t hash = XXH64(id.data(), id.size(), 0);
+    int estimate = MAX_COUNT;
+    for (int row = 0; row < DEPTH; row++) {
+        estimate = std::min(estimate, (int)counters[get_index(hash, row)]);
+    }
+    return estimate;
+}
+
+bool TinyLFU::admit(const std::string &candidate, const std::string &victim) const {
+    return estimate(candidate) > estimate(victim);
+}
+
+int TinyLFU::get_sample_size() const { return sample_size; }
+
+void TinyLFU::age() {
+    for (uint8_t &counter : counters) {
+        counter /= 2;
+    }
+    num_records = 0;
+}
@@ -0,0 +1,147 @@
+#include "value_log.hpp"
+
+#include <limits>
+#include <stdexcept>
+
+#include "xxhash.h"
+
+namespace {
+
+struct RecordHeader {
+    uint32_t key;
+    uint32_t size;
+    uint64_t checksum;
+};
+
+int64_t get_padded_size(int64_t size) {
+    return (size + ValueLog::ALIGNMENT - 1) / ValueLog::ALIGNMENT * ValueLog::ALIGNMENT;
+}
+
+// read the record at the current position of the file, false if it is torn or corrupt
+bool read_record(std::ifstream& file, int64_t bytes_left, uint32_t* key, std::string* value) {
+    RecordHeader header;
+    if (bytes_left < (int64_t)sizeof(header) || !file.read((char*)&header, sizeof(header)) ||
+        (int64_t)header.size > bytes_left - (int64_t)sizeof(header)) {
+        return false;
+    }
+    value->resize(header.size);
+    if (!file.read(value->data(), header.size) || XXH64(value->data(), header.size, 0) != header.checksum) {
+        return false;
+    }
+    *key = header.key;
+    return true;
+}
+
+}  // namespace
+
+void ValueLog::open(const fs::path& db_path) {
+    this->db_path = db_path;
+    head.close();
+    segments.clear();
+    for (const auto& entry : fs::directory_iterator(db_path)) {
+        if (!fs::is_regular_file(entry) || entry.path().extension() != EXTENSION) {
+            continue;
+        }
+        int64_t size = fs::file_size(entry.path());
+        // a record torn by a crash is never pointed to, but the next one must start aligned
+        if (size % ALIGNMENT != 0) {
+            size = get_padded_size(size);
+            fs::resize_file(entry.path(), size);
+        }
+        segments[std::stoul(entry.path().stem().string())] = size;
+    }
+    if (!segments.empty()) {
+        open_head(segments.rbegin()->first);
+    }
+}
+
+void ValueLog::set_segment_size(int64_t bytes) { segment_size = bytes; }
+
+fs::path ValueLog::get_segment_path(uint32_t first_pointer) const {
+    return db_path / (std::to_string(first_pointer) + EXTENSION);
+}
+
+void ValueLog::open_head(uint32_t first_pointer) {
+    head.close();
+    head.open(get_segment_path(first_pointer), std::ios::binary | std::ios::app);
+    if (!head.is_open()) {
+        throw std::runtime_error("Failed to open file: " + get_segment_path(first_pointer).string());
+    }
+    segments.insert({first_pointer, 0});
+}
+
+uint32_t ValueLog::append(uint32_t key, const std::string& value) {
+    if (segments.empty()) {
+        open_head(0);
+    }
+    auto last = std::prev(segments.end());
+    int64_t position = (int64_t)last->first * ALIGNMENT + last->second;
+    if (position / ALIGNMENT > std::numeric_limits<uint32_t>::max()) {
+        throw std::runtime_error("The value log is full");
+    }
+    if (last->second >= segment_size) {
+        open_head(position / ALIGNMENT);
+        last = std::prev(segments.end());
+    }
+
+    RecordHeader header = {key, (uint32_t)value.size(), XXH64(value.data(), value.size(), 0)};
+    int64_t record_size = get_padded_size(sizeof(header) + value.size());
+    std::string padding(record_size - sizeof(header) - value.size(), '\0');
+    head.write((const char*)&header, sizeof(header));
+    head.write(value.data(), value.size());
+    head.write(padding.data(), padding.size());
+    // the record is read back through another stream
+    head.flush();
+    last->second += record_size;
+    return position / ALIGNMENT;
+}
+
+bool ValueLog::read(uint32_t pointer, uint32_t* key, std::string* value) {
+    auto it = segments.upper_bound(pointer);
+    if (it == segments.begin()) {
+        return false;
+    }
+    it--;
+    int64_t offset = (int64_t)(pointer - it->first) * ALIGNMENT;
+    std::ifstream file(get_segment_path(it->first), std::ios::binary);
+    file.seekg(offset);
+    return read_record(file, it->second - offset, key, value);
+}
+
+void ValueLog::read_oldest_segment(std::vector<Record>* records) {
+    if (segments.empty()) {
+        return;
+    }
+    auto [first_pointer, size] = *segments.begin();
+    std::ifstream file(get_segment_path(first_pointer), std::ios::binary);
+    int64_t offset = 0;
+    Record record;
+    // one sequential read of the segment
+    while (offset < size && read_record(file, size - offset, &record.key, &record.value)) {
+        record.pointer = first_pointer + offset / ALIGNMENT;
+        offset += get_padded_size(sizeof(RecordHeader) + record.value.size());
+        file.seekg(offset);
+        records->push_back(record);
+    }
+}
+
+int64_t ValueLog::remove_oldest_segment() {
+    // pointers are positions in the log, so the head is kept for the log to go on from its end
+    if (segments.size() < 2) {
+        return 0;
+    }
+    auto [first_pointer, size] = *segments.begin();
+    fs::remove(get_segment_path(first_pointer));
+    segments.erase(segments.begin());
+    return size;
+}
+
+int ValueLog::get_num_segments() const { return segments.size(); }
+
+int64_t ValueLog::get_size() const {
+    int64_t size = 0;
+    for (auto& [first_pointer, segment_size] : segments) {
+        size += segment_size;
+    }
+    return size;
+}
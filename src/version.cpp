@@ -0,0 +1,29 @@
+#include "version.hpp"
+
+VersionFile::VersionFile(const std::filesystem::path &sst_path, const std::filesystem::path &link_path,
+                         BufferPool *buffer_pool)
+    : path(link_path), buffer_pool(buffer_pool) {
+    std::filesystem::create_hard_link(sst_path, link_path);
+    BTreeNode::read_key_range(path, &min_key, &max_key);
+    learned_index = BTreeNode::read_learned_index(path);
+    filter_layout = BTreeNode::read_filter_layout(path);
+    range_tombstones = BTreeNode::read_range_tombstones(path);
+}
+
+VersionFile::~VersionFile() {
+    buffer_pool->remove_sst(path);
+    std::error_code error;
+    std::filesystem::remove(path, error);
+}
+
+const std::filesystem::path &VersionFile::get_path() const { return path; }
+
+bool VersionFile::may_overlap(uint32_t start_key, uint32_t end_key) const {
+    return min_key <= end_key && start_key <= max_key;
+}
+
+const LearnedIndex *VersionFile::get_learned_index() const { return learned_index.get(); }
+
+const BTreeNode::FilterLayout *VersionFile::get_filter_layout() const { return &filter_layout; }
+
+const std::vector<RangeTombstone> &VersionFile::get_range_tombstones() const { return range_tombstones; }
@@ -0,0 +1,13 @@
+#include "write_batch.hpp"
+
+void WriteBatch::put(uint32_t key, uint32_t value) { operations.push_back({key, value, EntryType::VALUE}); }
+
+void WriteBatch::delete_key(uint32_t key) { operations.push_back({key, 0, EntryType::DELETION}); }
+
+void WriteBatch::merge(uint32_t key, uint32_t operand) { operations.push_back({key, operand, EntryType::MERGE}); }
+
+void WriteBatch::clear() { operations.clear(); }
+
+int WriteBatch::get_num_operations() const { return operations.size(); }
+
+const std::vector<BTreeNode::TypedEntry>& WriteBatch::get_operations() const { return operations; }
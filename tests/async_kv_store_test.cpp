@@ -0,0 +1,88 @@
+#include "async_kv_store.hpp"
+
+#include <cassert>
+#include <cstdint>
+#include <future>
+#include <iostream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "kv_store.hpp"
+#include "test_utils.hpp"
+#include "utils.hpp"
+
+void test_async_requests() {
+    const uint32_t num_keys = 5000;
+    KVStore kvstore(500, 16, 64);
+    kvstore.open("tests/test_db_1");
+    {
+        AsyncKVStore async_kvstore(&kvstore, 4);
+        // thousands of requests are outstanding at once on a few threads
+        std::vector<std::future<void>> puts;
+        for (uint32_t key = 0; key < num_keys; key++) {
+            puts.push_back(async_kvstore.async_put(key, key + 1));
+        }
+        for (std::future<void> &put : puts) {
+            put.get();
+        }
+
+        std::vector<std::future<uint32_t>> gets;
+        for (uint32_t key = 0; key <= num_keys; key++) {
+            gets.push_back(async_kvstore.async_get(key));
+        }
+        for (uint32_t key = 0; key < num_keys; key++) {
+            assert(gets[key].get() == key + 1);
+        }
+        assert(gets[num_keys].get() == Utils::INVALID_VALUE);
+
+        std::vector<std::pair<uint32_t, uint32_t>> result = async_kvstore.async_scan(100, 199).get();
+        assert(result.size() == 100 && result[0] == std::make_pair(100u, 101u));
+
+        // puts of a key are applied in the order they were issued
+        std::future<void> last_put;
+        for (uint32_t value = 0; value < 1000; value++) {
+            last_put = async_kvstore.async_put(7, value);
+        }
+        last_put.get();
+        assert(async_kvstore.async_get(7).get() == 999);
+    }
+    assert(kvstore.get(7) == 999);
+    kvstore.close();
+
+    std::cout << "test_async_requests passed!" << std::endl;
+}
+
+void test_failed_request() {
+    KVStore kvstore(10, 2, 8);
+    kvstore.open("tests/test_db_2");
+    // no merge operator to apply the operand to the value of the SST with
+    kvstore.put(1, 1);
+    kvstore.close();
+    kvstore.merge(1, 2);
+    AsyncKVStore async_kvstore(&kvstore, 2);
+    std::future<uint32_t> get = async_kvstore.async_get(1);
+    bool failed = false;
+    try {
+        get.get();
+    } catch (const std::runtime_error &) {
+        failed = true;
+    }
+    assert(failed);
+    assert(async_kvstore.async_get(2).get() == Utils::INVALID_VALUE);
+
+    std::cout << "test_failed_request passed!" << std::endl;
+}
+
+int main() {
+    Utils::clear_databases("tests", "test_db_");
+
+    test_async_requests();
+    test_failed_request();
+
+    Utils::clear_databases("tests", "test_db_");
+
+    std::cout << GREEN << "All tests passed!\n" << RESET << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,149 @@
+#include "b_plus_tree.hpp"
+
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "kv_store.hpp"
+#include "test_utils.hpp"
+#include "utils.hpp"
+
+// entries of [start_key, end_key] that the tree's scan visits
+std::vector<std::pair<uint32_t, uint32_t>> scan_tree(BPlusTree *tree, uint32_t start_key, uint32_t end_key,
+                                                     uint64_t max_sequence = Memtable::LATEST) {
+    std::vector<std::pair<uint32_t, uint32_t>> result;
+    tree->scan(
+        start_key, end_key, [&result](uint32_t key, uint32_t value, EntryType) { result.push_back({key, value}); },
+        max_sequence);
+    return result;
+}
+
+void test_put_and_get() {
+    BPlusTree tree;
+    uint32_t value;
+    EntryType type;
+    assert(tree.empty() && !tree.get(1, &value, &type));
+
+    // random keys split leaves and inner nodes in the middle, increasing keys fill them
+    std::map<uint32_t, uint32_t> expected;
+    std::mt19937 generator(42);
+    for (int i = 0; i < 100000; i++) {
+        uint32_t key = generator() % 50000;
+        tree.put(key, i);
+        expected[key] = i;
+    }
+    for (uint32_t key = 100000; key < 200000; key++) {
+        tree.put(key, key);
+        expected[key] = key;
+    }
+    tree.put(UINT32_MAX, 1, EntryType::DELETION);
+    expected[UINT32_MAX] = 1;
+    assert(tree.get_height() > 2);
+
+    for (uint32_t key = 0; key < 200000; key++) {
+        bool is_found = tree.get(key, &value, &type);
+        assert(is_found == (expected.count(key) > 0));
+        assert(!is_found || (value == expected[key] && type == EntryType::VALUE));
+    }
+    assert(tree.get(UINT32_MAX, &value, &type) && type == EntryType::DELETION);
+
+    std::vector<std::pair<uint32_t, uint32_t>> all(expected.begin(), expected.end());
+    assert(scan_tree(&tree, 0, UINT32_MAX) == all);
+    std::vector<std::pair<uint32_t, uint32_t>> range(expected.lower_bound(1000), expected.upper_bound(120000));
+    assert(scan_tree(&tree, 1000, 120000) == range);
+    assert(scan_tree(&tree, 200000, UINT32_MAX - 1).empty());
+
+    tree.clear();
+    assert(tree.empty() && tree.get_height() == 0 && !tree.get(1000, &value, &type));
+    tree.put(5, 6);
+    assert(tree.get(5, &value, &type) && value == 6);
+
+    std::cout << "test_put_and_get passed!" << std::endl;
+}
+
+void test_versions() {
+    BPlusTree tree;
+    for (uint32_t key = 0; key < 1000; key++) {
+        tree.put(key, key, EntryType::VALUE, key + 1);
+    }
+    // a snapshot at sequence 1000 sees the versions written until then, whatever splits happen afterwards
+    for (uint32_t key = 0; key < 1000; key += 2) {
+        tree.put(key, key + 1, EntryType::VALUE, 1001 + key, 1000);
+    }
+    for (uint32_t key = 1000; key < 3000; key++) {
+        tree.put(key, key, EntryType::VALUE, 3000 + key, 1000);
+    }
+    // without a snapshot the replaced version is dropped
+    tree.put(1, 7, EntryType::DELETION, 10000, 0);
+
+    uint32_t value;
+    EntryType type;
+    for (uint32_t key = 2; key < 1000; key++) {
+        assert(tree.get(key, &value, &type, 1000) && value == key && type == EntryType::VALUE);
+        assert(tree.get(key, &value, &type) && value == (key % 2 == 0 ? key + 1 : key));
+    }
+    assert(tree.get(1, &value, &type) && type == EntryType::DELETION);
+    assert(!tree.get(1, &value, &type, 1000));
+    assert(!tree.get(2000, &value, &type, 1000));
+    assert(scan_tree(&tree, 0, UINT32_MAX, 1000).size() == 1000 - 1);
+    assert(scan_tree(&tree, 0, UINT32_MAX).size() == 3000);
+
+    std::cout << "test_versions passed!" << std::endl;
+}
+
+void test_kv_store_with_b_plus_tree() {
+    KVStore kvstore(1000, 8, 64);
+    kvstore.open("tests/test_db_1");
+    kvstore.set_memtable_type(MemtableType::B_PLUS_TREE);
+    std::mt19937 generator(7);
+    std::map<uint32_t, uint32_t> expected;
+    for (int i = 0; i < 5000; i++) {
+        uint32_t key = generator() % 3000;
+        kvstore.put(key, i);
+        expected[key] = i;
+    }
+    const Snapshot *snapshot = kvstore.snapshot();
+    kvstore.delete_key(expected.begin()->first);
+    kvstore.delete_range(100, 199);
+
+    // the type cannot change while the memtable has entries
+    bool failed = false;
+    try {
+        kvstore.set_memtable_type(MemtableType::AVL_TREE);
+    } catch (const std::runtime_error &) {
+        failed = true;
+    }
+    assert(failed);
+
+    uint32_t value;
+    for (const auto &[key, expected_value] : expected) {
+        bool is_deleted = key == expected.begin()->first || (100 <= key && key <= 199);
+        assert(kvstore.get(key, &value) == !is_deleted);
+        assert(is_deleted || value == expected_value);
+        assert(kvstore.get(key, &value, snapshot) && value == expected_value);
+    }
+    assert(kvstore.scan(0, 3000, snapshot).size() == expected.size());
+    kvstore.release_snapshot(snapshot);
+    kvstore.close();
+
+    std::cout << "test_kv_store_with_b_plus_tree passed!" << std::endl;
+}
+
+int main() {
+    Utils::clear_databases("tests", "test_db_");
+
+    test_put_and_get();
+    test_versions();
+    test_kv_store_with_b_plus_tree();
+
+    Utils::clear_databases("tests", "test_db_");
+
+    std::cout << GREEN << "All tests passed!\n" << RESET << std::endl;
+
+    return 0;
+}
@@ -1,22 +1,29 @@
 #include "bloom_filter.hpp"
 
 #include <cassert>
+#include <cmath>
+#include <cstdint>
 #include <iostream>
 #include <string>
+#include <vector>
 
 #include "test_utils.hpp"
-#include "xxhash.h"
+#include "utils.hpp"
 
 void test_bloom_filter() {
     BloomFilter filter(15, 10);
+    assert(filter.get_num_pages() == 1 && filter.get_bits_per_page() == 150);
+    assert(filter.get_num_hash_functions() == (int)std::round(std::log(2) * 15));
 
     uint32_t key = 1;
     filter.insert(key);
 
-    for (int i = 0; i < 10; i++) {
-        int index = XXH64(&key, sizeof(uint32_t), i) % (15 * 10);
-        assert(filter.bitmap[index] == 1);
+    // the bits of the key are packed in its page, 8 per byte
+    int num_bits_set = 0;
+    for (int i = 0; i < Utils::PAGE_SIZE; i++) {
+        num_bits_set += __builtin_popcount((uint8_t)filter.get_page(0)[i]);
     }
+    assert(num_bits_set > 0 && num_bits_set <= filter.get_num_hash_functions());
 
     // Ensure that the key is present in the filter
     assert(filter.get(key));
@@ -24,8 +31,97 @@ void test_bloom_filter() {
     std::cout << "test_bloom_filter passed!" << std::endl;
 }
 
+void test_filter_pages() {
+    // far more bits than a page holds
+    const int num_entries = 100000;
+    BloomFilter filter(10, num_entries);
+    assert(filter.get_num_pages() == (10 * num_entries + BloomFilter::MAX_BITS_PER_PAGE - 1) /
+                                         BloomFilter::MAX_BITS_PER_PAGE);
+    assert((int64_t)filter.get_bits_per_page() * filter.get_num_pages() >= 10 * num_entries);
+    for (uint32_t key = 0; key < num_entries; key++) {
+        filter.insert(key * 2);
+    }
+
+    std::vector<int> keys_per_page(filter.get_num_pages());
+    for (uint32_t key = 0; key < num_entries; key++) {
+        assert(filter.get(key * 2));
+        // a lookup only needs the page of the key
+        int page = BloomFilter::get_page_index(key * 2, filter.get_num_pages());
+        assert(BloomFilter::page_may_contain(filter.get_page(page), key * 2, filter.get_bits_per_page(),
+                                             filter.get_num_hash_functions()));
+        keys_per_page[page]++;
+    }
+    // the keys are spread over the pages
+    for (int num_keys : keys_per_page) {
+        assert(num_keys > num_entries / filter.get_num_pages() / 2);
+    }
+
+    // the false positive rate is the one of 10 bits per entry (about 0.8%), not of a single page
+    int num_false_positives = 0;
+    for (uint32_t key = 0; key < num_entries; key++) {
+        num_false_positives += filter.get(key * 2 + 1);
+    }
+    assert(num_false_positives < num_entries * 0.02);
+
+    std::cout << "test_filter_pages passed!" << std::endl;
+}
+
+void test_no_bits() {
+    BloomFilter filter(0, 10);
+    filter.insert(1);
+    assert(filter.get_num_pages() == 0);
+
+    // without bits the filter cannot rule anything out
+    assert(filter.get(1));
+    assert(filter.get(2));
+
+    std::cout << "test_no_bits passed!" << std::endl;
+}
+
+void test_optimal_bits_per_entry() {
+    // size ratio 2: every level has twice as many entries as the previous one
+    std::vector<double> entries_per_level = {100, 200, 400, 800};
+    double total_entries = 1500;
+    double total_bits = 5 * total_entries;
+
+    std::vector<double> bits = BloomFilter::get_optimal_bits_per_entry(entries_per_level, total_bits);
+    assert(bits.size() == entries_per_level.size());
+
+    // shallower levels get more bits per entry
+    for (size_t i = 1; i < bits.size(); i++) {
+        assert(bits[i - 1] > bits[i]);
+    }
+
+    // the whole budget is used
+    double used_bits = 0;
+    for (size_t i = 0; i < bits.size(); i++) {
+        used_bits += bits[i] * entries_per_level[i];
+    }
+    assert(std::abs(used_bits - total_bits) < 1);
+
+    // and the expected I/Os of a zero-result lookup are lower than with uniform allocation
+    auto fpr = [](double b) { return std::exp(-b * std::log(2) * std::log(2)); };
+    double monkey_cost = 0;
+    double uniform_cost = 0;
+    for (size_t i = 0; i < bits.size(); i++) {
+        monkey_cost += fpr(bits[i]);
+        uniform_cost += fpr(5);
+    }
+    assert(monkey_cost < uniform_cost);
+
+    // with a tiny budget the deepest level gets no filter at all
+    std::vector<double> small = BloomFilter::get_optimal_bits_per_entry(entries_per_level, 100);
+    assert(small.back() == 0);
+    assert(small.front() > 0);
+
+    std::cout << "test_optimal_bits_per_entry passed!" << std::endl;
+}
+
 int main() {
     test_bloom_filter();
+    test_filter_pages();
+    test_no_bits();
+    test_optimal_bits_per_entry();
 
     std::cout << GREEN << "All tests passed!\n" << RESET << std::endl;
 
@@ -1,10 +1,18 @@
 #include "btree.hpp"
 
+#include <algorithm>
 #include <cassert>
+#include <cmath>
+#include <cstdint>
 #include <fstream>
 #include <iostream>
+#include <memory>
+#include <random>
+#include <set>
+#include <stdexcept>
 
 #include "kv_store.hpp"
+#include "sst_builder.hpp"
 #include "test_utils.hpp"
 #include "utils.hpp"
 
@@ -79,11 +87,165 @@ void test_scan() {
     std::cout << "test_scan passed!" << std::endl;
 }
 
+void test_hash_index() {
+    std::mt19937 rng(42);
+    for (int num_keys : {0, 1, 2, 3, 100, BTreeNode::HASHED_MAX_KEYS}) {
+        std::set<uint32_t> key_set;
+        while ((int)key_set.size() < num_keys) {
+            key_set.insert(rng());
+        }
+        std::unique_ptr<BTreeNode> leaf = std::make_unique<BTreeNode>();
+        std::copy(key_set.begin(), key_set.end(), leaf->keys);
+        for (int i = 0; i < num_keys; i++) {
+            leaf->values[i] = i;
+        }
+        leaf->num_keys = num_keys;
+        leaf->is_leaf = true;
+        leaf->build_hash_index();
+
+        for (int i = 0; i < num_keys; i++) {
+            assert(leaf->find_with_hash_index(leaf->keys[i]) == i);
+            // the hash index does not overwrite the values
+            assert(leaf->values[i] == (uint32_t)i);
+        }
+        for (int i = 0; i < 1000; i++) {
+            uint32_t key = rng();
+            int expected = key_set.count(key) ? leaf->lower_bound(key) : -1;
+            assert(leaf->find_with_hash_index(key) == expected);
+        }
+    }
+
+    // SSTs with hashed leaves, flushed and compacted
+    KVStore kvstore(1024, 2, 8);
+    kvstore.set_leaf_format(LeafFormat::HASHED);
+    kvstore.open("tests/test_db_7");
+    for (uint32_t i = 0; i < 5000; i++) {
+        kvstore.put(i * 2, i);
+    }
+    for (uint32_t i = 0; i < 5000; i++) {
+        assert(kvstore.get(i * 2) == i);
+        assert(kvstore.get(i * 2 + 1) == Utils::INVALID_VALUE);
+    }
+    std::vector<std::pair<uint32_t, uint32_t>> result = kvstore.scan(1001, 2999);
+    assert(result.size() == 999);
+    assert(result.front() == std::make_pair(1002u, 501u));
+    assert(result.back() == std::make_pair(2998u, 1499u));
+    kvstore.close();
+
+    std::cout << "test_hash_index passed!" << std::endl;
+}
+
+// number of leaves of an SST, from its root
+int read_num_leaf_nodes(std::filesystem::path sst_path) {
+    std::ifstream file(sst_path, std::ios::binary);
+    std::unique_ptr<BTreeNode> root = std::make_unique<BTreeNode>();
+    file.seekg(Utils::PAGE_SIZE);
+    file.read((char*)root.get(), sizeof(BTreeNode));
+    return root->num_of_leaf_nodes;
+}
+
+void test_merge_ssts_without_overlap() {
+    fs::path db_path = fs::current_path() / "tests/test_db_8";
+    fs::create_directories(db_path);
+    // the filters of levels 0 and 1 have different sizes
+    SSTOptions options;
+    options.level_bits_per_entry = {10, 3};
+    const uint32_t num_keys = BTreeNode::MAX_KEYS * 2 + 10;
+    for (uint32_t sst = 0; sst < 2; sst++) {
+        SSTBuilder builder(db_path / ("sst_" + std::to_string(sst) + ".sst"), options, 0, num_keys);
+        for (uint32_t key = sst * num_keys; key < (sst + 1) * num_keys; key++) {
+            builder.add(key * 2, key);
+        }
+        builder.finish();
+    }
+    SSTBuilder builder(db_path / "unused.sst", options, 1, num_keys * 2);
+    assert(builder.can_append_leaves(db_path / "sst_0.sst") && builder.can_append_leaves(db_path / "sst_1.sst"));
+
+    // the leaves are copied as they are, with the partly filled last leaf of the first SST, where rewriting the
+    // entries would fill every leaf but the last
+    BTreeNode::merge_ssts(db_path / "sst_0.sst", db_path / "sst_1.sst", db_path / "output.sst", false, options, 1);
+    int num_leaf_nodes = read_num_leaf_nodes(db_path / "output.sst");
+    assert(num_leaf_nodes == read_num_leaf_nodes(db_path / "sst_0.sst") * 2);
+    assert(num_leaf_nodes > (int)std::ceil(num_keys * 2.0 / BTreeNode::MAX_KEYS));
+
+    // and the filter of the output holds the keys of both
+    BufferPool buffer_pool(4, 64);
+    for (uint32_t key = 0; key < num_keys * 2; key++) {
+        uint32_t value;
+        EntryType type;
+        assert(BTreeNode::search_value_by_key(key * 2, db_path / "output.sst", &buffer_pool, &value, &type));
+        assert(value == key);
+        assert(!BTreeNode::search_value_by_key(key * 2 + 1, db_path / "output.sst", &buffer_pool, &value, &type));
+    }
+
+    std::cout << "test_merge_ssts_without_overlap passed!" << std::endl;
+}
+
+void test_refused_pages_are_freed() {
+    // a buffer pool far smaller than the SSTs, whose admission filter refuses most of the pages read once
+    KVStore kvstore(512, 2, 4);
+    kvstore.set_buffer_pool_admission_filter(true);
+    kvstore.open("tests/test_db_9");
+    const uint32_t num_keys = 512 * 15;
+    for (uint32_t i = 0; i < num_keys; i++) {
+        kvstore.put(i, i + 1);
+    }
+
+    BufferPool& buffer_pool = kvstore.get_buffer_pool();
+    int64_t rejected_before = buffer_pool.get_num_rejected();
+    int64_t freed_before = buffer_pool.get_num_freed();
+    std::mt19937 rng(7);
+    for (int i = 0; i < 2000; i++) {
+        uint32_t key = rng() % num_keys;
+        assert(kvstore.get(key) == key + 1);
+    }
+    assert(kvstore.scan(100, 4000).size() == 3901);
+    int64_t num_rejected = buffer_pool.get_num_rejected() - rejected_before;
+    assert(num_rejected > 0);
+    // the reads free every page the buffer pool refused (no other reader inserted them meanwhile)
+    assert(buffer_pool.get_num_freed() - freed_before == num_rejected);
+
+    std::cout << "test_refused_pages_are_freed passed!" << std::endl;
+}
+
+void test_truncated_sst() {
+    KVStore kvstore(100, 2, 4);
+    kvstore.open("tests/test_db_10");
+    for (uint32_t i = 0; i < 100; i++) {
+        kvstore.put(i, i + 1);
+    }
+    kvstore.close();
+
+    // the filter and the root are there, the leaf is not
+    fs::path sst_path = "tests/test_db_10/sst_0.dat";
+    fs::path truncated_path = "tests/test_db_10/truncated.dat";
+    fs::copy_file(sst_path, truncated_path);
+    fs::resize_file(truncated_path, 2 * Utils::PAGE_SIZE);
+    BufferPool buffer_pool(2, 4);
+    uint32_t value;
+    EntryType type;
+    assert(BTreeNode::search_value_by_key(5, sst_path, &buffer_pool, &value, &type) && value == 6);
+    bool failed = false;
+    try {
+        BTreeNode::search_value_by_key(5, truncated_path, &buffer_pool, &value, &type);
+    } catch (const std::runtime_error&) {
+        failed = true;
+    }
+    assert(failed);
+    assert(buffer_pool.get(Page::generate_page_id(truncated_path, 2)) == nullptr);
+
+    std::cout << "test_truncated_sst passed!" << std::endl;
+}
+
 int main() {
     Utils::clear_databases("tests", "test_db_");
 
     test_get_and_put();
     test_scan();
+    test_hash_index();
+    test_merge_ssts_without_overlap();
+    test_refused_pages_are_freed();
+    test_truncated_sst();
 
     Utils::clear_databases("tests", "test_db_");
 
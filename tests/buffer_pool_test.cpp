@@ -4,8 +4,11 @@
 #include <cmath>
 #include <cstdint>
 #include <iostream>
+#include <string>
 
+#include "page.hpp"
 #include "test_utils.hpp"
+#include "utils.hpp"
 
 void test_get() {
     BufferPool buffer_pool(2, 5);  // min_size, max_size
@@ -38,8 +41,10 @@ void test_insert() {
 
     std::vector<uint32_t> data1 = {1, 100};
     std::vector<uint32_t> data2 = {2, 200};
-    buffer_pool.insert("page1", (char*)&data1);
-    buffer_pool.insert("page2", (char*)&data2);
+    assert(buffer_pool.insert("page1", (char*)&data1));
+    assert(buffer_pool.insert("page2", (char*)&data2));
+    // the page is already there, the caller keeps the data
+    assert(!buffer_pool.insert("page1", (char*)&data2));
 
     auto pages = buffer_pool.get_all_pages();
 
@@ -62,11 +67,107 @@ void test_get_all_pages() {
     std::cout << "test_get_all_pages passed!\n";
 }
 
+// the pages that stay cached out of hot pages read again and again, after a scan of pages read once
+int count_hot_pages_after_scan(bool use_admission_filter) {
+    BufferPool buffer_pool(4, 16);
+    buffer_pool.set_admission_filter(use_admission_filter);
+    static char data[Utils::PAGE_SIZE];
+    const int num_hot_pages = 6;
+    int num_refused = 0;
+    for (int round = 0; round < 5; round++) {
+        for (int i = 0; i < num_hot_pages; i++) {
+            std::string page_id = "hot" + std::to_string(i);
+            if (buffer_pool.get(page_id) == nullptr) {
+                num_refused += !buffer_pool.insert(page_id, data);
+            }
+        }
+    }
+    for (int i = 0; i < 100; i++) {
+        std::string page_id = "scan" + std::to_string(i);
+        if (buffer_pool.get(page_id) == nullptr) {
+            num_refused += !buffer_pool.insert(page_id, data);
+        }
+    }
+    assert(buffer_pool.get_num_admitted() + buffer_pool.get_num_rejected() == num_hot_pages + 100);
+    assert(use_admission_filter || buffer_pool.get_num_rejected() == 0);
+    assert(num_refused == buffer_pool.get_num_rejected());
+
+    int num_cached = 0;
+    for (int i = 0; i < num_hot_pages; i++) {
+        num_cached += buffer_pool.get("hot" + std::to_string(i)) != nullptr;
+    }
+    return num_cached;
+}
+
+void test_admission_filter() {
+    assert(count_hot_pages_after_scan(false) == 0);
+    assert(count_hot_pages_after_scan(true) == 6);
+    std::cout << "test_admission_filter passed!\n";
+}
+
+void test_index_pages() {
+    BufferPool buffer_pool(4, 16);
+    buffer_pool.set_index_capacity(2);
+    static char data[Utils::PAGE_SIZE];
+    buffer_pool.insert("filter", data, PageType::INDEX);
+    buffer_pool.insert("root", data, PageType::INDEX);
+    // the data pages only evict each other
+    for (int i = 0; i < 100; i++) {
+        buffer_pool.insert("leaf" + std::to_string(i), data);
+    }
+    assert(buffer_pool.get("filter") == data && buffer_pool.get("root") == data);
+    assert(buffer_pool.get_num_priority_pages() == 2);
+    // and the index pages each other, the least recently used first
+    buffer_pool.get("filter");
+    buffer_pool.insert("node", data, PageType::INDEX);
+    assert(buffer_pool.get("root") == nullptr && buffer_pool.get("filter") == data && buffer_pool.get("node") == data);
+
+    buffer_pool.set_index_capacity(1);
+    assert(buffer_pool.get_num_priority_pages() == 1 && buffer_pool.get("node") == data);
+    buffer_pool.remove("node");
+    assert(buffer_pool.get("node") == nullptr && buffer_pool.get_num_priority_pages() == 0);
+    std::cout << "test_index_pages passed!\n";
+}
+
+void test_pinned_sst() {
+    BufferPool buffer_pool(4, 16);
+    buffer_pool.set_index_capacity(1);
+    static char data[Utils::PAGE_SIZE];
+    buffer_pool.pin_sst("a.sst");
+    for (int offset = 0; offset < 10; offset++) {
+        PageType type = offset < 2 ? PageType::INDEX : PageType::DATA;
+        buffer_pool.insert(Page::generate_page_id("a.sst", offset), data, type);
+    }
+    for (int i = 0; i < 100; i++) {
+        buffer_pool.insert(Page::generate_page_id("b.sst", i), data, i % 2 == 0 ? PageType::INDEX : PageType::DATA);
+    }
+    // neither capacity evicts the pages of the pinned SST
+    for (int offset = 0; offset < 10; offset++) {
+        assert(buffer_pool.get(Page::generate_page_id("a.sst", offset)) == data);
+    }
+    assert(buffer_pool.get_num_priority_pages() == 11);
+
+    buffer_pool.unpin_sst("a.sst");
+    assert(buffer_pool.get(Page::generate_page_id("a.sst", 0)) == nullptr);
+    assert(buffer_pool.get_num_priority_pages() == 1);
+    buffer_pool.pin_sst("a.sst");
+    buffer_pool.insert(Page::generate_page_id("a.sst", 0), data);
+    buffer_pool.remove_sst("a.sst");
+    assert(buffer_pool.get(Page::generate_page_id("a.sst", 0)) == nullptr);
+    // the pin goes with the SST
+    buffer_pool.insert(Page::generate_page_id("a.sst", 0), data);
+    assert(buffer_pool.get_num_priority_pages() == 1);
+    std::cout << "test_pinned_sst passed!\n";
+}
+
 int main() {
     test_get();
     test_resize();
     test_insert();
     test_get_all_pages();
+    test_admission_filter();
+    test_index_pages();
+    test_pinned_sst();
 
     std::cout << GREEN << "All tests passed!\n" << RESET << std::endl;
 
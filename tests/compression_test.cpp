@@ -0,0 +1,178 @@
+#include "compression.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "btree.hpp"
+#include "compressed_cache.hpp"
+#include "kv_store.hpp"
+#include "test_utils.hpp"
+#include "utils.hpp"
+
+// compress then decompress, returns the compressed size
+int check_round_trip(const std::vector<char> &data) {
+    std::vector<char> compressed(Compression::get_max_compressed_size(data.size()));
+    int compressed_size = Compression::compress(data.data(), data.size(), compressed.data());
+    assert(compressed_size <= (int)compressed.size());
+
+    std::vector<char> decompressed(data.size());
+    assert(Compression::decompress(compressed.data(), compressed_size, decompressed.data(), decompressed.size()));
+    assert(decompressed == data);
+    // a truncated block is detected
+    if (compressed_size > 1) {
+        assert(!Compression::decompress(compressed.data(), compressed_size - 1, decompressed.data(),
+                                        decompressed.size()));
+    }
+    return compressed_size;
+}
+
+void test_round_trip() {
+    std::mt19937 rng(42);
+    // inputs shorter than a match
+    for (int size = 0; size < 20; size++) {
+        std::vector<char> data(size, 'a');
+        check_round_trip(data);
+    }
+
+    // random bytes do not compress, but do not grow much either
+    std::vector<char> random(16384);
+    for (char &byte : random) {
+        byte = rng();
+    }
+    assert(check_round_trip(random) <= Compression::get_max_compressed_size(random.size()));
+
+    // a single byte repeated, the matches overlap the bytes they produce
+    std::vector<char> zeros(16384, 0);
+    assert(check_round_trip(zeros) < 100);
+
+    // a leaf page of keys with few distinct values
+    std::vector<uint32_t> words;
+    for (uint32_t i = 0; i < 1024; i++) {
+        words.push_back(i * 3);
+    }
+    for (uint32_t i = 0; i < 1024; i++) {
+        words.push_back(i % 16);
+    }
+    std::vector<char> page(words.size() * sizeof(uint32_t));
+    std::memcpy(page.data(), words.data(), page.size());
+    assert(check_round_trip(page) < (int)page.size() * 3 / 4);
+
+    std::cout << "test_round_trip passed!" << std::endl;
+}
+
+void test_compressed_cache() {
+    CompressedCache cache(100);
+    cache.insert("a", std::string(40, 'a'));
+    cache.insert("b", std::string(40, 'b'));
+    assert(cache.get("a") != nullptr);
+    // "b" is the least recently used
+    cache.insert("c", std::string(40, 'c'));
+    assert(cache.get("b") == nullptr);
+    assert(*cache.get("a") == std::string(40, 'a'));
+    assert(cache.get_size() == 80);
+    // too large to be cached
+    cache.insert("d", std::string(101, 'd'));
+    assert(cache.get("d") == nullptr);
+
+    cache.insert(CompressedCache::generate_block_id("db/sst_1.dat", 0), "x");
+    cache.insert(CompressedCache::generate_block_id("db/sst_10.dat", 0), "y");
+    cache.remove_sst("db/sst_1.dat");
+    assert(cache.get(CompressedCache::generate_block_id("db/sst_1.dat", 0)) == nullptr);
+    assert(cache.get(CompressedCache::generate_block_id("db/sst_10.dat", 0)) != nullptr);
+
+    cache.set_capacity(0);
+    assert(cache.get_size() == 0);
+
+    std::cout << "test_compressed_cache passed!" << std::endl;
+}
+
+// writes the same entries to a db, returns the total size of its SSTs after reopening and checking it
+uintmax_t fill_db(const std::string &db_name, CompressionType compression, LeafFormat leaf_format,
+                  std::vector<std::pair<uint32_t, uint32_t>> *scan_result, int64_t *compressed_cache_hits) {
+    KVStore kvstore(1024, 2, 8);
+    kvstore.set_compression(compression);
+    kvstore.set_leaf_format(leaf_format);
+    kvstore.set_range_filter(true);
+    kvstore.open(db_name);
+    const uint32_t num_keys = 1024 * 7;
+    for (uint32_t i = 0; i < num_keys; i++) {
+        kvstore.put(i * 3, i % 16);
+    }
+    // deletes and updates are merged by compactions
+    for (uint32_t i = 0; i < num_keys; i += 10) {
+        kvstore.delete_key(i * 3);
+        kvstore.put(i * 3 + 1, i % 16);
+    }
+    kvstore.close();
+
+    // a buffer pool of a few pages, the compressed cache holds the rest
+    KVStore reopened(1024, 1, 2);
+    reopened.set_compressed_cache_capacity(1 << 20);
+    reopened.open(db_name);
+    std::mt19937 rng(7);
+    for (int i = 0; i < 2000; i++) {
+        uint32_t n = rng() % num_keys;
+        if (n % 10 == 0) {
+            assert(reopened.get(n * 3) == Utils::INVALID_VALUE);
+            assert(reopened.get(n * 3 + 1) == n % 16);
+        } else {
+            assert(reopened.get(n * 3) == n % 16);
+            assert(reopened.get(n * 3 + 2) == Utils::INVALID_VALUE);
+        }
+    }
+    *scan_result = reopened.scan(1000, 20000);
+    std::sort(scan_result->begin(), scan_result->end());
+    *compressed_cache_hits = reopened.get_buffer_pool().get_compressed_cache().get_num_hits();
+    reopened.close();
+
+    uintmax_t size = 0;
+    for (const auto &entry : std::filesystem::directory_iterator(db_name)) {
+        if (entry.path().filename().string().rfind("sst_", 0) == 0) {
+            size += std::filesystem::file_size(entry.path());
+        }
+    }
+    return size;
+}
+
+void test_kv_store_with_compression() {
+    std::vector<std::pair<uint32_t, uint32_t>> compressed_scan, packed_scan, plain_scan;
+    int64_t compressed_hits, packed_hits, plain_hits;
+    uintmax_t compressed_size =
+        fill_db("tests/test_db_1", CompressionType::LZ4, LeafFormat::PLAIN, &compressed_scan, &compressed_hits);
+    uintmax_t packed_size =
+        fill_db("tests/test_db_2", CompressionType::LZ4, LeafFormat::PACKED, &packed_scan, &packed_hits);
+    uintmax_t plain_size =
+        fill_db("tests/test_db_3", CompressionType::NONE, LeafFormat::PLAIN, &plain_scan, &plain_hits);
+    assert(compressed_scan == plain_scan);
+    assert(packed_scan == plain_scan);
+    assert(std::find(plain_scan.begin(), plain_scan.end(), std::make_pair(1021u, 340u % 16)) != plain_scan.end());
+
+    assert(compressed_size < plain_size);
+    assert(packed_size < plain_size);
+    // pages evicted from the buffer pool are decompressed from memory instead of being read from the file
+    assert(compressed_hits > 0);
+    assert(plain_hits == 0);
+
+    std::cout << "test_kv_store_with_compression passed!" << std::endl;
+}
+
+int main() {
+    Utils::clear_databases("tests", "test_db_");
+
+    test_round_trip();
+    test_compressed_cache();
+    test_kv_store_with_compression();
+
+    Utils::clear_databases("tests", "test_db_");
+
+    std::cout << GREEN << "All tests passed!\n" << RESET << std::endl;
+
+    return 0;
+}
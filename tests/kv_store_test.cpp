@@ -1,8 +1,15 @@
 #include "kv_store.hpp"
 
+#include <algorithm>
 #include <cassert>
 #include <cstdint>
+#include <fstream>
 #include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
 
 #include "test_utils.hpp"
 #include "utils.hpp"
@@ -182,6 +189,406 @@ void test_close() {
     std::cout << "test_close passed!" << std::endl;
 }
 
+void test_reopen_before_destroying_closed_store() {
+    std::unique_ptr<KVStore> closed = std::make_unique<KVStore>(10, 2, 4);
+    closed->open("tests/test_db_20");
+    for (uint32_t i = 0; i < 10; i++) {
+        closed->put(i, i + 100);
+    }
+    closed->close();
+
+    // the closed store dropped its links, and it does not remove the ones of the new store when it is destroyed
+    KVStore reopened(10, 2, 4);
+    reopened.open("tests/test_db_20");
+    closed.reset();
+    for (uint32_t i = 0; i < 10; i++) {
+        assert(reopened.get(i) == i + 100);
+    }
+
+    std::cout << "test_reopen_before_destroying_closed_store passed!" << std::endl;
+}
+
+void test_filter_memory_budget() {
+    KVStore kvstore(4, 2, 4);
+    kvstore.set_filter_memory_budget(4 * 8 * 5);
+    kvstore.open("tests/test_db_9");
+
+    for (int i = 1; i <= 40; i++) {
+        kvstore.put(i * 2, i);
+    }
+    for (int i = 1; i <= 40; i++) {
+        assert(kvstore.get(i * 2) == (uint32_t)i);
+        assert(kvstore.get(i * 2 + 1) == Utils::INVALID_VALUE);
+    }
+
+    // with SSTs of thousands of entries the filters take several pages, and they get the bits of the budget (it
+    // is planned for full levels, so some of it is left for the entries to come)
+    const int num_keys = 20000;
+    KVStore large(4096, 2, 8);
+    large.set_filter_memory_budget(10 * num_keys);
+    large.open("tests/test_db_19");
+    for (int i = 0; i < num_keys; i++) {
+        large.put(i * 2, i);
+    }
+    large.close();
+    int64_t num_filter_bits = 0;
+    int max_filter_pages = 0;
+    for (const auto &entry : fs::directory_iterator("tests/test_db_19")) {
+        if (entry.path().extension() != ".dat") {
+            continue;
+        }
+        std::ifstream file(entry.path(), std::ios::binary);
+        std::unique_ptr<BTreeNode> root = std::make_unique<BTreeNode>();
+        file.seekg(Utils::PAGE_SIZE);
+        file.read((char *)root.get(), sizeof(BTreeNode));
+        num_filter_bits += (int64_t)root->num_filter_pages * root->filter_bits_per_page;
+        max_filter_pages = std::max(max_filter_pages, root->num_filter_pages);
+    }
+    assert(max_filter_pages > 1);
+    assert(num_filter_bits > 5 * num_keys && num_filter_bits <= 10 * num_keys);
+    for (int i = 0; i < num_keys; i += 7) {
+        assert(large.get(i * 2) == (uint32_t)i);
+        assert(large.get(i * 2 + 1) == Utils::INVALID_VALUE);
+    }
+    large.close();
+
+    std::cout << "test_filter_memory_budget passed!" << std::endl;
+}
+
+void test_tombstones_in_last_level() {
+    KVStore kvstore(2, 2, 4);
+    kvstore.open("tests/test_db_10");
+
+    kvstore.delete_key(1);
+    kvstore.put(2, 200);
+    kvstore.put(4, 400);
+
+    // key 1 is written again after its deletion, and key 5 is deleted without ever existing
+    kvstore.delete_key(5);
+    kvstore.put(1, 111);
+    kvstore.put(3, 300);
+
+    // both SSTs were merged into the last level, where tombstones are dropped
+    std::vector<std::pair<uint32_t, uint32_t>> expected = {{1, 111}, {2, 200}, {3, 300}, {4, 400}};
+    assert(kvstore.scan(0, 10) == expected);
+    assert(kvstore.get(0) == Utils::INVALID_VALUE);
+    assert(kvstore.get(1) == 111);
+    assert(kvstore.get(5) == Utils::INVALID_VALUE);
+
+    std::cout << "test_tombstones_in_last_level passed!" << std::endl;
+}
+
+void test_every_value_can_be_stored() {
+    const uint32_t max_value = Utils::INVALID_VALUE;
+    int db_num = 11;
+    for (LeafFormat leaf_format : {LeafFormat::PLAIN, LeafFormat::PACKED, LeafFormat::HASHED}) {
+        std::string db_name = "tests/test_db_" + std::to_string(db_num++);
+        KVStore kvstore(2, 2, 4);
+        kvstore.set_leaf_format(leaf_format);
+        kvstore.open(db_name);
+        // the values that used to mean "not found" and "deleted"
+        kvstore.put(1, max_value);
+        kvstore.put(2, max_value - 1);
+        kvstore.put(3, 0);
+        kvstore.put(4, max_value);
+        kvstore.delete_key(4);
+        kvstore.delete_key(5);
+        kvstore.put(6, max_value - 1);
+        kvstore.close();
+
+        KVStore reopened(2, 2, 4);
+        reopened.open(db_name);
+        uint32_t value;
+        assert(reopened.get(1, &value) && value == max_value);
+        assert(reopened.get(2, &value) && value == max_value - 1);
+        assert(reopened.get(3, &value) && value == 0);
+        assert(!reopened.get(4, &value));
+        assert(!reopened.get(5, &value));
+        assert(!reopened.get(7, &value));
+        assert(reopened.get(6) == max_value - 1);
+
+        std::vector<std::pair<uint32_t, uint32_t>> expected = {{1, max_value}, {2, max_value - 1}, {3, 0},
+                                                               {6, max_value - 1}};
+        assert(reopened.scan(0, 10) == expected);
+        reopened.close();
+    }
+
+    std::cout << "test_every_value_can_be_stored passed!" << std::endl;
+}
+
+void test_snapshots() {
+    KVStore kvstore(64, 2, 8);
+    kvstore.open("tests/test_db_14");
+    const uint32_t num_keys = 300;
+    for (uint32_t key = 0; key < num_keys; key++) {
+        kvstore.put(key, key);
+    }
+    // taken while the memtable holds some of the keys
+    const Snapshot *first = kvstore.snapshot();
+    for (uint32_t key = 0; key < num_keys; key++) {
+        if (key % 3 == 0) {
+            kvstore.delete_key(key);
+        } else {
+            kvstore.put(key, key + 1000);
+        }
+    }
+    // overwritten in the memtable, then flushed and compacted with the versions the snapshots see
+    const Snapshot *second = kvstore.snapshot();
+    kvstore.put(1, 2000);
+    for (uint32_t key = num_keys; key < num_keys * 4; key++) {
+        kvstore.put(key, key);
+    }
+
+    uint32_t value;
+    for (uint32_t key = 0; key < num_keys; key++) {
+        assert(kvstore.get(key, &value, first) && value == key);
+        if (key % 3 == 0) {
+            assert(!kvstore.get(key, &value, second));
+        } else {
+            assert(kvstore.get(key, &value, second) && value == key + 1000);
+        }
+    }
+    assert(kvstore.get(1) == 2000);
+    assert(!kvstore.get(num_keys, &value, first));
+    assert(kvstore.get(num_keys, &value) && value == num_keys);
+
+    std::vector<std::pair<uint32_t, uint32_t>> first_scan = kvstore.scan(0, num_keys * 4, first);
+    assert(first_scan.size() == num_keys);
+    for (uint32_t key = 0; key < num_keys; key++) {
+        assert(first_scan[key] == std::make_pair(key, key));
+    }
+    assert(kvstore.scan(0, num_keys * 4, second).size() == num_keys - num_keys / 3);
+
+    // the links that kept the snapshots' SSTs are removed with them, only those of the live SSTs are left
+    kvstore.release_snapshot(first);
+    kvstore.release_snapshot(second);
+    int num_ssts = 0;
+    int num_links = 0;
+    for (const auto &entry : fs::directory_iterator("tests/test_db_14")) {
+        std::string file_name = entry.path().filename().string();
+        num_ssts += file_name.rfind("sst_", 0) == 0 ? 1 : 0;
+        num_links += file_name.rfind("link_", 0) == 0 ? 1 : 0;
+    }
+    assert(num_links == num_ssts);
+    assert(kvstore.get(2) == 1002);
+    kvstore.close();
+
+    std::cout << "test_snapshots passed!" << std::endl;
+}
+
+// keys 0, step, 2 * step, ... with value key + 1, unsorted_at swaps two of them
+class RangeIterator : public BulkLoadIterator {
+   public:
+    RangeIterator(int64_t num_entries, uint32_t step, int64_t unsorted_at = -1)
+        : num_entries(num_entries), step(step), unsorted_at(unsorted_at) {}
+    bool valid() const override { return index < num_entries; }
+    uint32_t key() const override {
+        if (unsorted_at >= 0 && (index == unsorted_at || index == unsorted_at + 1)) {
+            return (2 * unsorted_at + 1 - index) * step;
+        }
+        return index * step;
+    }
+    uint32_t value() const override { return key() + 1; }
+    void next() override { index++; }
+    int64_t get_num_entries() const override { return num_entries; }
+
+   private:
+    int64_t num_entries;
+    uint32_t step;
+    int64_t unsorted_at;
+    int64_t index = 0;
+};
+
+void test_bulk_load() {
+    const int64_t num_entries = 20000;
+    KVStore kvstore(64, 2, 8);
+    kvstore.open("tests/test_db_15");
+
+    // nothing is installed if the keys are not sorted
+    RangeIterator unsorted(num_entries, 3, num_entries / 2);
+    bool failed = false;
+    try {
+        kvstore.bulk_load(&unsorted);
+    } catch (const std::runtime_error &) {
+        failed = true;
+    }
+    assert(failed);
+    assert(kvstore.get(0) == Utils::INVALID_VALUE);
+    for (const auto &entry : fs::directory_iterator("tests/test_db_15")) {
+        assert(entry.path().extension() != ".dat" && entry.path().extension() != ".tmp");
+    }
+
+    RangeIterator sorted(num_entries, 3);
+    kvstore.bulk_load(&sorted);
+    // one SST, in the level whose SSTs hold as many entries
+    int num_ssts = 0;
+    for (const auto &entry : fs::directory_iterator("tests/test_db_15")) {
+        num_ssts += entry.path().extension() == ".dat";
+    }
+    assert(num_ssts == 1);
+    assert(kvstore.get(0) == 1);
+    assert(kvstore.get(3 * 1000) == 3 * 1000 + 1);
+    assert(kvstore.get(3 * 1000 + 1) == Utils::INVALID_VALUE);
+    assert(kvstore.scan(0, 3 * 99).size() == 100);
+
+    // loading twice is refused, then writes are compacted with the loaded SST as usual
+    failed = false;
+    try {
+        kvstore.bulk_load(&sorted);
+    } catch (const std::runtime_error &) {
+        failed = true;
+    }
+    assert(failed);
+    for (uint32_t key = 0; key < num_entries * 3; key += 2) {
+        kvstore.put(key, key);
+    }
+    kvstore.close();
+
+    KVStore reopened(64, 2, 8);
+    reopened.open("tests/test_db_15");
+    for (uint32_t key = 0; key < num_entries * 3; key++) {
+        uint32_t expected = key % 2 == 0 ? key : key % 3 == 0 ? key + 1 : Utils::INVALID_VALUE;
+        assert(reopened.get(key) == expected);
+    }
+    reopened.close();
+
+    std::cout << "test_bulk_load passed!" << std::endl;
+}
+
+void test_sequential_writes() {
+    const uint32_t num_keys = 20000;
+    KVStore kvstore(1000, 8, 64);
+    kvstore.open("tests/test_db_16");
+    const Snapshot *snapshot = nullptr;
+    for (uint32_t key = 0; key < num_keys; key++) {
+        if (key % 7 == 0) {
+            kvstore.delete_key(key);
+        } else {
+            kvstore.put(key, key + 1);
+        }
+        if (key == num_keys - 500) {
+            snapshot = kvstore.snapshot();
+        }
+    }
+    // the memtable is read while its keys are appended, then after an older key moves them to the tree
+    assert(kvstore.get(num_keys - 2) == num_keys - 1);
+    assert(kvstore.get(num_keys - 8) == Utils::INVALID_VALUE);
+    uint32_t value;
+    assert(!kvstore.get(num_keys - 2, &value, snapshot));
+    kvstore.put(num_keys - 3, 0);
+    kvstore.put(num_keys + 1, 0);
+    assert(kvstore.get(num_keys - 3) == 0);
+    assert(kvstore.get(num_keys - 2) == num_keys - 1);
+
+    assert(kvstore.get(num_keys - 500, &value, snapshot) && value == num_keys - 499);
+    std::vector<std::pair<uint32_t, uint32_t>> result = kvstore.scan(0, num_keys * 2);
+    assert(result.size() == num_keys - (num_keys + 6) / 7 + 1);
+    kvstore.release_snapshot(snapshot);
+    kvstore.close();
+
+    // the SSTs whose leaves were copied by compactions hold all of their keys
+    KVStore reopened(1000, 8, 64);
+    reopened.open("tests/test_db_16");
+    for (uint32_t key = 0; key < num_keys; key++) {
+        uint32_t expected = key == num_keys - 3 ? 0 : key % 7 == 0 ? Utils::INVALID_VALUE : key + 1;
+        assert(reopened.get(key) == expected);
+    }
+    assert(reopened.scan(0, num_keys * 2) == result);
+    reopened.close();
+
+    std::cout << "test_sequential_writes passed!" << std::endl;
+}
+
+void test_concurrent_reads_and_writes() {
+    const uint32_t num_keys = 20000;
+    KVStore kvstore(1000, 64, 256);
+    kvstore.open("tests/test_db_17");
+    for (uint32_t key = 0; key < num_keys; key++) {
+        kvstore.put(key, key);
+    }
+
+    // writers rewrite the keys with the values they have and add new ones, which flushes and compacts while
+    // readers look the keys up, scan them and read through snapshots
+    std::vector<std::thread> threads;
+    for (int thread = 0; thread < 2; thread++) {
+        threads.emplace_back([&kvstore, thread]() {
+            for (uint32_t key = thread; key < num_keys; key += 2) {
+                kvstore.put(key, key);
+                kvstore.put(num_keys + key, key);
+            }
+        });
+    }
+    for (int thread = 0; thread < 2; thread++) {
+        threads.emplace_back([&kvstore, thread]() {
+            for (uint32_t key = thread; key < num_keys; key += 3) {
+                assert(kvstore.get(key) == key);
+                uint32_t value;
+                assert(!kvstore.get(num_keys + key, &value) || value == key);
+            }
+            for (uint32_t start_key = 0; start_key < num_keys; start_key += 1000) {
+                assert(kvstore.scan(start_key, start_key + 99).size() == 100);
+            }
+        });
+    }
+    threads.emplace_back([&kvstore]() {
+        for (int i = 0; i < 5; i++) {
+            const Snapshot *snapshot = kvstore.snapshot();
+            std::vector<std::pair<uint32_t, uint32_t>> result = kvstore.scan(0, num_keys * 2, snapshot);
+            assert(result.size() >= num_keys);
+            assert(kvstore.scan(0, num_keys * 2, snapshot) == result);
+            kvstore.release_snapshot(snapshot);
+        }
+    });
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+
+    for (uint32_t key = 0; key < num_keys; key++) {
+        assert(kvstore.get(key) == key && kvstore.get(num_keys + key) == key);
+    }
+    kvstore.close();
+
+    std::cout << "test_concurrent_reads_and_writes passed!" << std::endl;
+}
+
+void test_index_cache_and_pinned_level0() {
+    KVStore kvstore(100, 4, 16);
+    kvstore.open("tests/test_db_18");
+    kvstore.set_index_cache_capacity(64);
+    kvstore.set_pin_level0(true);
+    for (uint32_t key = 0; key < 2000; key++) {
+        kvstore.put(key, key);
+    }
+    kvstore.close();
+
+    // scans read every leaf, far more than the buffer pool holds, while the filters and index pages stay cached
+    BufferPool &buffer_pool = kvstore.get_buffer_pool();
+    for (int i = 0; i < 3; i++) {
+        assert(kvstore.scan(0, 1999).size() == 2000);
+    }
+    for (uint32_t key = 0; key < 2000; key += 7) {
+        assert(kvstore.get(key) == key);
+    }
+    int num_priority_pages = buffer_pool.get_num_priority_pages();
+    assert(num_priority_pages > 0);
+    assert(kvstore.scan(0, 1999).size() == 2000);
+    for (uint32_t key = 0; key < 2000; key += 7) {
+        assert(kvstore.get(key) == key);
+    }
+    assert(buffer_pool.get_num_priority_pages() >= num_priority_pages);
+
+    // the pages of level 0 are dropped once it is no longer pinned
+    kvstore.set_pin_level0(false);
+    kvstore.set_index_cache_capacity(0);
+    assert(buffer_pool.get_num_priority_pages() == 0);
+    for (uint32_t key = 0; key < 2000; key += 7) {
+        assert(kvstore.get(key) == key);
+    }
+    kvstore.close();
+
+    std::cout << "test_index_cache_and_pinned_level0 passed!" << std::endl;
+}
+
 int main() {
     Utils::clear_databases("tests", "test_db_");
 
@@ -192,6 +599,15 @@ int main() {
     test_delete();
     test_lsm_tree_compaction();
     test_close();
+    test_reopen_before_destroying_closed_store();
+    test_filter_memory_budget();
+    test_tombstones_in_last_level();
+    test_every_value_can_be_stored();
+    test_snapshots();
+    test_bulk_load();
+    test_sequential_writes();
+    test_concurrent_reads_and_writes();
+    test_index_cache_and_pinned_level0();
 
     Utils::clear_databases("tests", "test_db_");
 
@@ -0,0 +1,149 @@
+#include "learned_index.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <set>
+#include <vector>
+
+#include "btree.hpp"
+#include "kv_store.hpp"
+#include "test_utils.hpp"
+#include "utils.hpp"
+
+const int ENTRIES_PER_LEAF = 100;
+
+LearnedIndex build_index(const std::vector<uint32_t> &keys) {
+    LearnedIndex index(ENTRIES_PER_LEAF);
+    for (uint32_t key : keys) {
+        index.add(key);
+    }
+    index.finish();
+    return index;
+}
+
+// the leaf holding the first key >= key must be in the search window
+void check_window(const LearnedIndex &index, const std::vector<uint32_t> &keys, uint32_t key) {
+    int position = std::lower_bound(keys.begin(), keys.end(), key) - keys.begin();
+    int leaf = std::min(position, (int)keys.size() - 1) / ENTRIES_PER_LEAF;
+    int first_leaf, predicted_leaf, last_leaf;
+    index.get_search_window(key, &first_leaf, &predicted_leaf, &last_leaf);
+    assert(first_leaf <= leaf && leaf <= last_leaf);
+    assert(first_leaf <= predicted_leaf && predicted_leaf <= last_leaf);
+}
+
+void test_error_bound() {
+    std::mt19937 rng(42);
+    std::set<uint32_t> key_set;
+    while (key_set.size() < 20000) {
+        // clusters of keys with different densities
+        uint32_t base = rng() % 100 * 1000000;
+        key_set.insert(base + rng() % (1 + rng() % 1000000));
+    }
+    std::vector<uint32_t> keys(key_set.begin(), key_set.end());
+    LearnedIndex index = build_index(keys);
+    assert(index.get_num_entries() == (int)keys.size());
+
+    for (uint32_t key : keys) {
+        check_window(index, keys, key);
+        // keys that are not in the SST
+        check_window(index, keys, key - 1);
+        check_window(index, keys, key + 1);
+    }
+    check_window(index, keys, 0);
+    check_window(index, keys, Utils::INVALID_VALUE);
+
+    // the model survives the round trip through its on-disk blocks
+    LearnedIndex decoded = LearnedIndex::from_blocks(index.to_blocks());
+    assert(decoded.get_num_segments() == index.get_num_segments());
+    for (uint32_t key : keys) {
+        check_window(decoded, keys, key);
+    }
+
+    std::cout << "test_error_bound passed!" << std::endl;
+}
+
+void test_evenly_spaced_keys() {
+    // keys on a line need a single segment, however many there are
+    std::vector<uint32_t> keys;
+    for (uint32_t i = 0; i < 100000; i++) {
+        keys.push_back(i * 3 + 7);
+    }
+    LearnedIndex index = build_index(keys);
+    assert(index.get_num_segments() == 1);
+    for (uint32_t key : keys) {
+        int first_leaf, predicted_leaf, last_leaf;
+        index.get_search_window(key, &first_leaf, &predicted_leaf, &last_leaf);
+        assert(predicted_leaf == (int)(key - 7) / 3 / ENTRIES_PER_LEAF);
+    }
+
+    std::cout << "test_evenly_spaced_keys passed!" << std::endl;
+}
+
+// page accesses (buffer pool hits and misses) of random lookups, and the result of a scan
+int64_t count_get_page_accesses(const std::string &db_name, bool use_learned_index,
+                                std::vector<std::pair<uint32_t, uint32_t>> *scan_result) {
+    KVStore kvstore(1024, 2, 8);
+    kvstore.set_learned_index(use_learned_index);
+    kvstore.open(db_name);
+    const uint32_t num_keys = 1024 * 7;
+    for (uint32_t i = 0; i < num_keys; i++) {
+        kvstore.put(i * 5, i);
+    }
+    // deletes and updates are merged by compactions
+    for (uint32_t i = 0; i < num_keys; i += 10) {
+        kvstore.delete_key(i * 5);
+        kvstore.put(i * 5 + 1, i);
+    }
+    kvstore.close();
+
+    KVStore reopened(1024, 2, 8);
+    reopened.set_learned_index(use_learned_index);
+    reopened.open(db_name);
+    BufferPool &buffer_pool = reopened.get_buffer_pool();
+    int64_t accesses_before = buffer_pool.get_num_hits() + buffer_pool.get_num_misses();
+    std::mt19937 rng(7);
+    for (int i = 0; i < 2000; i++) {
+        uint32_t n = rng() % num_keys;
+        if (n % 10 == 0) {
+            assert(reopened.get(n * 5) == Utils::INVALID_VALUE);
+            assert(reopened.get(n * 5 + 1) == n);
+        } else {
+            assert(reopened.get(n * 5) == n);
+            assert(reopened.get(n * 5 + 2) == Utils::INVALID_VALUE);
+        }
+    }
+    int64_t accesses = buffer_pool.get_num_hits() + buffer_pool.get_num_misses() - accesses_before;
+
+    *scan_result = reopened.scan(1000, 30000);
+    std::sort(scan_result->begin(), scan_result->end());
+    return accesses;
+}
+
+void test_kv_store_with_learned_index() {
+    std::vector<std::pair<uint32_t, uint32_t>> indexed_scan, btree_scan;
+    int64_t indexed_accesses = count_get_page_accesses("tests/test_db_1", true, &indexed_scan);
+    int64_t btree_accesses = count_get_page_accesses("tests/test_db_2", false, &btree_scan);
+    // the internal nodes are skipped
+    assert(indexed_accesses < btree_accesses);
+    assert(indexed_scan == btree_scan);
+    assert(std::find(indexed_scan.begin(), indexed_scan.end(), std::make_pair(1005u, 201u)) != indexed_scan.end());
+
+    std::cout << "test_kv_store_with_learned_index passed!" << std::endl;
+}
+
+int main() {
+    Utils::clear_databases("tests", "test_db_");
+
+    test_error_bound();
+    test_evenly_spaced_keys();
+    test_kv_store_with_learned_index();
+
+    Utils::clear_databases("tests", "test_db_");
+
+    std::cout << GREEN << "All tests passed!\n" << RESET << std::endl;
+
+    return 0;
+}
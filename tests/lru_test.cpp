@@ -47,6 +47,15 @@ void test_update() {
     assert(lru.rear->key == "2");
     assert(lru.rear->prev->key == "1");
 
+    // the updated key is the front, removing it makes the next one the front
+    lru.insert("3");
+    lru.update("2");
+    assert(lru.front->key == "2" && lru.front->prev == nullptr);
+    lru.remove("2");
+    assert(lru.front->key == "3" && lru.front->prev == nullptr);
+    assert(lru.evict() == "1" && lru.evict() == "3");
+    assert(lru.front == nullptr && lru.rear == nullptr);
+
     std::cout << "test_update passed!" << std::endl;
 }
 
@@ -0,0 +1,160 @@
+#include "manifest.hpp"
+
+#include <cassert>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+
+#include "kv_store.hpp"
+#include "test_utils.hpp"
+#include "utils.hpp"
+
+FileMetaData make_meta(const std::string &file_name, int level, uint32_t min_key, uint32_t max_key) {
+    return FileMetaData{file_name, level, min_key, max_key, Utils::PAGE_SIZE * 3};
+}
+
+void test_replay() {
+    fs::path db_path = fs::current_path() / "tests/test_db_1";
+    fs::create_directories(db_path);
+
+    Manifest manifest;
+    assert(!manifest.open(db_path));
+
+    VersionEdit flush;
+    flush.add_file(make_meta("sst_0.dat", 0, 1, 10));
+    manifest.log_and_apply(flush);
+
+    VersionEdit compaction;
+    compaction.remove_file(0, "sst_0.dat");
+    compaction.add_file(make_meta("sst_2.dat", 1, 1, 20));
+    manifest.log_and_apply(compaction);
+
+    Manifest reopened;
+    assert(reopened.open(db_path));
+    assert(reopened.get_num_levels() == 2);
+    assert(reopened.get_files(0).empty());
+    assert(reopened.get_files(1).size() == 1);
+    const FileMetaData &meta = reopened.get_files(1)[0];
+    assert(meta.file_name == "sst_2.dat");
+    assert(meta.min_key == 1 && meta.max_key == 20);
+    assert(meta.file_size == Utils::PAGE_SIZE * 3);
+
+    std::cout << "test_replay passed!" << std::endl;
+}
+
+void test_checkpoint() {
+    fs::path db_path = fs::current_path() / "tests/test_db_2";
+    fs::create_directories(db_path);
+
+    Manifest manifest;
+    manifest.open(db_path);
+    // enough edits to trigger a checkpoint, each one replaces the previous file
+    for (int i = 0; i < Manifest::CHECKPOINT_INTERVAL + 5; i++) {
+        VersionEdit edit;
+        if (i > 0) {
+            edit.remove_file(0, "sst_" + std::to_string(i - 1) + ".dat");
+        }
+        edit.add_file(make_meta("sst_" + std::to_string(i) + ".dat", 0, i, i));
+        manifest.log_and_apply(edit);
+    }
+    // the log has been rewritten, so it is much smaller than all the edits
+    assert(fs::file_size(db_path / Manifest::FILE_NAME) < 10 * 64);
+
+    Manifest reopened;
+    reopened.open(db_path);
+    assert(reopened.get_files(0).size() == 1);
+    assert(reopened.get_files(0)[0].min_key == (uint32_t)Manifest::CHECKPOINT_INTERVAL + 4);
+
+    std::cout << "test_checkpoint passed!" << std::endl;
+}
+
+void test_torn_record() {
+    fs::path db_path = fs::current_path() / "tests/test_db_3";
+    fs::create_directories(db_path);
+
+    Manifest manifest;
+    manifest.open(db_path);
+    VersionEdit edit;
+    edit.add_file(make_meta("sst_0.dat", 0, 1, 10));
+    manifest.log_and_apply(edit);
+
+    // simulate a crash in the middle of appending the next record
+    std::ofstream log(db_path / Manifest::FILE_NAME, std::ios::binary | std::ios::app);
+    uint32_t size = 100;
+    log.write((char *)&size, sizeof(size));
+    log.write("garbage", 7);
+    log.close();
+
+    Manifest reopened;
+    assert(reopened.open(db_path));
+    assert(reopened.get_num_levels() == 1);
+    assert(reopened.get_files(0).size() == 1);
+
+    std::cout << "test_torn_record passed!" << std::endl;
+}
+
+void test_remove_orphan_files() {
+    fs::path db_path = fs::current_path() / "tests/test_db_4";
+    KVStore kvstore(2, 2, 4);
+    kvstore.open("tests/test_db_4");
+    for (int i = 1; i <= 4; i++) {
+        kvstore.put(i, i * 100);
+    }
+
+    // leftovers of a compaction that crashed before logging its edit
+    std::ofstream(db_path / "sst_5.dat") << "partial";
+    std::ofstream(db_path / "sst_5.tmp") << "partial";
+
+    KVStore kvstore2(2, 2, 4);
+    kvstore2.open("tests/test_db_4");
+    assert(!fs::exists(db_path / "sst_5.dat"));
+    assert(!fs::exists(db_path / "sst_5.tmp"));
+    assert(fs::exists(db_path / "sst_2.dat"));
+    for (int i = 1; i <= 4; i++) {
+        assert(kvstore2.get(i) == (uint32_t)i * 100);
+    }
+
+    std::cout << "test_remove_orphan_files passed!" << std::endl;
+}
+
+void test_reopen_keeps_levels() {
+    KVStore kvstore(2, 2, 4);
+    kvstore.open("tests/test_db_5");
+    for (int i = 1; i <= 14; i++) {
+        kvstore.put(i, i * 100);
+    }
+    kvstore.close();
+
+    // newer values in level 0 must still shadow older values in deeper levels after reopening
+    KVStore kvstore2(2, 2, 4);
+    kvstore2.open("tests/test_db_5");
+    kvstore2.put(1, 1);
+    kvstore2.put(2, 2);
+    kvstore2.close();
+
+    KVStore kvstore3(2, 2, 4);
+    kvstore3.open("tests/test_db_5");
+    assert(kvstore3.get(1) == 1);
+    assert(kvstore3.get(2) == 2);
+    for (int i = 3; i <= 14; i++) {
+        assert(kvstore3.get(i) == (uint32_t)i * 100);
+    }
+
+    std::cout << "test_reopen_keeps_levels passed!" << std::endl;
+}
+
+int main() {
+    Utils::clear_databases("tests", "test_db_");
+
+    test_replay();
+    test_checkpoint();
+    test_torn_record();
+    test_remove_orphan_files();
+    test_reopen_keeps_levels();
+
+    Utils::clear_databases("tests", "test_db_");
+
+    std::cout << GREEN << "All tests passed!\n" << RESET << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,145 @@
+#include "merge_operator.hpp"
+
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+#include "kv_store.hpp"
+#include "test_utils.hpp"
+#include "utils.hpp"
+#include "write_batch.hpp"
+
+void test_operators() {
+    AddOperator add;
+    MaxOperator max;
+    assert(add.merge(3, 4) == 7);
+    assert(add.merge(Utils::INVALID_VALUE, 2) == 1);
+    assert(max.merge(3, 4) == 4);
+    assert(max.merge(4, 3) == 4);
+
+    std::cout << "test_operators passed!" << std::endl;
+}
+
+void test_counters() {
+    const int num_keys = 200;
+    const int num_rounds = 10;
+    AddOperator add;
+    KVStore kvstore(64, 2, 8);
+    kvstore.set_merge_operator(&add);
+    kvstore.open("tests/test_db_1");
+    for (uint32_t key = 0; key < num_keys; key += 2) {
+        kvstore.put(key, 1000);
+    }
+    // operands end up in every level, next to the values and to each other
+    for (int round = 0; round < num_rounds; round++) {
+        for (uint32_t key = 0; key < num_keys; key++) {
+            kvstore.merge(key, key);
+        }
+    }
+    for (uint32_t key = 0; key < num_keys; key++) {
+        uint32_t expected = (key % 2 == 0 ? 1000 : 0) + key * num_rounds;
+        assert(kvstore.get(key) == expected);
+    }
+    std::vector<std::pair<uint32_t, uint32_t>> result = kvstore.scan(0, num_keys);
+    assert(result.size() == num_keys);
+    for (uint32_t key = 0; key < num_keys; key++) {
+        assert(result[key].first == key);
+        assert(result[key].second == (key % 2 == 0 ? 1000 : 0) + key * num_rounds);
+    }
+    kvstore.close();
+
+    KVStore reopened(64, 2, 8);
+    reopened.set_merge_operator(&add);
+    reopened.open("tests/test_db_1");
+    assert(reopened.get(num_keys - 1) == (num_keys - 1) * num_rounds);
+    reopened.close();
+
+    std::cout << "test_counters passed!" << std::endl;
+}
+
+void test_merge_after_delete() {
+    MaxOperator max;
+    KVStore kvstore(16, 2, 8);
+    kvstore.set_merge_operator(&max);
+    kvstore.open("tests/test_db_2");
+    kvstore.put(1, 100);
+    kvstore.put(2, 100);
+    for (uint32_t key = 100; key < 150; key++) {
+        kvstore.put(key, key);
+    }
+    // the values are in the SSTs, the deletions in the memtable or in a newer SST
+    kvstore.delete_key(1);
+    kvstore.delete_key(2);
+    for (uint32_t key = 150; key < 200; key++) {
+        kvstore.put(key, key);
+    }
+    kvstore.delete_key(2);
+    kvstore.merge(1, 5);
+    kvstore.merge(2, 7);
+    kvstore.merge(3, 9);
+    assert(kvstore.get(1) == 5);
+    assert(kvstore.get(2) == 7);
+    assert(kvstore.get(3) == 9);
+    assert(kvstore.scan(1, 3) == (std::vector<std::pair<uint32_t, uint32_t>>{{1, 5}, {2, 7}, {3, 9}}));
+
+    for (uint32_t key = 200; key < 250; key++) {
+        kvstore.put(key, key);
+    }
+    kvstore.merge(1, 3);
+    kvstore.merge(2, 8);
+    assert(kvstore.get(1) == 5);
+    assert(kvstore.get(2) == 8);
+    assert(kvstore.scan(1, 2) == (std::vector<std::pair<uint32_t, uint32_t>>{{1, 5}, {2, 8}}));
+    kvstore.close();
+
+    std::cout << "test_merge_after_delete passed!" << std::endl;
+}
+
+void test_merge_with_snapshots_and_batches() {
+    AddOperator add;
+    KVStore kvstore(16, 2, 8);
+    kvstore.set_merge_operator(&add);
+    kvstore.open("tests/test_db_3");
+    kvstore.put(1, 10);
+    const Snapshot *snapshot = kvstore.snapshot();
+
+    WriteBatch batch;
+    batch.merge(1, 1);
+    batch.merge(1, 2);
+    batch.merge(2, 5);
+    kvstore.write(batch);
+    assert(kvstore.get(1) == 13);
+    assert(kvstore.get(2) == 5);
+
+    uint32_t value;
+    assert(kvstore.get(1, &value, snapshot) && value == 10);
+    assert(!kvstore.get(2, &value, snapshot));
+    // the snapshot keeps its view after the memtable is flushed
+    for (uint32_t key = 100; key < 200; key++) {
+        kvstore.merge(key, 1);
+    }
+    assert(kvstore.get(1, &value, snapshot) && value == 10);
+    assert(kvstore.scan(1, 2, snapshot) == (std::vector<std::pair<uint32_t, uint32_t>>{{1, 10}}));
+    assert(kvstore.scan(1, 2) == (std::vector<std::pair<uint32_t, uint32_t>>{{1, 13}, {2, 5}}));
+    kvstore.release_snapshot(snapshot);
+    kvstore.close();
+
+    std::cout << "test_merge_with_snapshots_and_batches passed!" << std::endl;
+}
+
+int main() {
+    Utils::clear_databases("tests", "test_db_");
+
+    test_operators();
+    test_counters();
+    test_merge_after_delete();
+    test_merge_with_snapshots_and_batches();
+
+    Utils::clear_databases("tests", "test_db_");
+
+    std::cout << GREEN << "All tests passed!\n" << RESET << std::endl;
+
+    return 0;
+}
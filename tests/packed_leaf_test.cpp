@@ -0,0 +1,184 @@
+#include "packed_leaf.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <set>
+#include <vector>
+
+#include "btree.hpp"
+#include "kv_store.hpp"
+#include "test_utils.hpp"
+#include "utils.hpp"
+
+void test_bit_width() {
+    assert(PackedLeaf::get_bit_width(0) == 0);
+    assert(PackedLeaf::get_bit_width(1) == 1);
+    assert(PackedLeaf::get_bit_width(255) == 8);
+    assert(PackedLeaf::get_bit_width(256) == 9);
+    assert(PackedLeaf::get_bit_width(Utils::INVALID_VALUE) == 32);
+
+    // a plain leaf's worth of 32 bit keys and values always fits
+    assert(PackedLeaf::fits(BTreeNode::MAX_KEYS, 32, 32, 1));
+    assert(!PackedLeaf::fits(PackedLeaf::MAX_ENTRIES + 1, 0, 0, 0));
+    assert(!PackedLeaf::fits(2000, 16, 16, 0));
+
+    std::cout << "test_bit_width passed!" << std::endl;
+}
+
+// pack entries, then check every way of reading them back
+void check_round_trip(const std::vector<uint32_t> &keys, const std::vector<uint32_t> &values,
+                      const std::vector<EntryType> &types) {
+    std::unique_ptr<PackedLeaf> leaf = std::make_unique<PackedLeaf>();
+    leaf->pack(keys.data(), values.data(), types.data(), keys.size());
+    assert(leaf->num_keys == (int)keys.size());
+
+    std::vector<uint32_t> unpacked_keys(keys.size()), unpacked_values(keys.size());
+    std::vector<EntryType> unpacked_types(keys.size());
+    leaf->unpack(unpacked_keys.data(), unpacked_values.data(), unpacked_types.data());
+    assert(unpacked_keys == keys);
+    assert(unpacked_types == types);
+
+    for (int i = 0; i < (int)keys.size(); i++) {
+        // the values of deletions are not stored
+        if (types[i] != EntryType::DELETION) {
+            assert(unpacked_values[i] == values[i]);
+            assert(leaf->get_value(i) == values[i]);
+        }
+        assert(leaf->get_key(i) == keys[i]);
+        assert(leaf->get_type(i) == types[i]);
+        assert(leaf->lower_bound(keys[i]) == i);
+        int next = std::lower_bound(keys.begin(), keys.end(), keys[i] + 1) - keys.begin();
+        assert(leaf->lower_bound(keys[i] + 1) == next);
+    }
+    assert(leaf->lower_bound(0) == 0);
+    if (!keys.empty() && keys.back() != Utils::INVALID_VALUE) {
+        assert(leaf->lower_bound(keys.back() + 1) == (int)keys.size());
+    }
+}
+
+void test_round_trip() {
+    std::mt19937 rng(42);
+    // every bit width, with sizes that are not multiples of the SIMD width
+    for (int bits = 1; bits <= 32; bits++) {
+        uint32_t range = bits == 32 ? Utils::INVALID_VALUE : (1u << bits) - 1;
+        int num_entries = 1 + rng() % 600;
+        std::set<uint32_t> key_set;
+        while ((int)key_set.size() < num_entries) {
+            key_set.insert(1000 + rng() % (range / 2 + 1) * 2);
+            if (range < 2 * (uint32_t)num_entries) {
+                break;
+            }
+        }
+        std::vector<uint32_t> keys(key_set.begin(), key_set.end());
+        std::vector<uint32_t> values;
+        std::vector<EntryType> types;
+        for (int i = 0; i < (int)keys.size(); i++) {
+            values.push_back(rng() & range);
+            types.push_back(rng() % 4 == 0 ? EntryType::DELETION : EntryType::VALUE);
+        }
+        if (!PackedLeaf::fits(keys.size(), 32, 32, 1)) {
+            continue;
+        }
+        check_round_trip(keys, values, types);
+    }
+
+    // dense keys take a few bits each, so a page holds many more entries than a plain leaf
+    std::vector<uint32_t> keys, values;
+    for (uint32_t i = 0; i < 2000; i++) {
+        keys.push_back(500000 + i);
+        values.push_back(i % 7);
+    }
+    std::vector<EntryType> types(keys.size(), EntryType::VALUE);
+    assert(PackedLeaf::fits(keys.size(), PackedLeaf::get_bit_width(1999), PackedLeaf::get_bit_width(6), 0));
+    check_round_trip(keys, values, types);
+
+    // a deletion does not widen the values, whatever value it was added with
+    types[10] = EntryType::DELETION;
+    values[10] = Utils::INVALID_VALUE;
+    std::unique_ptr<PackedLeaf> leaf = std::make_unique<PackedLeaf>();
+    leaf->pack(keys.data(), values.data(), types.data(), keys.size());
+    assert(leaf->value_bits == PackedLeaf::get_bit_width(6));
+    assert(leaf->type_bits == 1);
+    check_round_trip(keys, values, types);
+
+    // an empty leaf
+    check_round_trip({}, {}, {});
+
+    std::cout << "test_round_trip passed!" << std::endl;
+}
+
+// writes the same entries to a db, returns the total size of its SSTs after reopening and checking it
+uintmax_t fill_db(const std::string &db_name, LeafFormat leaf_format,
+                  std::vector<std::pair<uint32_t, uint32_t>> *scan_result) {
+    KVStore kvstore(1024, 2, 8);
+    kvstore.set_leaf_format(leaf_format);
+    kvstore.set_range_filter(true);
+    kvstore.open(db_name);
+    const uint32_t num_keys = 1024 * 7;
+    for (uint32_t i = 0; i < num_keys; i++) {
+        kvstore.put(i * 3, i);
+    }
+    // deletes and updates are merged by compactions
+    for (uint32_t i = 0; i < num_keys; i += 10) {
+        kvstore.delete_key(i * 3);
+        kvstore.put(i * 3 + 1, i);
+    }
+    kvstore.close();
+
+    KVStore reopened(1024, 2, 8);
+    reopened.set_leaf_format(leaf_format);
+    reopened.open(db_name);
+    std::mt19937 rng(7);
+    for (int i = 0; i < 2000; i++) {
+        uint32_t n = rng() % num_keys;
+        if (n % 10 == 0) {
+            assert(reopened.get(n * 3) == Utils::INVALID_VALUE);
+            assert(reopened.get(n * 3 + 1) == n);
+        } else {
+            assert(reopened.get(n * 3) == n);
+            assert(reopened.get(n * 3 + 2) == Utils::INVALID_VALUE);
+        }
+    }
+    *scan_result = reopened.scan(1000, 20000);
+    std::sort(scan_result->begin(), scan_result->end());
+    reopened.close();
+
+    uintmax_t size = 0;
+    for (const auto &entry : std::filesystem::directory_iterator(db_name)) {
+        if (entry.path().filename().string().rfind("sst_", 0) == 0) {
+            size += std::filesystem::file_size(entry.path());
+        }
+    }
+    return size;
+}
+
+void test_kv_store_with_packed_leaves() {
+    std::vector<std::pair<uint32_t, uint32_t>> packed_scan, plain_scan;
+    uintmax_t packed_size = fill_db("tests/test_db_1", LeafFormat::PACKED, &packed_scan);
+    uintmax_t plain_size = fill_db("tests/test_db_2", LeafFormat::PLAIN, &plain_scan);
+    assert(packed_scan == plain_scan);
+    assert(std::find(packed_scan.begin(), packed_scan.end(), std::make_pair(1021u, 340u)) != packed_scan.end());
+    // the leaves take most of the pages of an SST
+    assert(packed_size < plain_size);
+
+    std::cout << "test_kv_store_with_packed_leaves passed!" << std::endl;
+}
+
+int main() {
+    Utils::clear_databases("tests", "test_db_");
+
+    test_bit_width();
+    test_round_trip();
+    test_kv_store_with_packed_leaves();
+
+    Utils::clear_databases("tests", "test_db_");
+
+    std::cout << GREEN << "All tests passed!\n" << RESET << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,66 @@
+#include "page_search.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <vector>
+
+#include "btree.hpp"
+#include "test_utils.hpp"
+
+const PageSearch::Kernel ALL_KERNELS[] = {PageSearch::Kernel::SCALAR, PageSearch::Kernel::AVX2,
+                                          PageSearch::Kernel::AVX512, PageSearch::Kernel::NEON};
+
+void test_kernels_match_lower_bound() {
+    std::mt19937 rng(42);
+    std::vector<uint32_t> keys(BTreeNode::MAX_KEYS + 1);
+    // every page size, including the ones that do not fill a whole vector
+    for (int n = 0; n <= BTreeNode::MAX_KEYS + 1; n++) {
+        for (int i = 0; i < n; i++) {
+            keys[i] = rng();
+        }
+        std::sort(keys.begin(), keys.begin() + n);
+        // keys of the page, keys in between, and the extremes of the key space
+        std::vector<uint32_t> targets = {0, 1, Utils::INVALID_VALUE - 1, Utils::INVALID_VALUE};
+        for (int i = 0; i < n; i++) {
+            targets.push_back(keys[i]);
+            targets.push_back(keys[i] + 1);
+        }
+        for (uint32_t key : targets) {
+            int expected = std::lower_bound(keys.begin(), keys.begin() + n, key) - keys.begin();
+            for (PageSearch::Kernel kernel : ALL_KERNELS) {
+                if (PageSearch::is_supported(kernel)) {
+                    assert(PageSearch::lower_bound(keys.data(), n, key, kernel) == expected);
+                }
+            }
+            assert(PageSearch::lower_bound(keys.data(), n, key) == expected);
+        }
+    }
+    assert(PageSearch::is_supported(PageSearch::get_active_kernel()));
+
+    std::cout << "test_kernels_match_lower_bound passed!" << std::endl;
+}
+
+void test_duplicate_keys() {
+    // internal nodes can repeat a delimiter, the first copy must be found
+    std::vector<uint32_t> keys = {1, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 5, 9};
+    for (PageSearch::Kernel kernel : ALL_KERNELS) {
+        if (PageSearch::is_supported(kernel)) {
+            assert(PageSearch::lower_bound(keys.data(), keys.size(), 5, kernel) == 1);
+            assert(PageSearch::lower_bound(keys.data(), keys.size(), 6, kernel) == (int)keys.size() - 1);
+        }
+    }
+
+    std::cout << "test_duplicate_keys passed!" << std::endl;
+}
+
+int main() {
+    test_kernels_match_lower_bound();
+    test_duplicate_keys();
+
+    std::cout << GREEN << "All tests passed!\n" << RESET << std::endl;
+
+    return 0;
+}
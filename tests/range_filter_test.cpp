@@ -0,0 +1,141 @@
+#include "range_filter.hpp"
+
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <set>
+
+#include "kv_store.hpp"
+#include "test_utils.hpp"
+#include "utils.hpp"
+
+void test_no_false_negatives() {
+    // time-bucketed keys: clusters of consecutive keys with large gaps in between
+    std::set<uint32_t> keys;
+    for (uint32_t bucket = 0; bucket < 20; bucket++) {
+        for (uint32_t i = 0; i < 10; i++) {
+            keys.insert(bucket * 100000 + i);
+        }
+    }
+    std::vector<RangeFilter> filter = RangeFilter::create_blocks(keys.size());
+    for (uint32_t key : keys) {
+        RangeFilter::insert(filter, key);
+    }
+    RangeFilter::finish(filter);
+
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<uint32_t> dist(0, 2100000);
+    for (int i = 0; i < 10000; i++) {
+        uint32_t start_key = dist(rng);
+        uint32_t end_key = start_key + dist(rng) % 1000;
+        auto it = keys.lower_bound(start_key);
+        bool has_key = it != keys.end() && *it <= end_key;
+        if (has_key) {
+            assert(RangeFilter::may_contain(filter, start_key, end_key));
+        }
+    }
+
+    std::cout << "test_no_false_negatives passed!" << std::endl;
+}
+
+void test_empty_ranges_are_filtered() {
+    std::vector<RangeFilter> filter = RangeFilter::create_blocks(100);
+    for (uint32_t i = 0; i < 100; i++) {
+        RangeFilter::insert(filter, 1000000 + i * 1000);
+    }
+    RangeFilter::finish(filter);
+
+    // outside of [min_key, max_key]
+    assert(!RangeFilter::may_contain(filter, 0, 999999));
+    assert(!RangeFilter::may_contain(filter, 2000000, 3000000));
+    assert(!RangeFilter::may_contain(filter, 10, 5));
+
+    // short ranges in the gaps between keys
+    int false_positives = 0;
+    for (uint32_t i = 0; i < 99; i++) {
+        uint32_t start_key = 1000000 + i * 1000 + 100;
+        if (RangeFilter::may_contain(filter, start_key, start_key + 50)) {
+            false_positives++;
+        }
+    }
+    assert(false_positives < 10);
+
+    std::cout << "test_empty_ranges_are_filtered passed!" << std::endl;
+}
+
+void test_clustered_keys() {
+    // every key is in one small part of the key space, with a gap after each of them
+    const uint32_t first_key = 1 << 20;
+    const uint32_t num_keys = 20000;
+    std::vector<RangeFilter> filter = RangeFilter::create_blocks(num_keys);
+    for (uint32_t i = 0; i < num_keys; i++) {
+        RangeFilter::insert(filter, first_key + i * 3);
+    }
+    RangeFilter::finish(filter);
+    assert(filter.size() > 1);
+
+    int false_positives = 0;
+    for (uint32_t i = 0; i < num_keys; i++) {
+        uint32_t key = first_key + i * 3;
+        assert(RangeFilter::may_contain(filter, key, key));
+        if (RangeFilter::may_contain(filter, key + 1, key + 2)) {
+            false_positives++;
+        }
+    }
+    // the keys are spread over all the blocks instead of filling one of them
+    assert(false_positives < (int)num_keys / 100);
+
+    std::cout << "test_clustered_keys passed!" << std::endl;
+}
+
+// page reads of short empty scans that fall in the gaps between keys
+int64_t count_empty_scan_page_reads(const std::string &db_name, bool use_range_filter) {
+    // a buffer pool that can hold the filter blocks, but not all the leaves
+    KVStore kvstore(512, 2, 16);
+    kvstore.set_range_filter(use_range_filter);
+    kvstore.open(db_name);
+
+    // time-bucketed keys: every SST covers the gaps between its keys
+    const uint32_t num_keys = 8192;
+    for (uint32_t i = 0; i < num_keys; i++) {
+        kvstore.put(i * 1000, i);
+    }
+
+    std::vector<std::pair<uint32_t, uint32_t>> result = kvstore.scan(10000, 20000);
+    assert(result.size() == 11);
+    for (unsigned int i = 0; i < 11; i++) {
+        assert(result[i].first == (i + 10) * 1000);
+    }
+
+    // the gaps are spread over all the leaves, so the buffer pool cannot absorb them
+    int64_t misses_before = kvstore.get_buffer_pool().get_num_misses();
+    for (uint32_t i = 0; i < 50; i++) {
+        uint32_t bucket = (i * 397) % num_keys;
+        assert(kvstore.scan(bucket * 1000 + 100, bucket * 1000 + 200).empty());
+    }
+    return kvstore.get_buffer_pool().get_num_misses() - misses_before;
+}
+
+void test_scan_with_range_filter() {
+    int64_t filtered_reads = count_empty_scan_page_reads("tests/test_db_1", true);
+    int64_t unfiltered_reads = count_empty_scan_page_reads("tests/test_db_2", false);
+    assert(filtered_reads < unfiltered_reads);
+
+    std::cout << "test_scan_with_range_filter passed!" << std::endl;
+}
+
+int main() {
+    Utils::clear_databases("tests", "test_db_");
+
+    test_no_false_negatives();
+    test_empty_ranges_are_filtered();
+    test_clustered_keys();
+    test_scan_with_range_filter();
+
+    Utils::clear_databases("tests", "test_db_");
+
+    std::cout << GREEN << "All tests passed!\n" << RESET << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,137 @@
+#include "range_tombstone.hpp"
+
+#include <cassert>
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+#include "kv_store.hpp"
+#include "sst_iterator.hpp"
+#include "test_utils.hpp"
+#include "utils.hpp"
+
+void test_coalesce() {
+    std::vector<RangeTombstone> coalesced =
+        RangeTombstone::coalesce({{20, 30}, {0, 5}, {25, 40}, {6, 8}, {50, 50}, {UINT32_MAX - 1, UINT32_MAX}});
+    assert(coalesced.size() == 4);
+    assert(coalesced[0].start_key == 0 && coalesced[0].end_key == 8);
+    assert(coalesced[1].start_key == 20 && coalesced[1].end_key == 40);
+    assert(coalesced[2].start_key == 50 && coalesced[2].end_key == 50);
+
+    assert(RangeTombstone::covers(coalesced, 0));
+    assert(RangeTombstone::covers(coalesced, 8));
+    assert(!RangeTombstone::covers(coalesced, 9));
+    assert(!RangeTombstone::covers(coalesced, 19));
+    assert(RangeTombstone::covers(coalesced, 33));
+    assert(RangeTombstone::covers(coalesced, 50));
+    assert(!RangeTombstone::covers(coalesced, 51));
+    assert(RangeTombstone::covers(coalesced, UINT32_MAX));
+    assert(!RangeTombstone::covers({}, 0));
+
+    std::cout << "test_coalesce passed!" << std::endl;
+}
+
+// number of entries left in the SSTs of the database
+int64_t count_sst_entries(const std::string &db_name) {
+    int64_t num_entries = 0;
+    for (const auto &entry : fs::directory_iterator(db_name)) {
+        if (entry.path().filename().string().rfind("sst_", 0) == 0) {
+            num_entries += SSTIterator(entry.path()).get_num_entries();
+        }
+    }
+    return num_entries;
+}
+
+void test_delete_range() {
+    const uint32_t num_keys = 2000;
+    KVStore kvstore(128, 2, 8);
+    kvstore.open("tests/test_db_1");
+    for (uint32_t key = 0; key < num_keys; key++) {
+        kvstore.put(key, key + 1);
+    }
+    // the range spans the SSTs and the memtable
+    kvstore.delete_range(100, 1990);
+    kvstore.put(500, 7);
+    for (uint32_t key = 0; key < num_keys; key++) {
+        bool is_deleted = 100 <= key && key <= 1990 && key != 500;
+        assert(kvstore.get(key) == (is_deleted ? Utils::INVALID_VALUE : (key == 500 ? 7 : key + 1)));
+    }
+    std::vector<std::pair<uint32_t, uint32_t>> result = kvstore.scan(0, num_keys);
+    assert(result.size() == 100 + 1 + 9);
+    assert(result[99].first == 99 && result[100] == std::make_pair(500u, 7u) && result[101].first == 1991);
+
+    // the tombstone is flushed to an SST, then compacted with the entries it covers
+    for (uint32_t key = num_keys; key < num_keys + 2000; key++) {
+        kvstore.put(key, key + 1);
+    }
+    assert(kvstore.get(1000) == Utils::INVALID_VALUE);
+    assert(kvstore.get(99) == 100);
+    assert(kvstore.scan(0, num_keys - 1).size() == 110);
+    kvstore.close();
+    // the entries the tombstone covers are gone
+    assert(count_sst_entries("tests/test_db_1") < 2 * num_keys);
+
+    KVStore reopened(128, 2, 8);
+    reopened.open("tests/test_db_1");
+    assert(reopened.get(1000) == Utils::INVALID_VALUE);
+    assert(reopened.get(1991) == 1992);
+    // the key can be written again
+    reopened.put(1000, 1);
+    assert(reopened.get(1000) == 1);
+    reopened.close();
+
+    std::cout << "test_delete_range passed!" << std::endl;
+}
+
+void test_delete_range_with_snapshots_and_merges() {
+    AddOperator add;
+    KVStore kvstore(16, 2, 8);
+    kvstore.set_merge_operator(&add);
+    kvstore.open("tests/test_db_2");
+    for (uint32_t key = 0; key < 100; key++) {
+        kvstore.put(key, 10);
+    }
+    const Snapshot *snapshot = kvstore.snapshot();
+    kvstore.delete_range(0, 49);
+    kvstore.merge(10, 1);
+    kvstore.merge(60, 1);
+
+    uint32_t value;
+    assert(kvstore.get(10, &value) && value == 1);
+    assert(!kvstore.get(11, &value));
+    assert(kvstore.get(60, &value) && value == 11);
+    assert(kvstore.get(11, &value, snapshot) && value == 10);
+    assert(kvstore.scan(0, 99).size() == 51);
+    assert(kvstore.scan(0, 99, snapshot).size() == 100);
+
+    // the same after the memtable is flushed and compacted
+    for (uint32_t key = 1000; key < 1100; key++) {
+        kvstore.put(key, 10);
+    }
+    assert(kvstore.get(10, &value) && value == 1);
+    assert(!kvstore.get(11, &value));
+    assert(kvstore.get(60, &value) && value == 11);
+    assert(kvstore.get(11, &value, snapshot) && value == 10);
+    assert(kvstore.scan(0, 99).size() == 51);
+    assert(kvstore.scan(0, 99, snapshot).size() == 100);
+    kvstore.release_snapshot(snapshot);
+    kvstore.close();
+
+    std::cout << "test_delete_range_with_snapshots_and_merges passed!" << std::endl;
+}
+
+int main() {
+    Utils::clear_databases("tests", "test_db_");
+
+    test_coalesce();
+    test_delete_range();
+    test_delete_range_with_snapshots_and_merges();
+
+    Utils::clear_databases("tests", "test_db_");
+
+    std::cout << GREEN << "All tests passed!\n" << RESET << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,90 @@
+#include "rate_limiter.hpp"
+
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+
+#include "kv_store.hpp"
+#include "test_utils.hpp"
+#include "utils.hpp"
+
+void test_request_is_throttled() {
+    // 1 MB/s, so writing 200 KB past the (initially empty) bucket has to take about 0.2s
+    RateLimiter rate_limiter(1024 * 1024);
+
+    auto start_time = std::chrono::steady_clock::now();
+    for (int i = 0; i < 50; i++) {
+        rate_limiter.request(Utils::PAGE_SIZE);
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start_time;
+
+    assert(std::chrono::duration<double>(elapsed).count() >= 0.15);
+    assert(rate_limiter.get_total_bytes_through() == 50 * Utils::PAGE_SIZE);
+    std::cout << "test_request_is_throttled passed!" << std::endl;
+}
+
+void test_reads_not_charged_by_default() {
+    RateLimiter rate_limiter(1024 * 1024);
+
+    rate_limiter.request_read(Utils::PAGE_SIZE);
+    assert(rate_limiter.get_total_bytes_through() == 0);
+
+    rate_limiter.set_charge_reads(true);
+    rate_limiter.request_read(Utils::PAGE_SIZE);
+    assert(rate_limiter.get_total_bytes_through() == Utils::PAGE_SIZE);
+    std::cout << "test_reads_not_charged_by_default passed!" << std::endl;
+}
+
+void test_auto_tune() {
+    const int64_t max_rate = 64 * 1024 * 1024;
+    RateLimiter rate_limiter(max_rate, true, 100.0);
+
+    // foreground latency above target, the limiter backs off
+    for (int i = 0; i < RateLimiter::AUTO_TUNE_INTERVAL * 4; i++) {
+        rate_limiter.record_foreground_latency(1000.0);
+    }
+    int64_t backed_off_rate = rate_limiter.get_bytes_per_sec();
+    assert(backed_off_rate < max_rate);
+    assert(backed_off_rate >= max_rate / RateLimiter::MIN_RATE_DIVISOR);
+
+    // latency recovers, the rate goes back up but never above the configured limit
+    for (int i = 0; i < RateLimiter::AUTO_TUNE_INTERVAL * 200; i++) {
+        rate_limiter.record_foreground_latency(1.0);
+    }
+    assert(rate_limiter.get_bytes_per_sec() > backed_off_rate);
+    assert(rate_limiter.get_bytes_per_sec() <= max_rate);
+    std::cout << "test_auto_tune passed!" << std::endl;
+}
+
+void test_kv_store_with_rate_limiter() {
+    RateLimiter rate_limiter(64 * 1024 * 1024);
+    KVStore kvstore(2, 2, 4);
+    kvstore.set_rate_limiter(&rate_limiter);
+    kvstore.open("tests/test_db_1");
+
+    for (int i = 1; i <= 8; i++) {
+        kvstore.put(i, i * 100);
+    }
+    // flushes and compactions went through the limiter
+    assert(rate_limiter.get_total_bytes_through() > 0);
+    for (int i = 1; i <= 8; i++) {
+        assert(kvstore.get(i) == (uint32_t)i * 100);
+    }
+    std::cout << "test_kv_store_with_rate_limiter passed!" << std::endl;
+}
+
+int main() {
+    Utils::clear_databases("tests", "test_db_");
+
+    test_request_is_throttled();
+    test_reads_not_charged_by_default();
+    test_auto_tune();
+    test_kv_store_with_rate_limiter();
+
+    Utils::clear_databases("tests", "test_db_");
+
+    std::cout << GREEN << "All tests passed!\n" << RESET << std::endl;
+
+    return 0;
+}
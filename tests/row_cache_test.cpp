@@ -0,0 +1,112 @@
+#include "row_cache.hpp"
+
+#include <cassert>
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <vector>
+
+#include "kv_store.hpp"
+#include "sst_writer.hpp"
+#include "test_utils.hpp"
+#include "utils.hpp"
+
+void test_rows() {
+    RowCache cache(2);
+    bool found;
+    uint32_t value;
+    EntryType type;
+    assert(!cache.get(1, &found, &value, &type));
+    cache.insert(1, true, 10, EntryType::VALUE, cache.get_epoch());
+    cache.insert(2, false, 0, EntryType::VALUE, cache.get_epoch());
+    assert(cache.get(1, &found, &value, &type) && found && value == 10 && type == EntryType::VALUE);
+    assert(cache.get(2, &found, &value, &type) && !found);
+    // key 1 is the least recently used
+    cache.insert(3, true, 30, EntryType::DELETION, cache.get_epoch());
+    assert(!cache.get(1, &found, &value, &type));
+    assert(cache.get(3, &found, &value, &type) && found && type == EntryType::DELETION);
+    assert(cache.get_num_hits() == 3 && cache.get_num_misses() == 2);
+
+    // a lookup that took its epoch before an invalidation does not insert its result
+    uint64_t epoch = cache.get_epoch();
+    cache.invalidate({3});
+    assert(!cache.get(3, &found, &value, &type) && cache.get_size() == 1);
+    cache.insert(3, true, 31, EntryType::VALUE, epoch);
+    assert(!cache.get(3, &found, &value, &type));
+    cache.invalidate(0, UINT32_MAX);
+    assert(cache.get_size() == 0);
+
+    cache.set_capacity(0);
+    cache.insert(3, true, 31, EntryType::VALUE, cache.get_epoch());
+    assert(!cache.get(3, &found, &value, &type) && cache.get_num_misses() == 4);
+
+    std::cout << "test_rows passed!" << std::endl;
+}
+
+void test_kv_store_with_row_cache() {
+    fs::path external_path = fs::current_path() / "tests/test_db_1_external";
+    fs::create_directories(external_path);
+    KVStore kvstore(100, 4, 16);
+    kvstore.open("tests/test_db_1");
+    kvstore.set_row_cache_capacity(50);
+    for (uint32_t key = 0; key < 1000; key++) {
+        kvstore.put(key, key);
+    }
+    kvstore.close();
+
+    // hot keys are looked up in the SSTs once, keys without a value too
+    RowCache &row_cache = kvstore.get_row_cache();
+    for (int i = 0; i < 10; i++) {
+        for (uint32_t key = 0; key < 10; key++) {
+            assert(kvstore.get(key) == key);
+        }
+        assert(kvstore.get(5000) == Utils::INVALID_VALUE);
+    }
+    assert(row_cache.get_num_misses() == 11 && row_cache.get_num_hits() == 99);
+
+    // writes are read from the memtable, then from the SST of the flush, not from the rows
+    kvstore.put(1, 100);
+    kvstore.delete_key(2);
+    kvstore.put(5000, 5000);
+    kvstore.delete_range(5, 6);
+    assert(kvstore.get(1) == 100 && kvstore.get(2) == Utils::INVALID_VALUE && kvstore.get(5000) == 5000);
+    kvstore.close();
+    assert(kvstore.get(1) == 100 && kvstore.get(2) == Utils::INVALID_VALUE && kvstore.get(5000) == 5000);
+    assert(kvstore.get(5) == Utils::INVALID_VALUE && kvstore.get(6) == Utils::INVALID_VALUE);
+    assert(kvstore.get(7) == 7);
+
+    // so are the entries of ingested files
+    {
+        SSTWriter writer(external_path / "a.dat", 10);
+        writer.put(3, 300);
+        writer.put(6000, 6000);
+        writer.finish();
+    }
+    assert(kvstore.get(6000) == Utils::INVALID_VALUE);
+    kvstore.ingest({external_path / "a.dat"});
+    assert(kvstore.get(3) == 300 && kvstore.get(6000) == 6000);
+
+    // reads through a snapshot do not use the rows
+    const Snapshot *snapshot = kvstore.snapshot();
+    int64_t num_hits = row_cache.get_num_hits();
+    uint32_t value;
+    assert(kvstore.get(3, &value, snapshot) && value == 300);
+    assert(row_cache.get_num_hits() == num_hits);
+    kvstore.release_snapshot(snapshot);
+    kvstore.close();
+
+    std::cout << "test_kv_store_with_row_cache passed!" << std::endl;
+}
+
+int main() {
+    Utils::clear_databases("tests", "test_db_");
+
+    test_rows();
+    test_kv_store_with_row_cache();
+
+    Utils::clear_databases("tests", "test_db_");
+
+    std::cout << GREEN << "All tests passed!\n" << RESET << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,136 @@
+#include "sharded_kv_store.hpp"
+
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "merge_operator.hpp"
+#include "test_utils.hpp"
+#include "utils.hpp"
+
+void set_merge_operator(ShardedKVStore *kvstore, const MergeOperator *merge_operator) {
+    for (int i = 0; i < kvstore->get_num_shards(); i++) {
+        kvstore->get_shard(i).set_merge_operator(merge_operator);
+    }
+}
+
+void test_sharding_types(ShardingType sharding_type, const std::string &db_name) {
+    const uint32_t num_keys = 10000;
+    ShardedKVStore kvstore(4, 500, 16, 64, sharding_type);
+    kvstore.open(db_name);
+    AddOperator add;
+    set_merge_operator(&kvstore, &add);
+    // keys spread over the whole key space reach every shard with range sharding too
+    const uint32_t step = UINT32_MAX / num_keys;
+    std::vector<int> keys_per_shard(kvstore.get_num_shards());
+    for (uint32_t i = 0; i < num_keys; i++) {
+        kvstore.put(i * step, i);
+        keys_per_shard[kvstore.get_shard_index(i * step)]++;
+    }
+    for (int count : keys_per_shard) {
+        assert(count > (int)num_keys / 8);
+    }
+
+    for (uint32_t i = 0; i < num_keys; i++) {
+        assert(kvstore.get(i * step) == i);
+    }
+    assert(kvstore.get(1) == Utils::INVALID_VALUE);
+    kvstore.delete_key(0);
+    kvstore.merge(step, 10);
+    assert(kvstore.get(0) == Utils::INVALID_VALUE && kvstore.get(step) == 11);
+
+    // the scan is in key order whatever shards its keys are in
+    std::vector<std::pair<uint32_t, uint32_t>> result = kvstore.scan(0, UINT32_MAX);
+    assert(result.size() == num_keys - 1);
+    for (uint32_t i = 1; i < num_keys; i++) {
+        assert(result[i - 1] == std::make_pair(i * step, i == 1 ? 11 : i));
+    }
+    // a range that spans two shards of the range sharding
+    uint32_t start_key = (num_keys / 4 - 10) * step;
+    uint32_t end_key = (num_keys / 4 + 9) * step;
+    assert(kvstore.scan(start_key, end_key).size() == 20);
+    kvstore.delete_range(start_key, end_key);
+    assert(kvstore.scan(start_key, end_key).empty());
+    assert(kvstore.scan(0, UINT32_MAX).size() == num_keys - 21);
+
+    WriteBatch batch;
+    batch.put(1, 1);
+    batch.put(UINT32_MAX, 2);
+    batch.delete_key(step * 2);
+    kvstore.write(batch);
+    assert(kvstore.get(1) == 1 && kvstore.get(UINT32_MAX) == 2 && kvstore.get(step * 2) == Utils::INVALID_VALUE);
+    kvstore.close();
+
+    ShardedKVStore reopened(4, 500, 16, 64, sharding_type);
+    reopened.open(db_name);
+    set_merge_operator(&reopened, &add);
+    assert(reopened.get(step * 3) == 3);
+    assert(reopened.scan(0, UINT32_MAX).size() == num_keys - 21 + 2 - 1);
+    reopened.close();
+
+    // the keys would be looked up in the wrong shards
+    ShardedKVStore wrong_shards(2, 500, 16, 64, sharding_type);
+    bool failed = false;
+    try {
+        wrong_shards.open(db_name);
+    } catch (const std::runtime_error &) {
+        failed = true;
+    }
+    assert(failed);
+}
+
+void test_hash_sharding() {
+    test_sharding_types(ShardingType::HASH, "tests/test_db_1");
+    std::cout << "test_hash_sharding passed!" << std::endl;
+}
+
+void test_range_sharding() {
+    test_sharding_types(ShardingType::RANGE, "tests/test_db_2");
+    std::cout << "test_range_sharding passed!" << std::endl;
+}
+
+void test_concurrent_writers() {
+    ShardedKVStore kvstore(4, 256, 16, 64);
+    kvstore.open("tests/test_db_3");
+    const int num_threads = 4;
+    const uint32_t keys_per_thread = 5000;
+
+    std::vector<std::thread> threads;
+    for (int thread = 0; thread < num_threads; thread++) {
+        threads.emplace_back([&kvstore, thread]() {
+            for (uint32_t key = thread * keys_per_thread; key < (thread + 1) * keys_per_thread; key++) {
+                kvstore.put(key, key * 2);
+            }
+        });
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+
+    uint32_t num_keys = num_threads * keys_per_thread;
+    for (uint32_t key = 0; key < num_keys; key++) {
+        assert(kvstore.get(key) == key * 2);
+    }
+    assert(kvstore.scan(0, num_keys).size() == num_keys);
+    kvstore.close();
+
+    std::cout << "test_concurrent_writers passed!" << std::endl;
+}
+
+int main() {
+    Utils::clear_databases("tests", "test_db_");
+
+    test_hash_sharding();
+    test_range_sharding();
+    test_concurrent_writers();
+
+    Utils::clear_databases("tests", "test_db_");
+
+    std::cout << GREEN << "All tests passed!\n" << RESET << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,138 @@
+#include "sst_writer.hpp"
+
+#include <cassert>
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "btree.hpp"
+#include "buffer_pool.hpp"
+#include "kv_store.hpp"
+#include "sst_iterator.hpp"
+#include "test_utils.hpp"
+#include "utils.hpp"
+
+void test_sst_writer() {
+    fs::path dir_path = fs::current_path() / "tests/test_db_1";
+    fs::create_directories(dir_path);
+    fs::path sst_path = dir_path / "external.dat";
+    {
+        SSTWriter writer(sst_path, 1000);
+        for (uint32_t key = 0; key < 1000; key++) {
+            if (key % 10 == 0) {
+                writer.delete_key(key);
+            } else {
+                writer.put(key, key * 2);
+            }
+        }
+        bool failed = false;
+        try {
+            writer.put(999, 0);
+        } catch (const std::runtime_error &) {
+            failed = true;
+        }
+        assert(failed);
+        writer.finish();
+        assert(writer.get_num_entries() == 1000);
+    }
+
+    // the store's readers read it
+    BufferPool buffer_pool(2, 8);
+    uint32_t value;
+    EntryType type;
+    assert(BTreeNode::search_value_by_key(7, sst_path, &buffer_pool, &value, &type));
+    assert(value == 14 && type == EntryType::VALUE);
+    assert(BTreeNode::search_value_by_key(10, sst_path, &buffer_pool, &value, &type));
+    assert(type == EntryType::DELETION);
+    assert(!BTreeNode::search_value_by_key(1000, sst_path, &buffer_pool, &value, &type));
+
+    std::cout << "test_sst_writer passed!" << std::endl;
+}
+
+// level of the SST of the store whose first key is the given one, -1 if there is none
+int find_level_of_sst(const std::string &db_name, uint32_t first_key) {
+    for (const auto &entry : fs::directory_iterator(db_name)) {
+        std::string file_name = entry.path().filename().string();
+        if (file_name.rfind("sst_", 0) == 0 && entry.path().extension() == ".dat") {
+            SSTIterator iterator(entry.path());
+            if (iterator.valid() && iterator.key() == first_key) {
+                return std::stoi(file_name.substr(4)) / 2;
+            }
+        }
+    }
+    return -1;
+}
+
+void test_ingest() {
+    fs::path external_path = fs::current_path() / "tests/test_db_2_external";
+    fs::create_directories(external_path);
+    KVStore kvstore(64, 2, 8);
+    kvstore.open("tests/test_db_2");
+    for (uint32_t key = 0; key < 1000; key++) {
+        kvstore.put(key, key);
+    }
+    // the last keys are still in the memtable
+    kvstore.put(550, 1);
+
+    // no newer data overlaps it, so it skips the shallow levels
+    {
+        SSTWriter writer(external_path / "a.dat", 500);
+        for (uint32_t key = 5000; key < 5500; key++) {
+            writer.put(key, key + 1);
+        }
+        writer.finish();
+    }
+    // it overwrites and deletes keys of the SSTs and of the memtable
+    {
+        SSTWriter writer(external_path / "b.dat", 100);
+        for (uint32_t key = 500; key < 600; key++) {
+            writer.put(key, key + 1);
+        }
+        writer.delete_range(900, 999);
+        writer.finish();
+    }
+    kvstore.ingest({external_path / "a.dat"});
+    assert(!fs::exists(external_path / "a.dat"));
+    assert(find_level_of_sst("tests/test_db_2", 5000) > 0);
+    kvstore.ingest({external_path / "b.dat"}, false);
+    assert(fs::exists(external_path / "b.dat"));
+
+    for (uint32_t key = 0; key < 1000; key++) {
+        uint32_t expected = 500 <= key && key < 600 ? key + 1 : key < 900 ? key : Utils::INVALID_VALUE;
+        assert(kvstore.get(key) == expected);
+    }
+    assert(kvstore.get(5100) == 5101);
+    assert(kvstore.scan(0, 10000).size() == 900 + 500);
+
+    // later writes are newer than the ingested files, through flushes and compactions
+    for (uint32_t key = 590; key < 2000; key++) {
+        kvstore.put(key, 7);
+    }
+    kvstore.close();
+
+    KVStore reopened(64, 2, 8);
+    reopened.open("tests/test_db_2");
+    assert(reopened.get(589) == 590);
+    assert(reopened.get(590) == 7);
+    assert(reopened.get(950) == 7);
+    assert(reopened.get(5499) == 5500);
+    reopened.close();
+
+    std::cout << "test_ingest passed!" << std::endl;
+}
+
+int main() {
+    Utils::clear_databases("tests", "test_db_");
+
+    test_sst_writer();
+    test_ingest();
+
+    Utils::clear_databases("tests", "test_db_");
+
+    std::cout << GREEN << "All tests passed!\n" << RESET << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,64 @@
+#include "tiny_lfu.hpp"
+
+#include <cassert>
+#include <iostream>
+#include <string>
+
+#include "test_utils.hpp"
+
+void test_estimate() {
+    TinyLFU sketch(100);
+    for (int i = 0; i < 100; i++) {
+        for (int j = 0; j <= i % 10; j++) {
+            sketch.record("page" + std::to_string(i));
+        }
+    }
+    // a count-min sketch may overestimate (on collisions) but never underestimates
+    for (int i = 0; i < 100; i++) {
+        assert(sketch.estimate("page" + std::to_string(i)) >= i % 10 + 1);
+    }
+    int num_exact = 0;
+    for (int i = 0; i < 100; i++) {
+        num_exact += sketch.estimate("page" + std::to_string(i)) == i % 10 + 1;
+    }
+    assert(num_exact > 90);
+    assert(sketch.estimate("never") <= 1);
+
+    // counters saturate
+    for (int i = 0; i < 100; i++) {
+        sketch.record("hot");
+    }
+    assert(sketch.estimate("hot") == TinyLFU::MAX_COUNT);
+
+    std::cout << "test_estimate passed!" << std::endl;
+}
+
+void test_admit_and_age() {
+    TinyLFU sketch(10);
+    for (int i = 0; i < 8; i++) {
+        sketch.record("hot");
+    }
+    sketch.record("cold");
+    assert(sketch.admit("hot", "cold"));
+    assert(!sketch.admit("cold", "hot"));
+    // ties keep the victim
+    assert(!sketch.admit("cold", "cold"));
+
+    // after a sample of accesses, the frequencies are halved
+    for (int i = 9; i < sketch.get_sample_size(); i++) {
+        sketch.record("hot");
+    }
+    assert(sketch.estimate("hot") == TinyLFU::MAX_COUNT / 2);
+    assert(sketch.estimate("cold") == 0);
+
+    std::cout << "test_admit_and_age passed!" << std::endl;
+}
+
+int main() {
+    test_estimate();
+    test_admit_and_age();
+
+    std::cout << GREEN << "All tests passed!\n" << RESET << std::endl;
+
+    return 0;
+}
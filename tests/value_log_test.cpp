@@ -0,0 +1,154 @@
+#include "value_log.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "kv_store.hpp"
+#include "test_utils.hpp"
+#include "utils.hpp"
+
+std::string make_blob(uint32_t key, int version, int size) {
+    std::string blob(size, 'a' + key % 26);
+    blob.replace(0, std::to_string(version).size(), std::to_string(version));
+    return blob;
+}
+
+void test_append_and_read() {
+    fs::path db_path = fs::current_path() / "tests/test_db_1";
+    fs::create_directories(db_path);
+
+    ValueLog value_log;
+    value_log.open(db_path);
+    value_log.set_segment_size(1000);
+    std::vector<uint32_t> pointers;
+    for (uint32_t key = 0; key < 20; key++) {
+        pointers.push_back(value_log.append(key, make_blob(key, 0, key * 10)));
+    }
+    // records are appended to a new segment once the last one is full
+    assert(value_log.get_num_segments() > 1);
+
+    ValueLog reopened;
+    reopened.open(db_path);
+    assert(reopened.get_size() == value_log.get_size());
+    for (uint32_t key = 0; key < 20; key++) {
+        uint32_t record_key;
+        std::string value;
+        assert(reopened.read(pointers[key], &record_key, &value));
+        assert(record_key == key && value == make_blob(key, 0, key * 10));
+    }
+
+    std::vector<ValueLog::Record> records;
+    reopened.read_oldest_segment(&records);
+    assert(!records.empty() && records[0].key == 0 && records[0].pointer == pointers[0]);
+    int64_t size = reopened.get_size();
+    assert(reopened.remove_oldest_segment() > 0);
+    assert(reopened.get_size() < size);
+    uint32_t record_key;
+    std::string value;
+    assert(!reopened.read(pointers[0], &record_key, &value));
+    assert(reopened.read(pointers[19], &record_key, &value));
+
+    // the end of a torn record is skipped, the next one starts aligned
+    uint32_t head_pointer = 0;
+    for (const auto &entry : fs::directory_iterator(db_path)) {
+        head_pointer = std::max(head_pointer, (uint32_t)std::stoul(entry.path().stem().string()));
+    }
+    std::ofstream(db_path / (std::to_string(head_pointer) + ValueLog::EXTENSION), std::ios::binary | std::ios::app)
+        << "torn";
+    ValueLog recovered;
+    recovered.open(db_path);
+    uint32_t pointer = recovered.append(100, "after the crash");
+    assert(recovered.read(pointer, &record_key, &value) && value == "after the crash");
+    assert(recovered.read(pointers[19], &record_key, &value) && record_key == 19);
+
+    std::cout << "test_append_and_read passed!" << std::endl;
+}
+
+int64_t get_sst_size(const std::string &db_name) {
+    int64_t size = 0;
+    for (const auto &entry : fs::directory_iterator(db_name)) {
+        if (entry.path().filename().string().rfind("sst_", 0) == 0) {
+            size += fs::file_size(entry.path());
+        }
+    }
+    return size;
+}
+
+void test_kv_store_with_blobs() {
+    const int num_keys = 2000;
+    const int blob_size = 1000;
+    KVStore kvstore(256, 2, 8);
+    kvstore.set_value_log_segment_size(256 * 1024);
+    kvstore.open("tests/test_db_2");
+    for (uint32_t key = 0; key < num_keys; key++) {
+        kvstore.put_blob(key, make_blob(key, 0, blob_size));
+    }
+    // 32-bit values and blobs side by side
+    kvstore.put(num_keys, 7);
+    // flushes and compactions only move the pointers to the blobs
+    assert(get_sst_size("tests/test_db_2") * 10 < (int64_t)num_keys * blob_size);
+
+    // overwrite and delete half of the blobs, which leaves their first records dead
+    for (uint32_t key = 0; key < num_keys; key += 2) {
+        if (key % 4 == 0) {
+            kvstore.put_blob(key, make_blob(key, 1, blob_size / 2));
+        } else {
+            kvstore.delete_key(key);
+        }
+    }
+    std::string blob;
+    uint32_t value;
+    assert(kvstore.get_blob(4, &blob) && blob == make_blob(4, 1, blob_size / 2));
+    assert(!kvstore.get_blob(2, &blob));
+    assert(!kvstore.get(5, &value));
+    assert(!kvstore.get_blob(num_keys, &blob));
+    assert(kvstore.get(num_keys) == 7);
+    kvstore.close();
+
+    KVStore reopened(256, 2, 8);
+    reopened.set_value_log_segment_size(256 * 1024);
+    reopened.open("tests/test_db_2");
+    ValueLog &value_log = reopened.get_value_log();
+    int64_t size = value_log.get_size();
+    int64_t reclaimed = 0;
+    // every file but the head
+    for (int i = value_log.get_num_segments(); i > 1; i--) {
+        reclaimed += reopened.collect_value_log_garbage();
+    }
+    // the dead records are gone, the live ones were moved to the head
+    assert(reclaimed > 0);
+    assert(value_log.get_size() < size * 3 / 4);
+    for (uint32_t key = 0; key < num_keys; key++) {
+        bool found = reopened.get_blob(key, &blob);
+        if (key % 4 == 0) {
+            assert(found && blob == make_blob(key, 1, blob_size / 2));
+        } else if (key % 2 == 0) {
+            assert(!found);
+        } else {
+            assert(found && blob == make_blob(key, 0, blob_size));
+        }
+    }
+    assert(reopened.scan(0, num_keys) == (std::vector<std::pair<uint32_t, uint32_t>>{{num_keys, 7}}));
+    reopened.close();
+
+    std::cout << "test_kv_store_with_blobs passed!" << std::endl;
+}
+
+int main() {
+    Utils::clear_databases("tests", "test_db_");
+
+    test_append_and_read();
+    test_kv_store_with_blobs();
+
+    Utils::clear_databases("tests", "test_db_");
+
+    std::cout << GREEN << "All tests passed!\n" << RESET << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,115 @@
+#include "write_batch.hpp"
+
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "kv_store.hpp"
+#include "test_utils.hpp"
+#include "utils.hpp"
+
+void test_write_batch() {
+    KVStore kvstore(16, 2, 8);
+    kvstore.open("tests/test_db_1");
+    kvstore.put(1, 100);
+
+    WriteBatch batch;
+    batch.put(2, 200);
+    batch.put(3, 300);
+    batch.delete_key(1);
+    // later operations on a key win
+    batch.put(3, 301);
+    batch.delete_key(2);
+    batch.put(2, 201);
+    assert(batch.get_num_operations() == 6);
+    kvstore.write(batch);
+
+    assert(kvstore.get(1) == Utils::INVALID_VALUE);
+    assert(kvstore.get(2) == 201);
+    assert(kvstore.get(3) == 301);
+
+    batch.clear();
+    assert(batch.get_num_operations() == 0);
+    kvstore.write(batch);
+    kvstore.close();
+
+    std::cout << "test_write_batch passed!" << std::endl;
+}
+
+void test_batch_is_atomic() {
+    KVStore kvstore(16, 2, 8);
+    kvstore.open("tests/test_db_2");
+    const Snapshot *before = kvstore.snapshot();
+
+    // larger than the memtable, but not split by a flush
+    WriteBatch batch;
+    for (uint32_t key = 0; key < 100; key++) {
+        batch.put(key, key + 1);
+    }
+    kvstore.write(batch);
+    const Snapshot *after = kvstore.snapshot();
+    kvstore.put(1000, 1);
+
+    uint32_t value;
+    for (uint32_t key = 0; key < 100; key++) {
+        assert(!kvstore.get(key, &value, before));
+        assert(kvstore.get(key, &value, after) && value == key + 1);
+    }
+    assert(kvstore.scan(0, 99, after).size() == 100);
+    kvstore.release_snapshot(before);
+    kvstore.release_snapshot(after);
+    kvstore.close();
+
+    std::cout << "test_batch_is_atomic passed!" << std::endl;
+}
+
+void test_concurrent_writers() {
+    KVStore kvstore(256, 2, 8);
+    kvstore.open("tests/test_db_3");
+    const int num_threads = 8;
+    const int num_batches = 200;
+    const int batch_size = 10;
+
+    std::vector<std::thread> threads;
+    for (int thread = 0; thread < num_threads; thread++) {
+        threads.emplace_back([&kvstore, thread]() {
+            WriteBatch batch;
+            for (int i = 0; i < num_batches; i++) {
+                batch.clear();
+                for (int j = 0; j < batch_size; j++) {
+                    uint32_t key = (thread * num_batches + i) * batch_size + j;
+                    batch.put(key, key * 2);
+                }
+                kvstore.write(batch);
+            }
+        });
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+
+    uint32_t num_keys = num_threads * num_batches * batch_size;
+    for (uint32_t key = 0; key < num_keys; key++) {
+        assert(kvstore.get(key) == key * 2);
+    }
+    assert(kvstore.scan(0, num_keys).size() == num_keys);
+    kvstore.close();
+
+    std::cout << "test_concurrent_writers passed!" << std::endl;
+}
+
+int main() {
+    Utils::clear_databases("tests", "test_db_");
+
+    test_write_batch();
+    test_batch_is_atomic();
+    test_concurrent_writers();
+
+    Utils::clear_databases("tests", "test_db_");
+
+    std::cout << GREEN << "All tests passed!\n" << RESET << std::endl;
+
+    return 0;
+}